@@ -0,0 +1,88 @@
+#include "activity.hpp"
+#include "map.hpp"
+
+#include "bklib/assert.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::activity_regions::set_radius(int const radius) noexcept
+{
+    BK_PRECONDITION(radius >= 0);
+    radius_ = radius;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::activity_regions::begin_turn(bklib::ipoint2 const p)
+{
+    begin_turn();
+    sources_.push_back(source_t {to_block_(p), radius_});
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::activity_regions::begin_turn()
+{
+    sources_.swap(noises_);
+    noises_.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::activity_regions::make_noise(bklib::ipoint2 const p, int const radius)
+{
+    BK_PRECONDITION(radius >= 0);
+
+    auto const b = to_block_(p);
+
+    // the same block tends to be noisy several times in a turn
+    auto const it = std::find_if(begin(noises_), end(noises_), [&](source_t const& s) noexcept {
+        return s.block == b;
+    });
+
+    if (it == end(noises_)) {
+        noises_.push_back(source_t {b, radius});
+    } else {
+        it->radius = std::max(it->radius, radius);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::activity_regions::is_active(bklib::ipoint2 const p) const noexcept
+{
+    if (!is_limited()) {
+        return true;
+    }
+
+    auto const b = to_block_(p);
+
+    return std::any_of(begin(sources_), end(sources_), [&](source_t const& s) noexcept {
+        return std::abs(x(b) - x(s.block)) <= s.radius
+            && std::abs(y(b) - y(s.block)) <= s.radius;
+    });
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::activity_regions::sleep(
+    creature_handle const h
+  , bklib::ipoint2  const p
+  , game_time       const when
+) {
+    auto const b = to_block_(p);
+    dormant_[key_(x(b), y(b))].push_back(entry_t {h, when});
+    ++dormant_count_;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::activity_regions::clear() noexcept
+{
+    sources_.clear();
+    noises_.clear();
+    dormant_.clear();
+    dormant_count_ = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+bklib::ipoint2 bkrl::activity_regions::to_block_(bklib::ipoint2 const p) noexcept
+{
+    return bklib::ipoint2 {block_of(x(p)), block_of(y(p))};
+}
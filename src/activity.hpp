@@ -0,0 +1,128 @@
+#pragma once
+
+#include "creature.hpp"
+
+#include "bklib/math.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace bkrl {
+
+//--------------------------------------------------------------------------------------------------
+//! Which parts of a map are simulated, at the granularity of blocks (see size_block). A block is
+//! active if it is within radius() blocks (Chebyshev distance) of the player's block, or within the
+//! radius of a noise made during the previous turn. Creatures that come up to act outside of the
+//! active blocks are put to sleep rather than scheduled again, and cost nothing until their block
+//! becomes active.
+//!
+//! Dormant entries can go stale in the same way as turn_scheduler's (see there).
+//--------------------------------------------------------------------------------------------------
+class activity_regions {
+public:
+    //! A radius of 0, the default, makes every block active.
+    void set_radius(int radius) noexcept;
+
+    int radius() const noexcept {
+        return radius_;
+    }
+
+    bool is_limited() const noexcept {
+        return radius_ > 0;
+    }
+
+    //! Start a turn with the player at @p p; the noises made during the previous turn become the
+    //! other sources for this one.
+    void begin_turn(bklib::ipoint2 p);
+
+    //! As above, but with only noises as sources.
+    void begin_turn();
+
+    //! Make the blocks within @p radius blocks of @p p active for the next turn.
+    void make_noise(bklib::ipoint2 p, int radius);
+
+    bool is_active(bklib::ipoint2 p) const noexcept;
+
+    //! Put @p h, at @p p, to sleep as of @p when.
+    void sleep(creature_handle h, bklib::ipoint2 p, game_time when);
+
+    //! Call f(creature_handle, game_time since) for each dormant creature in a block that is now
+    //! active, and forget about it. Only the blocks around the sources are looked at.
+    template <typename Function>
+    void wake(Function&& f) {
+        if (dormant_.empty()) {
+            return;
+        }
+
+        if (!is_limited()) {
+            auto const all = std::move(dormant_);
+            dormant_.clear();
+            dormant_count_ = 0;
+
+            for (auto const& block : all) {
+                for (auto const& e : block.second) {
+                    f(e.who, e.since);
+                }
+            }
+
+            return;
+        }
+
+        for (auto const& s : sources_) {
+            auto const sx = x(s.block);
+            auto const sy = y(s.block);
+
+            for (auto by = sy - s.radius; by <= sy + s.radius; ++by) {
+                for (auto bx = sx - s.radius; bx <= sx + s.radius; ++bx) {
+                    auto const it = dormant_.find(key_(bx, by));
+                    if (it == std::end(dormant_)) {
+                        continue;
+                    }
+
+                    auto const sleepers = std::move(it->second);
+                    dormant_.erase(it);
+                    dormant_count_ -= sleepers.size();
+
+                    for (auto const& e : sleepers) {
+                        f(e.who, e.since);
+                    }
+                }
+            }
+        }
+    }
+
+    //! The number of dormant creatures, including any stale entries.
+    size_t dormant_count() const noexcept {
+        return dormant_count_;
+    }
+
+    void clear() noexcept;
+private:
+    struct entry_t {
+        creature_handle who;
+        game_time       since;
+    };
+
+    struct source_t {
+        bklib::ipoint2 block;
+        int            radius;
+    };
+
+    //! The block containing @p p.
+    static bklib::ipoint2 to_block_(bklib::ipoint2 p) noexcept;
+
+    static uint64_t key_(int const bx, int const by) noexcept {
+        return bklib::grid_key(bx, by);
+    }
+
+    std::vector<source_t> sources_; //!< this turn's sources
+    std::vector<source_t> noises_;  //!< the noises made during this turn
+
+    std::unordered_map<uint64_t, std::vector<entry_t>> dormant_; //!< keyed on block
+    size_t dormant_count_ = 0;
+
+    int radius_ = 0;
+};
+
+} //namespace bkrl
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "bklib/assert.hpp"
+
+#include <vector>
+#include <type_traits>
+#include <cstring>
+#include <cstddef>
+
+namespace bklib {
+
+//--------------------------------------------------------------------------------------------------
+//! Appends trivially copyable values, as their raw bytes, to a buffer. For data that is only ever
+//! read back by the same build of the program (see byte_reader); there is no versioning and no
+//! byte order conversion.
+//--------------------------------------------------------------------------------------------------
+class byte_writer {
+public:
+    explicit byte_writer(std::vector<char>& out) noexcept
+      : out_ (out)
+    {
+    }
+
+    template <typename T>
+    void write(T const& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+
+        auto const first = reinterpret_cast<char const*>(&value);
+        out_.insert(std::end(out_), first, first + sizeof(T));
+    }
+private:
+    std::vector<char>& out_;
+};
+
+//--------------------------------------------------------------------------------------------------
+//! Reads values back, in the order they were written by a byte_writer.
+//--------------------------------------------------------------------------------------------------
+class byte_reader {
+public:
+    byte_reader(char const* const first, char const* const last) noexcept
+      : pos_  {first}
+      , last_ {last}
+    {
+    }
+
+    //! @pre at least sizeof(T) bytes remain.
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+        BK_PRECONDITION(static_cast<size_t>(last_ - pos_) >= sizeof(T));
+
+        T result;
+        std::memcpy(&result, pos_, sizeof(T));
+        pos_ += sizeof(T);
+
+        return result;
+    }
+
+    bool empty() const noexcept {
+        return pos_ == last_;
+    }
+private:
+    char const* pos_;
+    char const* last_;
+};
+
+} //namespace bklib
@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <cmath>
 #include <cstring>
+#include <cstdint>
 
 namespace bklib {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -119,6 +120,33 @@ inline constexpr T clamp_to(U const n) noexcept {
     ));
 }
 
+//--------------------------------------------------------------------------------------------------
+//! floor(n / d) for both positive and negative n; e.g. the index of the block of d cells that
+//! cell n falls in.
+//! @pre d > 0
+//--------------------------------------------------------------------------------------------------
+template <typename T>
+inline constexpr T floor_div(T const n, T const d) noexcept {
+    static_assert(std::is_integral<T>::value, "");
+    return (n < 0 ? n - (d - 1) : n) / d;
+}
+
+//--------------------------------------------------------------------------------------------------
+//! A 64 bit key for the grid position (x, y), e.g. of a block; for hashing sparse grids.
+//! grid_key_x and grid_key_y give back the position.
+//--------------------------------------------------------------------------------------------------
+inline constexpr uint64_t grid_key(int32_t const x, int32_t const y) noexcept {
+    return (uint64_t {static_cast<uint32_t>(x)} << 32) | uint64_t {static_cast<uint32_t>(y)};
+}
+
+inline constexpr int32_t grid_key_x(uint64_t const key) noexcept {
+    return static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+}
+
+inline constexpr int32_t grid_key_y(uint64_t const key) noexcept {
+    return static_cast<int32_t>(static_cast<uint32_t>(key));
+}
+
 //--------------------------------------------------------------------------------------------------
 //!
 //--------------------------------------------------------------------------------------------------
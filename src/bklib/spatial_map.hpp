@@ -3,110 +3,207 @@
 #include "bklib/math.hpp"
 #include "bklib/assert.hpp"
 #include "bklib/algorithm.hpp"
+#include "bklib/utility.hpp"
 
+#include <unordered_map>
 #include <vector>
+#include <memory>
 #include <iterator>
 #include <algorithm>
+#include <type_traits>
+#include <cstdlib>
+#include <utility>
+#include <tuple>
+#include <cstdint>
 
 namespace bklib {
 
+template <typename T> class spatial_map_2d;
+
+//--------------------------------------------------------------------------------------------------
+//! Generational handle to a value stored in a spatial_map_2d<T>.
+//! The low 20 bits are the slot index; the high 12 bits are the generation of the slot. A value of
+//! 0 is never a valid handle.
+//--------------------------------------------------------------------------------------------------
+template <typename T>
+using spatial_map_handle = tagged_value<spatial_map_2d<T>, uint32_t>;
+
 //--------------------------------------------------------------------------------------------------
 //! 2D spatial index
+//! Entries are bucketed by the block_size x block_size block they lie in; point lookups hash the
+//! block and then scan the (small) bucket for that block.
+//!
+//! Values live in a slot map: removed slots are tombstoned and reused through a free list, so the
+//! address of a value is stable until the value itself is removed.
 //--------------------------------------------------------------------------------------------------
 template <typename T>
 class spatial_map_2d {
 public:
-    using point_t = bklib::ipoint2;
-    using rect_t  = bklib::irect;
+    using point_t  = bklib::ipoint2;
+    using rect_t   = bklib::irect;
+    using handle_t = spatial_map_handle<T>;
+
+    //! Width and height of the blocks used for bucketing; matches the map's block_t.
+    static constexpr int block_size = 16;
+
+    spatial_map_2d() = default;
+    spatial_map_2d(spatial_map_2d const&) = delete;
+    spatial_map_2d& operator=(spatial_map_2d const&) = delete;
+
+    spatial_map_2d(spatial_map_2d&& other) noexcept {
+        swap_(other);
+    }
+
+    spatial_map_2d& operator=(spatial_map_2d&& rhs) noexcept {
+        spatial_map_2d {std::move(rhs)}.swap_(*this);
+        return *this;
+    }
+
+    ~spatial_map_2d() {
+        for (uint32_t i = 0; i < slot_count_; ++i) {
+            auto& s = slot_(i);
+            if (s.live) {
+                s.value().~T();
+            }
+        }
+    }
 
     //----------------------------------------------------------------------------------------------
     //! @pre @p data isn't already in the map
     //----------------------------------------------------------------------------------------------
     T& insert(point_t p, T&& data) {
-        auto const i = static_cast<int>(data_.size());
-        data_.emplace_back(std::move(data));
+        auto const i = construct_(p, std::move(data));
+        blocks_[block_key_(p)].push_back(entry_t {p, i});
 
-        sorted_.emplace_back(std::make_pair(std::move(p), i));
-        sort_();
+        return slot_(i).value();
+    }
 
-        return data_.back();
+    //----------------------------------------------------------------------------------------------
+    //! Insert each (point, value) pair in [@p first, @p last); the values are moved from.
+    //! Storage for the slots and the block table is reserved up front (for forward iterators), and
+    //! runs of values in the same block share a single bucket lookup.
+    //! @pre none of the values are already in the map
+    //----------------------------------------------------------------------------------------------
+    template <typename InputIt>
+    void bulk_insert(InputIt first, InputIt const last) {
+        reserve_(first, last, typename std::iterator_traits<InputIt>::iterator_category {});
+
+        bucket_t* bucket = nullptr;
+        auto      key    = uint64_t {};
+
+        for (; first != last; ++first) {
+            auto&& pair = *first;
+            auto const p = std::get<0>(pair);
+            auto const i = construct_(p, std::move(std::get<1>(pair)));
+
+            auto const k = block_key_(p);
+            if (!bucket || k != key) {
+                bucket = std::addressof(blocks_[k]);
+                key    = k;
+            }
+
+            bucket->push_back(entry_t {p, i});
+        }
     }
 
     //----------------------------------------------------------------------------------------------
-    //!
+    //! Move @p data from @p from to @p to; only the buckets for the two blocks are touched.
+    //! @return false if @p data isn't at @p from; true otherwise.
     //----------------------------------------------------------------------------------------------
     bool relocate(point_t const from, point_t const to, T const& data) {
         if (from == to) {
             return true;
         }
 
-        auto const last = end(sorted_);
-        auto const first = begin(sorted_);
-        auto const it = std::find_if(first, last, [&](std::pair<point_t, int> const pair) {
-            return (pair.first == from) && (get_data_at_(pair) == std::addressof(data));
+        auto const block = blocks_.find(block_key_(from));
+        if (block == std::end(blocks_)) {
+            return false;
+        }
+
+        auto& bucket = block->second;
+        auto const it = bklib::find_if(bucket, [&](entry_t const& e) {
+            return (e.p == from) && (std::addressof(slot_(e.slot).value()) == std::addressof(data));
         });
 
-        if (it == last) {
+        if (it == std::end(bucket)) {
             return false;
         }
 
-        it->first = to;
+        relocate_(block, it, to);
+        return true;
+    }
 
-        if (it != first && std::next(it, -1)->first < to) {
-            auto const next = std::next(it, 1);
-            if (next != last && to < next->first) {
-                return true;
-            }
+    //----------------------------------------------------------------------------------------------
+    //! @return false if @p h is stale; true otherwise.
+    //----------------------------------------------------------------------------------------------
+    bool relocate(handle_t const h, point_t const to) {
+        auto const s = get_slot_(h);
+        if (!s) {
+            return false;
         }
 
-        sort_();
+        auto const from = s->p;
+        if (from == to) {
+            return true;
+        }
 
+        auto const block = blocks_.find(block_key_(from));
+        BK_ASSERT(block != std::end(blocks_));
+
+        relocate_(block, find_entry_(block->second, index_of_(h)), to);
         return true;
     }
 
     //----------------------------------------------------------------------------------------------
-    //!
+    //! @pre a value exists at @p p.
     //----------------------------------------------------------------------------------------------
     T remove(point_t const p) {
-        auto const last = end(sorted_);
-        auto const it = std::find_if(begin(sorted_), last, [&](auto const& pair) {
-            return pair.first == p;
+        auto const block = blocks_.find(block_key_(p));
+        BK_PRECONDITION(block != std::end(blocks_));
+
+        auto& bucket = block->second;
+        auto const it = bklib::find_if(bucket, [&](entry_t const& e) {
+            return e.p == p;
         });
 
-        BK_PRECONDITION(it != last);
+        BK_PRECONDITION(it != std::end(bucket));
 
-        auto const index = it->second;
-        auto const data_it = std::next(data_.begin(), index);
+        auto const i = it->slot;
+        erase_entry_(block, it);
 
-        T result = std::move(*data_it);
+        return release_slot_(i);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! @pre @p h is not stale.
+    //----------------------------------------------------------------------------------------------
+    T remove(handle_t const h) {
+        auto const s = get_slot_(h);
+        BK_PRECONDITION(s);
 
-        data_.erase(data_it);
-        sorted_.erase(it);
+        auto const i = index_of_(h);
+        auto const block = blocks_.find(block_key_(s->p));
+        BK_ASSERT(block != std::end(blocks_));
 
-        for (auto& pair : sorted_) {
-            if (pair.second > index) {
-                --pair.second;
-            }
-        }
+        erase_entry_(block, find_entry_(block->second, i));
 
-        return result;
+        return release_slot_(i);
     }
 
     //----------------------------------------------------------------------------------------------
-    //! TODO: this is kind of a hack related to the current implementation
+    //! Call do_remove(p, value) for each value for which predicate(p, value) is true.
+    //! @pre do_remove must remove the value it is passed from the map.
     //----------------------------------------------------------------------------------------------
     template <typename Predicate, typename Remove>
     void remove_if(Predicate&& predicate, Remove&& do_remove) {
-        for (auto i = 0u; i < sorted_.size(); ) {
-            auto const& p = sorted_[i];
-            auto& d = data_[static_cast<size_t>(p.second)];
-            if (predicate(p.first, d)) {
-                auto const size = data_.size();
-                do_remove(p.first, d);
-                BK_ASSERT(data_.size() < size);
-            } else {
-                ++i;
+        for (uint32_t i = 0; i < slot_count_; ++i) {
+            auto& s = slot_(i);
+            if (!s.live || !predicate(s.p, s.value())) {
+                continue;
             }
+
+            do_remove(s.p, s.value());
+            BK_ASSERT(!s.live);
         }
     }
 
@@ -120,11 +217,8 @@ public:
     //!
     //----------------------------------------------------------------------------------------------
     T* at(point_t const& p) {
-        auto const i = find_maybe(sorted_, [&](auto const& pair) {
-            return pair.first == p;
-        });
-
-        return i ? get_data_at_(*i) : nullptr;
+        auto const e = find_at_(p);
+        return e ? std::addressof(slot_(e->slot).value()) : nullptr;
     }
 
     //----------------------------------------------------------------------------------------------
@@ -135,34 +229,142 @@ public:
     }
 
     //----------------------------------------------------------------------------------------------
-    //!
+    //! @return the handle for the value at @p p, or a null handle if there is none.
+    //----------------------------------------------------------------------------------------------
+    handle_t handle_at(point_t const& p) const {
+        auto const e = const_cast<spatial_map_2d*>(this)->find_at_(p);
+        return e ? make_handle_(e->slot) : handle_t {};
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! @return the value referred to by @p h, or nullptr if @p h is stale.
+    //----------------------------------------------------------------------------------------------
+    T* get(handle_t const h) noexcept {
+        auto const s = get_slot_(h);
+        return s ? std::addressof(s->value()) : nullptr;
+    }
+
+    T const* get(handle_t const h) const noexcept {
+        return const_cast<spatial_map_2d*>(this)->get(h);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Call func(value) for each value in the map. Values removed during iteration are skipped;
+    //! values inserted during iteration may or may not be visited.
     //----------------------------------------------------------------------------------------------
     template <typename F>
     void for_each_data(F&& func) const {
-        for (auto const& d : data_) {
-            func(d);
+        for (uint32_t i = 0; i < slot_count_; ++i) {
+            auto const& s = slot_(i);
+            if (s.live) {
+                func(s.value());
+            }
         }
     }
 
     template <typename F>
     void for_each_data(F&& func) {
-        for (auto& d : data_) {
-            func(d);
+        for (uint32_t i = 0; i < slot_count_; ++i) {
+            auto& s = slot_(i);
+            if (s.live) {
+                func(s.value());
+            }
         }
     }
 
     //----------------------------------------------------------------------------------------------
-    //!
+    //! Call func(p, value) for each value with a position p inside @p r.
+    //! Only the blocks overlapping @p r are visited; the order is unspecified.
+    //! @pre func must not insert, remove or relocate values.
     //----------------------------------------------------------------------------------------------
     template <typename F>
     void for_each_at(rect_t const& r, F&& func) const {
-        using bklib::intersects;
+        const_cast<spatial_map_2d*>(this)->for_each_at(r, [&](point_t const p, T const& value) {
+            func(p, value);
+        });
+    }
+
+    template <typename F>
+    void for_each_at(rect_t const& r, F&& func) {
+        for_each_in_blocks_(r, [&](entry_t const& e) {
+            if (intersects(e.p, r)) {
+                func(e.p, slot_(e.slot).value());
+            }
+        });
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Call func(p, value) for each value with a position p no more than @p r steps from @p p in
+    //! any of the 8 directions; i.e. the Chebyshev distance is <= @p r.
+    //----------------------------------------------------------------------------------------------
+    template <typename F>
+    void for_each_in_radius(point_t const p, int const r, F&& func) const {
+        for_each_at(radius_rect_(p, r), std::forward<F>(func));
+    }
+
+    template <typename F>
+    void for_each_in_radius(point_t const p, int const r, F&& func) {
+        for_each_at(radius_rect_(p, r), std::forward<F>(func));
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Call func(p, value) for each value with a position p within a Euclidean distance of @p r
+    //! of @p p.
+    //----------------------------------------------------------------------------------------------
+    template <typename F>
+    void for_each_in_circle(point_t const p, int const r, F&& func) const {
+        const_cast<spatial_map_2d*>(this)->for_each_in_circle(p, r, [&](point_t const q, T const& value) {
+            func(q, value);
+        });
+    }
 
-        for (auto& pair : sorted_) {
-            if (intersects(pair.first, r)) {
-                func(pair.first, *get_data_at_(pair));
+    template <typename F>
+    void for_each_in_circle(point_t const p, int const r, F&& func) {
+        auto const r2 = r * r;
+        for_each_at(radius_rect_(p, r), [&](point_t const q, T& value) {
+            if (distance2(p, q) <= r2) {
+                func(q, value);
             }
+        });
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Find the (up to) @p k values nearest to @p p, by Euclidean distance, that are no further
+    //! than @p max_distance from @p p and for which pred(q, value) is true.
+    //! Blocks are searched ring by ring outward from the block containing @p p; the search stops
+    //! as soon as no unvisited block can hold a closer value.
+    //! @return the values found, nearest first; ties are in an unspecified order.
+    //----------------------------------------------------------------------------------------------
+    template <typename Predicate>
+    std::vector<T*> nearest(point_t const p, size_t const k, int const max_distance, Predicate&& pred) {
+        std::vector<T*> result;
+        for (auto const& c : nearest_(p, k, max_distance, pred)) {
+            result.push_back(std::addressof(slot_(c.slot).value()));
+        }
+
+        return result;
+    }
+
+    template <typename Predicate>
+    std::vector<T const*> nearest(point_t const p, size_t const k, int const max_distance, Predicate&& pred) const {
+        auto const self = const_cast<spatial_map_2d*>(this);
+
+        std::vector<T const*> result;
+        for (auto const& c : self->nearest_(p, k, max_distance, [&](point_t const q, T const& value) {
+            return pred(q, value);
+        })) {
+            result.push_back(std::addressof(slot_(c.slot).value()));
         }
+
+        return result;
+    }
+
+    std::vector<T*> nearest(point_t const p, size_t const k, int const max_distance) {
+        return nearest(p, k, max_distance, [](point_t, T const&) noexcept { return true; });
+    }
+
+    std::vector<T const*> nearest(point_t const p, size_t const k, int const max_distance) const {
+        return nearest(p, k, max_distance, [](point_t, T const&) noexcept { return true; });
     }
 
     //----------------------------------------------------------------------------------------------
@@ -170,31 +372,379 @@ public:
     //----------------------------------------------------------------------------------------------
     template <typename Predicate>
     T const* find(Predicate&& pred) const {
-        return find_maybe(data_, std::forward<Predicate>(pred));
+        return const_cast<spatial_map_2d*>(this)->find(std::forward<Predicate>(pred));
     }
 
     template <typename Predicate>
     T* find(Predicate&& pred) {
-        return find_maybe(data_, std::forward<Predicate>(pred));
+        for (uint32_t i = 0; i < slot_count_; ++i) {
+            auto& s = slot_(i);
+            if (s.live && pred(static_cast<T const&>(s.value()))) {
+                return std::addressof(s.value());
+            }
+        }
+
+        return nullptr;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //!
+    //----------------------------------------------------------------------------------------------
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
     }
 private:
-    T* get_data_at_(std::pair<point_t, int> const p) noexcept {
-        BK_PRECONDITION(p.second >= 0);
-        return std::addressof(data_[static_cast<size_t>(p.second)]);
+    static constexpr uint32_t index_bits      = 20;
+    static constexpr uint32_t index_mask      = (1u << index_bits) - 1u;
+    static constexpr uint32_t generation_mask = (1u << (32u - index_bits)) - 1u;
+    static constexpr uint32_t page_size       = 256;
+
+    struct slot_t {
+        T&       value()       noexcept { return *reinterpret_cast<T*>(std::addressof(storage)); }
+        T const& value() const noexcept { return *reinterpret_cast<T const*>(std::addressof(storage)); }
+
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+
+        point_t  p          = point_t {0, 0};
+        uint32_t generation = 1; //!< never 0; bumped each time the slot is released
+        bool     live       = false;
+    };
+
+    struct entry_t {
+        point_t  p;
+        uint32_t slot;
+    };
+
+    using page_t      = std::unique_ptr<slot_t[]>;
+    using bucket_t    = std::vector<entry_t>;
+    using block_map_t = std::unordered_map<uint64_t, bucket_t>;
+
+    static constexpr int to_block_(int const n) noexcept {
+        return floor_div(n, block_size);
+    }
+
+    static uint64_t block_key_(point_t const p) noexcept {
+        return grid_key(to_block_(x(p)), to_block_(y(p)));
+    }
+
+    static rect_t radius_rect_(point_t const p, int const r) noexcept {
+        return {x(p) - r, y(p) - r, x(p) + r + 1, y(p) + r + 1};
+    }
+
+    struct candidate_t {
+        int64_t  distance2;
+        uint32_t slot;
+    };
+
+    //! See nearest(); the candidates are returned sorted nearest first.
+    template <typename Predicate>
+    std::vector<candidate_t> nearest_(point_t const p, size_t const k, int const max_distance, Predicate&& pred) {
+        std::vector<candidate_t> result;
+        if (k == 0 || max_distance < 0 || blocks_.empty()) {
+            return result;
+        }
+
+        auto const max_d2 = int64_t {max_distance} * max_distance;
+        auto const farther = [](candidate_t const& a, candidate_t const& b) noexcept {
+            return a.distance2 < b.distance2;
+        };
+
+        auto const px = x(p);
+        auto const py = y(p);
+        auto const bx = to_block_(px);
+        auto const by = to_block_(py);
+
+        // result is kept as a max-heap on distance while searching
+        auto const visit = [&](bucket_t const& bucket) {
+            for (auto const& e : bucket) {
+                auto const dx = int64_t {x(e.p)} - px;
+                auto const dy = int64_t {y(e.p)} - py;
+                auto const d2 = dx * dx + dy * dy;
+
+                if (d2 > max_d2 || (result.size() == k && d2 >= result.front().distance2)) {
+                    continue;
+                }
+
+                if (!pred(e.p, static_cast<T const&>(slot_(e.slot).value()))) {
+                    continue;
+                }
+
+                if (result.size() == k) {
+                    std::pop_heap(begin(result), end(result), farther);
+                    result.pop_back();
+                }
+
+                result.push_back(candidate_t {d2, e.slot});
+                std::push_heap(begin(result), end(result), farther);
+            }
+        };
+
+        size_t visited = 0;
+
+        for (int ring = 0; ; ++ring) {
+            // once a ring has more blocks than are occupied it's cheaper to check every occupied
+            // block outside the rings already searched.
+            if (static_cast<size_t>(ring) * 8u > blocks_.size()) {
+                for (auto const& block : blocks_) {
+                    auto const dbx = std::abs(grid_key_x(block.first) - bx);
+                    auto const dby = std::abs(grid_key_y(block.first) - by);
+                    if (std::max(dbx, dby) >= ring) {
+                        visit(block.second);
+                    }
+                }
+
+                break;
+            }
+
+            for (int dy = -ring; dy <= ring; ++dy) {
+                auto const step = (dy == -ring || dy == ring) ? 1 : std::max(1, 2 * ring);
+                for (int dx = -ring; dx <= ring; dx += step) {
+                    auto const block = blocks_.find(grid_key(bx + dx, by + dy));
+                    if (block != std::end(blocks_)) {
+                        visit(block->second);
+                        ++visited;
+                    }
+                }
+            }
+
+            if (visited == blocks_.size()) {
+                break;
+            }
+
+            // the nearest any cell outside the rings searched so far can be
+            auto const outside = int64_t {std::min({
+                px - (bx - ring) * block_size + 1
+              , (bx + ring + 1) * block_size - px
+              , py - (by - ring) * block_size + 1
+              , (by + ring + 1) * block_size - py
+            })};
+
+            auto const outside2 = outside * outside;
+            if (outside2 > max_d2 || (result.size() == k && result.front().distance2 <= outside2)) {
+                break;
+            }
+        }
+
+        std::sort_heap(begin(result), end(result), farther);
+        return result;
+    }
+
+    //! Call f(entry) for every entry in the blocks overlapping @p r. Whichever is smaller of the
+    //! blocks covered by @p r and the blocks actually occupied is iterated.
+    template <typename F>
+    void for_each_in_blocks_(rect_t const r, F&& f) {
+        if (!r) {
+            return;
+        }
+
+        auto const bx0 = to_block_(r.left);
+        auto const by0 = to_block_(r.top);
+        auto const bx1 = to_block_(r.right  - 1);
+        auto const by1 = to_block_(r.bottom - 1);
+
+        auto const covered = (int64_t {bx1} - bx0 + 1) * (int64_t {by1} - by0 + 1);
+
+        if (covered > static_cast<int64_t>(blocks_.size())) {
+            for (auto const& block : blocks_) {
+                for (auto const& e : block.second) {
+                    f(e);
+                }
+            }
+
+            return;
+        }
+
+        for (auto by = by0; by <= by1; ++by) {
+            for (auto bx = bx0; bx <= bx1; ++bx) {
+                auto const block = blocks_.find(grid_key(bx, by));
+                if (block == std::end(blocks_)) {
+                    continue;
+                }
+
+                for (auto const& e : block->second) {
+                    f(e);
+                }
+            }
+        }
+    }
+
+    static uint32_t index_of_(handle_t const h) noexcept {
+        return static_cast<uint32_t>(h) & index_mask;
+    }
+
+    static uint32_t generation_of_(handle_t const h) noexcept {
+        return static_cast<uint32_t>(h) >> index_bits;
+    }
+
+    handle_t make_handle_(uint32_t const i) const noexcept {
+        return handle_t {(slot_(i).generation << index_bits) | i};
+    }
+
+    slot_t& slot_(uint32_t const i) noexcept {
+        return pages_[i / page_size][i % page_size];
     }
 
-    T const* get_data_at_(std::pair<point_t, int> const p) const noexcept {
-        return const_cast<spatial_map_2d*>(this)->get_data_at_(p);
+    slot_t const& slot_(uint32_t const i) const noexcept {
+        return const_cast<spatial_map_2d*>(this)->slot_(i);
+    }
+
+    slot_t* get_slot_(handle_t const h) noexcept {
+        auto const i = index_of_(h);
+        if (!h || i >= slot_count_) {
+            return nullptr;
+        }
+
+        auto& s = slot_(i);
+        return (s.live && s.generation == generation_of_(h)) ? std::addressof(s) : nullptr;
     }
 
-    void sort_() {
-        std::sort(begin(sorted_), end(sorted_), [](auto const& lhs, auto const& rhs) {
-            return lhs.first < rhs.first;
+    entry_t* find_at_(point_t const p) {
+        auto const block = blocks_.find(block_key_(p));
+        if (block == std::end(blocks_)) {
+            return nullptr;
+        }
+
+        return find_maybe(block->second, [&](entry_t const& e) {
+            return e.p == p;
+        });
+    }
+
+    static typename bucket_t::iterator find_entry_(bucket_t& bucket, uint32_t const i) noexcept {
+        auto const it = bklib::find_if(bucket, [i](entry_t const& e) {
+            return e.slot == i;
         });
+
+        BK_ASSERT(it != std::end(bucket));
+        return it;
+    }
+
+    template <typename InputIt>
+    void reserve_(InputIt, InputIt, std::input_iterator_tag) {
+    }
+
+    //! Make room for the slots and, assuming roughly one block per block_size values, the blocks.
+    template <typename ForwardIt>
+    void reserve_(ForwardIt const first, ForwardIt const last, std::forward_iterator_tag) {
+        auto const n = static_cast<size_t>(std::distance(first, last));
+        auto const needed = n > free_.size() ? n - free_.size() : size_t {0};
+
+        pages_.reserve(pages_.size() + needed / page_size + 1u);
+        blocks_.reserve(blocks_.size() + n / block_size + 1u);
+    }
+
+    //! Construct a value at @p p in a free slot without indexing it.
+    uint32_t construct_(point_t const p, T&& data) {
+        auto const i = allocate_slot_();
+        auto& s = slot_(i);
+
+        ::new (static_cast<void*>(std::addressof(s.storage))) T(std::move(data));
+        s.p    = p;
+        s.live = true;
+        ++size_;
+
+        return i;
+    }
+
+    uint32_t allocate_slot_() {
+        if (!free_.empty()) {
+            auto const i = free_.back();
+            free_.pop_back();
+            return i;
+        }
+
+        BK_PRECONDITION(slot_count_ < index_mask);
+
+        if (slot_count_ % page_size == 0) {
+            pages_.push_back(page_t {new slot_t[page_size]});
+        }
+
+        return slot_count_++;
+    }
+
+    //! Move the value out of the slot @p i and put the slot on the free list.
+    T release_slot_(uint32_t const i) {
+        auto& s = slot_(i);
+        BK_ASSERT(s.live);
+
+        T result = std::move(s.value());
+        s.value().~T();
+
+        s.live = false;
+        s.generation = (s.generation & generation_mask) == generation_mask
+          ? 1u : s.generation + 1u;
+
+        free_.push_back(i);
+        --size_;
+
+        return result;
+    }
+
+    void relocate_(
+        typename block_map_t::iterator const block
+      , typename bucket_t::iterator    const it
+      , point_t                        const to
+    ) {
+        auto const i = it->slot;
+        slot_(i).p = to;
+
+        auto const key = block_key_(to);
+        if (key == block->first) {
+            it->p = to;
+            return;
+        }
+
+        auto const dest = blocks_.find(key);
+        if (dest != std::end(blocks_)) {
+            dest->second.push_back(entry_t {to, i});
+            erase_entry_(block, it);
+            return;
+        }
+
+        // the only entry in its block moving to an empty block; re-key the bucket rather than
+        // releasing it and allocating a new one.
+        if (block->second.size() == 1u) {
+            auto bucket = std::move(block->second);
+            blocks_.erase(block);
+
+            bucket.front() = entry_t {to, i};
+            blocks_.emplace(key, std::move(bucket));
+            return;
+        }
+
+        erase_entry_(block, it);
+        blocks_[key].push_back(entry_t {to, i});
+    }
+
+    //! Unordered erase of the entry @p it from the bucket @p block; empty buckets are released.
+    void erase_entry_(typename block_map_t::iterator const block, typename bucket_t::iterator const it) {
+        auto& bucket = block->second;
+
+        *it = bucket.back();
+        bucket.pop_back();
+
+        if (bucket.empty()) {
+            blocks_.erase(block);
+        }
+    }
+
+    void swap_(spatial_map_2d& other) noexcept {
+        using std::swap;
+        swap(pages_,      other.pages_);
+        swap(free_,       other.free_);
+        swap(blocks_,     other.blocks_);
+        swap(slot_count_, other.slot_count_);
+        swap(size_,       other.size_);
     }
 
-    std::vector<T>                       data_;
-    std::vector<std::pair<point_t, int>> sorted_;
+    std::vector<page_t>   pages_;          //!< fixed size pages of slots; never reallocated
+    std::vector<uint32_t> free_;           //!< released slots available for reuse
+    block_map_t           blocks_;
+    uint32_t              slot_count_ = 0; //!< number of slots ever allocated
+    size_t                size_       = 0; //!< number of live values
 };
 
 } //namespace bklib
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+namespace bklib {
+
+//--------------------------------------------------------------------------------------------------
+//! Double buffering between a writer and a reader thread. The writer fills back() while the reader
+//! uses front(); publish() and acquire() exchange them by way of a third, hand-off buffer, so
+//! neither side ever waits for the other to finish with its buffer. Values published but never
+//! acquired are simply replaced by newer ones.
+//--------------------------------------------------------------------------------------------------
+template <typename T>
+class swap_buffer {
+public:
+    swap_buffer() = default;
+
+    //! Construct each of the buffers from a call to make().
+    template <typename Make>
+    explicit swap_buffer(Make&& make)
+      : buffers_ {{make(), make(), make()}}
+    {
+    }
+
+    swap_buffer(swap_buffer const&) = delete;
+    swap_buffer& operator=(swap_buffer const&) = delete;
+
+    //----------------------------------------------------------------------------------------------
+    //! The writer's buffer.
+    //----------------------------------------------------------------------------------------------
+    T&       back()       noexcept { return buffers_[back_]; }
+    T const& back() const noexcept { return buffers_[back_]; }
+
+    //----------------------------------------------------------------------------------------------
+    //! The reader's buffer; the most recently acquired value.
+    //----------------------------------------------------------------------------------------------
+    T&       front()       noexcept { return buffers_[front_]; }
+    T const& front() const noexcept { return buffers_[front_]; }
+
+    //----------------------------------------------------------------------------------------------
+    //! Hand back() to the reader; back() is then the oldest of the other buffers.
+    //----------------------------------------------------------------------------------------------
+    void publish() {
+        {
+            std::lock_guard<std::mutex> lock {mutex_};
+            std::swap(back_, ready_);
+            fresh_ = true;
+        }
+
+        cv_.notify_one();
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Make the most recently published buffer front(), if there is one newer than front().
+    //! @return true if front() changed; false otherwise.
+    //----------------------------------------------------------------------------------------------
+    bool acquire() {
+        std::lock_guard<std::mutex> lock {mutex_};
+        return acquire_();
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! As acquire(), but wait up to @p timeout for a buffer to be published.
+    //----------------------------------------------------------------------------------------------
+    template <typename Rep, typename Period>
+    bool acquire_for(std::chrono::duration<Rep, Period> const timeout) {
+        std::unique_lock<std::mutex> lock {mutex_};
+        cv_.wait_for(lock, timeout, [&] { return fresh_; });
+        return acquire_();
+    }
+private:
+    bool acquire_() noexcept {
+        if (!fresh_) {
+            return false;
+        }
+
+        std::swap(front_, ready_);
+        fresh_ = false;
+
+        return true;
+    }
+
+    std::array<T, 3>        buffers_;
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+
+    int  back_  = 0; //!< only used by the writer
+    int  ready_ = 1; //!< guarded by mutex_
+    int  front_ = 2; //!< only used by the reader
+    bool fresh_ = false;
+};
+
+} //namespace bklib
@@ -91,6 +91,13 @@ int bklib::timer::update()
     return result;
 }
 
+//--------------------------------------------------------------------------------------------------
+bklib::timer::time_point_t bklib::timer::next_deadline() const noexcept
+{
+    BK_PRECONDITION(!records_.empty());
+    return records_.front().first;
+}
+
 //--------------------------------------------------------------------------------------------------
 bklib::timer::id_t bklib::timer::add_(record_t&& rec)
 {
@@ -15,9 +15,10 @@ class timer {
 public:
     struct record_t;
 
-    using id_t       = bklib::tagged_value<timer, int>;
-    using callback_t = std::function<void (record_t& r)>;
-    using duration_t = std::chrono::microseconds;
+    using id_t         = bklib::tagged_value<timer, int>;
+    using callback_t   = std::function<void (record_t& r)>;
+    using duration_t   = std::chrono::microseconds;
+    using time_point_t = std::chrono::high_resolution_clock::time_point;
 
     struct record_t {
         record_t() = delete;
@@ -32,6 +33,10 @@ public:
     int size() const noexcept;
 
     int update();
+
+    //! The time the earliest timer is due.
+    //! @pre !empty()
+    time_point_t next_deadline() const noexcept;
     bool remove(id_t id);
 
     bool reset(id_t id);
@@ -51,8 +56,7 @@ public:
         });
     }
 private:
-    using time_point_t = std::chrono::high_resolution_clock::time_point;
-    using pair_t       = std::pair<time_point_t, record_t>;
+    using pair_t = std::pair<time_point_t, record_t>;
 
     id_t add_(record_t&& rec);
     id_t add_(time_point_t now, record_t&& rec);
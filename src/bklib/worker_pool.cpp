@@ -0,0 +1,119 @@
+#include "worker_pool.hpp"
+
+#include "bklib/assert.hpp"
+
+#include <algorithm>
+
+//--------------------------------------------------------------------------------------------------
+bklib::worker_pool::worker_pool(size_t const workers)
+{
+    threads_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        threads_.emplace_back([this] { run_worker_(); });
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bklib::worker_pool::~worker_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+        stopping_ = true;
+    }
+
+    start_cv_.notify_all();
+
+    for (auto& t : threads_) {
+        t.join();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bklib::worker_pool::for_each_range(size_t const n, size_t const grain, range_function const& f)
+{
+    BK_PRECONDITION(grain > 0);
+
+    // not worth waking anyone for
+    if (threads_.empty() || n <= grain) {
+        for (size_t i = 0; i < n; i += grain) {
+            f(i, std::min(i + grain, n));
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+        job_   = &f;
+        n_     = n;
+        grain_ = grain;
+        busy_  = threads_.size();
+        error_ = nullptr;
+        next_.store(0, std::memory_order_relaxed);
+        ++loop_;
+    }
+
+    start_cv_.notify_all();
+
+    work_();
+
+    std::unique_lock<std::mutex> lock {mutex_};
+    done_cv_.wait(lock, [&] { return busy_ == 0; });
+
+    job_ = nullptr;
+
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bklib::worker_pool::run_worker_()
+{
+    uint64_t loop = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock {mutex_};
+            start_cv_.wait(lock, [&] { return stopping_ || loop_ != loop; });
+
+            if (stopping_) {
+                return;
+            }
+
+            loop = loop_;
+        }
+
+        work_();
+
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lock {mutex_};
+            done = (--busy_ == 0);
+        }
+
+        if (done) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bklib::worker_pool::work_() noexcept
+{
+    for (;;) {
+        auto const first = next_.fetch_add(grain_, std::memory_order_relaxed);
+        if (first >= n_) {
+            return;
+        }
+
+        try {
+            (*job_)(first, std::min(first + grain_, n_));
+        } catch (...) {
+            std::lock_guard<std::mutex> lock {mutex_};
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bklib {
+
+//--------------------------------------------------------------------------------------------------
+//! A fixed set of worker threads for splitting a loop over an index range between them and the
+//! calling thread. Only one loop runs at a time; for_each_range() returns when it is done.
+//--------------------------------------------------------------------------------------------------
+class worker_pool {
+public:
+    using range_function = std::function<void (size_t first, size_t last)>;
+
+    //! A pool of @p workers threads; with none every loop runs on the calling thread.
+    explicit worker_pool(size_t workers = 0);
+    ~worker_pool();
+
+    worker_pool(worker_pool const&) = delete;
+    worker_pool& operator=(worker_pool const&) = delete;
+
+    //! The number of worker threads; the calling thread makes one more.
+    size_t size() const noexcept {
+        return threads_.size();
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Call f(first, last) for consecutive ranges, of at most @p grain indices each, covering
+    //! [0, n); the ranges are handed out to the workers and the calling thread as each becomes
+    //! free. The first exception thrown by @p f is rethrown once every range has been done.
+    //! @pre grain > 0
+    //! @pre @p f must not call for_each_range on this pool.
+    //----------------------------------------------------------------------------------------------
+    void for_each_range(size_t n, size_t grain, range_function const& f);
+private:
+    void run_worker_();
+
+    //! Take and call ranges of the current loop until there are none left.
+    void work_() noexcept;
+
+    std::vector<std::thread> threads_;
+
+    std::mutex              mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+
+    range_function const* job_      = nullptr;
+    size_t                n_        = 0;
+    size_t                grain_    = 0;
+    uint64_t              loop_     = 0; //!< incremented for each loop started
+    size_t                busy_     = 0; //!< workers yet to finish the current loop
+    bool                  stopping_ = false;
+    std::exception_ptr    error_;
+
+    std::atomic<size_t> next_ {0}; //!< the start of the next range to hand out
+};
+
+} //namespace bklib
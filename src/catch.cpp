@@ -3,9 +3,13 @@
 #   include <catch/catch.hpp>
 #endif
 
-int run_unit_tests() {
+int run_unit_tests(bool const benchmarks) {
     Catch::Session session;
     session.configData().shouldDebugBreak = true;
 
+    if (benchmarks) {
+        session.configData().testsOrTags.push_back("[benchmark]");
+    }
+
     return session.run();
 }
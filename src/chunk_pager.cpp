@@ -0,0 +1,392 @@
+#include "chunk_pager.hpp"
+
+#include "bklib/assert.hpp"
+#include "bklib/exception.hpp"
+
+#include <boost/predef.h>
+
+#if BOOST_OS_WINDOWS
+#   if !defined(NOMINMAX)
+#       define NOMINMAX
+#   endif
+#   if !defined(WIN32_LEAN_AND_MEAN)
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <cerrno>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// bkrl::chunk_pager::file_t
+//! The platform specific part: a file that can be grown and have views of it mapped.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#if BOOST_OS_WINDOWS
+class bkrl::chunk_pager::file_t {
+public:
+    explicit file_t(bklib::utf8_string_view const filename)
+      : filename_ {filename.to_string()}
+    {
+        handle_ = ::CreateFileA(filename_.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr
+          , CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+
+        if (handle_ == INVALID_HANDLE_VALUE) {
+            BOOST_THROW_EXCEPTION(bklib::io_error {}
+              << boost::errinfo_api_function {"CreateFileA"}
+              << boost::errinfo_file_name {filename_});
+        }
+    }
+
+    ~file_t() {
+        if (mapping_) {
+            ::CloseHandle(mapping_);
+        }
+
+        ::CloseHandle(handle_);
+    }
+
+    static size_t granularity() noexcept {
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        return info.dwAllocationGranularity;
+    }
+
+    //! Views mapped from the previous mapping object stay valid after it is closed.
+    void resize(size_t const size) {
+        auto const mapping = ::CreateFileMappingA(handle_, nullptr, PAGE_READWRITE
+          , static_cast<DWORD>(uint64_t {size} >> 32), static_cast<DWORD>(size), nullptr);
+
+        if (!mapping) {
+            BOOST_THROW_EXCEPTION(bklib::io_error {}
+              << boost::errinfo_api_function {"CreateFileMappingA"}
+              << boost::errinfo_file_name {filename_});
+        }
+
+        if (mapping_) {
+            ::CloseHandle(mapping_);
+        }
+
+        mapping_ = mapping;
+    }
+
+    void* map(size_t const offset, size_t const size) {
+        auto const result = ::MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS
+          , static_cast<DWORD>(uint64_t {offset} >> 32), static_cast<DWORD>(offset), size);
+
+        if (!result) {
+            BOOST_THROW_EXCEPTION(bklib::io_error {}
+              << boost::errinfo_api_function {"MapViewOfFile"}
+              << boost::errinfo_file_name {filename_});
+        }
+
+        return result;
+    }
+
+    void unmap(void* const data, size_t) noexcept {
+        ::UnmapViewOfFile(data);
+    }
+private:
+    std::string filename_;
+    HANDLE      handle_  = INVALID_HANDLE_VALUE;
+    HANDLE      mapping_ = nullptr;
+};
+#else
+class bkrl::chunk_pager::file_t {
+public:
+    explicit file_t(bklib::utf8_string_view const filename)
+      : filename_ {filename.to_string()}
+    {
+        fd_ = ::open(filename_.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (fd_ < 0) {
+            throw_error_("open");
+        }
+
+        // the file is scratch space only; it goes away with the last reference to it.
+        ::unlink(filename_.c_str());
+    }
+
+    ~file_t() {
+        ::close(fd_);
+    }
+
+    static size_t granularity() noexcept {
+        return static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    void resize(size_t const size) {
+        if (::ftruncate(fd_, static_cast<off_t>(size))) {
+            throw_error_("ftruncate");
+        }
+    }
+
+    void* map(size_t const offset, size_t const size) {
+        auto const result = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_
+          , static_cast<off_t>(offset));
+
+        if (result == MAP_FAILED) {
+            throw_error_("mmap");
+        }
+
+        return result;
+    }
+
+    void unmap(void* const data, size_t const size) noexcept {
+        ::munmap(data, size);
+    }
+private:
+    [[noreturn]] void throw_error_(char const* const function) const {
+        BOOST_THROW_EXCEPTION(bklib::io_error {}
+          << boost::errinfo_api_function {function}
+          << boost::errinfo_errno {errno}
+          << boost::errinfo_file_name {filename_});
+    }
+
+    std::string filename_;
+    int         fd_ = -1;
+};
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// bkrl::chunk_pager
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------
+bkrl::chunk_pager::chunk_pager(
+    bklib::utf8_string_view const filename
+  , size_t                  const page_size
+  , size_t                  const budget
+)
+  : file_ {std::make_unique<file_t>(filename)}
+  , page_size_ {[&] {
+        auto const g = file_t::granularity();
+        return (std::max(page_size, size_t {1}) + g - 1) / g * g;
+    }()}
+  , max_resident_ {std::max(budget / page_size_, size_t {1})}
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::chunk_pager::~chunk_pager()
+{
+    for (auto const& page : pages_) {
+        if (page.second.data) {
+            file_->unmap(page.second.data, page_size_);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t bkrl::chunk_pager::page_size() const noexcept
+{
+    return page_size_;
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t bkrl::chunk_pager::max_resident() const noexcept
+{
+    return max_resident_;
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t bkrl::chunk_pager::resident() const noexcept
+{
+    return resident_;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::chunk_pager::has_page(uint64_t const key) const noexcept
+{
+    return pages_.find(key) != std::end(pages_);
+}
+
+//--------------------------------------------------------------------------------------------------
+void* bkrl::chunk_pager::map(uint64_t const key)
+{
+    auto it = pages_.find(key);
+
+    if (it == std::end(pages_)) {
+        // newly grown parts of the file read as zero
+        file_->resize((slots_ + 1) * page_size_);
+        it = pages_.emplace(key, page_t {slots_++, nullptr, {}}).first;
+    }
+
+    auto& page = it->second;
+    BK_PRECONDITION(!page.data);
+
+    page.data = file_->map(page.slot * page_size_, page_size_);
+    ++resident_;
+
+    lru_.push_front(key);
+    page.lru_pos = std::begin(lru_);
+
+    return page.data;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::chunk_pager::touch(uint64_t const key) noexcept
+{
+    auto const it = pages_.find(key);
+    BK_ASSERT(it != std::end(pages_) && it->second.data);
+
+    // pinned pages become the most recently used when unpinned
+    if (!it->second.pins) {
+        lru_.splice(std::begin(lru_), lru_, it->second.lru_pos);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::chunk_pager::pin(uint64_t const key) noexcept
+{
+    auto const it = pages_.find(key);
+    BK_PRECONDITION(it != std::end(pages_) && it->second.data);
+
+    auto& page = it->second;
+    if (page.pins++ == 0) {
+        lru_.erase(page.lru_pos);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::chunk_pager::unpin(uint64_t const key) noexcept
+{
+    auto const it = pages_.find(key);
+    BK_PRECONDITION(it != std::end(pages_) && it->second.data && it->second.pins);
+
+    auto& page = it->second;
+    if (--page.pins == 0) {
+        lru_.push_front(key);
+        page.lru_pos = std::begin(lru_);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::chunk_pager::is_pinned(uint64_t const key) const noexcept
+{
+    auto const it = pages_.find(key);
+    return it != std::end(pages_) && it->second.pins;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::chunk_pager::over_budget() const noexcept
+{
+    return resident_ > max_resident_;
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t bkrl::chunk_pager::lru() const noexcept
+{
+    BK_PRECONDITION(!lru_.empty());
+    return lru_.back();
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::chunk_pager::unmap(uint64_t const key) noexcept
+{
+    auto const it = pages_.find(key);
+    BK_PRECONDITION(it != std::end(pages_) && it->second.data && !it->second.pins);
+
+    auto& page = it->second;
+
+    file_->unmap(page.data, page_size_);
+    page.data = nullptr;
+    --resident_;
+
+    lru_.erase(page.lru_pos);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// bkrl::payload_pager
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------
+bkrl::payload_pager::payload_pager(bklib::utf8_string_view const filename, size_t const page_size)
+  : pager_ {filename, page_size, page_size}
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::payload_pager::has(uint64_t const key) const noexcept
+{
+    return payloads_.find(key) != std::end(payloads_);
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t bkrl::payload_pager::size() const noexcept
+{
+    return payloads_.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::payload_pager::append(uint64_t const key, void const* const data, size_t size)
+{
+    auto const page_size = pager_.page_size();
+    auto&      payload   = payloads_[key];
+    auto       first     = static_cast<char const*>(data);
+
+    while (size) {
+        auto const offset = payload.size % page_size;
+        if (offset == 0) {
+            if (free_pages_.empty()) {
+                payload.pages.push_back(next_page_++);
+            } else {
+                payload.pages.push_back(free_pages_.back());
+                free_pages_.pop_back();
+            }
+        }
+
+        auto const page = payload.pages.back();
+        auto const n    = std::min(size, page_size - offset);
+
+        std::memcpy(static_cast<char*>(pager_.map(page)) + offset, first, n);
+        pager_.unmap(page);
+
+        first        += n;
+        size         -= n;
+        payload.size += n;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::payload_pager::take(uint64_t const key, std::vector<char>& out)
+{
+    auto const it = payloads_.find(key);
+    if (it == std::end(payloads_)) {
+        return false;
+    }
+
+    auto const page_size = pager_.page_size();
+    auto const& payload  = it->second;
+    auto const  first    = out.size();
+
+    out.resize(first + payload.size);
+
+    auto remaining = payload.size;
+    auto dst       = out.data() + first;
+
+    try {
+        for (auto const page : payload.pages) {
+            auto const n = std::min(remaining, page_size);
+
+            std::memcpy(dst, pager_.map(page), n);
+            pager_.unmap(page);
+
+            dst       += n;
+            remaining -= n;
+        }
+    } catch (...) {
+        out.resize(first);
+        throw;
+    }
+
+    free_pages_.insert(std::end(free_pages_), std::begin(payload.pages), std::end(payload.pages));
+    payloads_.erase(it);
+
+    return true;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "bklib/string.hpp"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace bkrl {
+
+//--------------------------------------------------------------------------------------------------
+//! Backs fixed size pages, identified by a 64 bit key, with a file on disk.
+//!
+//! Pages are mapped into memory on demand; at most max_resident() pages are mapped at once and the
+//! owner is expected to unmap the least recently used page (see lru()) when over_budget(). Mapped
+//! pages refer directly to the file, so mapping a page back in doesn't copy anything and unmapping
+//! a page returns its memory to the OS.
+//!
+//! Pages can be pinned while something refers into them (see pin()); pinned pages are never
+//! reported by lru(), so the budget can be exceeded until they are unpinned.
+//--------------------------------------------------------------------------------------------------
+class chunk_pager {
+public:
+    //----------------------------------------------------------------------------------------------
+    //! @param filename  The page file; it is created, or truncated if it already exists.
+    //! @param page_size The size of each page in bytes; rounded up to the OS mapping granularity.
+    //! @param budget    The maximum number of bytes of pages to keep mapped; at least one page.
+    //! @throws bklib::io_error if the file can't be created.
+    //----------------------------------------------------------------------------------------------
+    chunk_pager(bklib::utf8_string_view filename, size_t page_size, size_t budget);
+    ~chunk_pager();
+
+    chunk_pager(chunk_pager const&) = delete;
+    chunk_pager& operator=(chunk_pager const&) = delete;
+
+    size_t page_size()    const noexcept;
+    size_t max_resident() const noexcept;
+    size_t resident()     const noexcept;
+
+    //! @return true if the page for @p key has ever been mapped.
+    bool has_page(uint64_t key) const noexcept;
+
+    //----------------------------------------------------------------------------------------------
+    //! Map the page for @p key, zero filled the first time, and mark it most recently used.
+    //! @pre the page isn't already mapped.
+    //! @throws bklib::io_error if the file can't be grown or mapped.
+    //----------------------------------------------------------------------------------------------
+    void* map(uint64_t key);
+
+    //! Mark the mapped page for @p key as the most recently used.
+    void touch(uint64_t key) noexcept;
+
+    //----------------------------------------------------------------------------------------------
+    //! Keep the page for @p key out of lru() until a matching unpin(); pins nest. Unpinning the
+    //! last pin makes it the most recently used page.
+    //! @pre the page is mapped.
+    //----------------------------------------------------------------------------------------------
+    void pin(uint64_t key) noexcept;
+    void unpin(uint64_t key) noexcept;
+
+    bool is_pinned(uint64_t key) const noexcept;
+
+    //! @return true if more than max_resident() pages are mapped.
+    bool over_budget() const noexcept;
+
+    //! @return the key of the least recently used mapped page that isn't pinned.
+    //! @pre such a page exists.
+    uint64_t lru() const noexcept;
+
+    //! Unmap the page for @p key; its contents are kept in the file.
+    //! @pre the page is mapped and not pinned.
+    void unmap(uint64_t key) noexcept;
+private:
+    class file_t;
+
+    struct page_t {
+        size_t                        slot;            //!< position of the page in the file
+        void*                         data = nullptr;  //!< nullptr if not mapped
+        std::list<uint64_t>::iterator lru_pos;         //!< valid only if mapped and not pinned
+        uint32_t                      pins = 0;
+    };
+
+    std::unique_ptr<file_t>               file_;
+    std::unordered_map<uint64_t, page_t>  pages_;
+    std::list<uint64_t>                   lru_;        //!< unpinned mapped pages; most recent first
+    size_t                                page_size_;
+    size_t                                max_resident_;
+    size_t                                resident_ = 0;
+    size_t                                slots_ = 0;  //!< number of pages allocated in the file
+};
+
+//--------------------------------------------------------------------------------------------------
+//! Variable sized blobs, identified by a 64 bit key, kept in the pages of a chunk_pager; for data
+//! that is only needed again much later, such as the objects on terrain that has been paged out.
+//!
+//! A blob is spread over as many pages as it needs; only the page being copied to or from is
+//! mapped at any time, so the memory used is that of the page index.
+//--------------------------------------------------------------------------------------------------
+class payload_pager {
+public:
+    //----------------------------------------------------------------------------------------------
+    //! @param filename  As for chunk_pager.
+    //! @param page_size As for chunk_pager; smaller pages waste less of the file on small blobs.
+    //! @throws bklib::io_error if the file can't be created.
+    //----------------------------------------------------------------------------------------------
+    payload_pager(bklib::utf8_string_view filename, size_t page_size);
+
+    //! @return true if there is a blob for @p key.
+    bool has(uint64_t key) const noexcept;
+
+    //! The number of blobs.
+    size_t size() const noexcept;
+
+    //----------------------------------------------------------------------------------------------
+    //! Append @p size bytes from @p data to the blob for @p key, creating it if needed.
+    //! @throws bklib::io_error if the file can't be grown or mapped.
+    //----------------------------------------------------------------------------------------------
+    void append(uint64_t key, void const* data, size_t size);
+
+    //----------------------------------------------------------------------------------------------
+    //! Append the blob for @p key to @p out and forget it; its pages are reused.
+    //! @return false, leaving @p out unchanged, if there is no blob for @p key.
+    //! @throws bklib::io_error if a page can't be mapped; the blob is kept.
+    //----------------------------------------------------------------------------------------------
+    bool take(uint64_t key, std::vector<char>& out);
+private:
+    struct payload_t {
+        std::vector<uint64_t> pages; //!< the keys of the pages in pager_, in order
+        size_t                size = 0;
+    };
+
+    chunk_pager                             pager_;
+    std::unordered_map<uint64_t, payload_t> payloads_;
+    std::vector<uint64_t>                   free_pages_;
+    uint64_t                                next_page_ = 0;
+};
+
+} //namespace bkrl
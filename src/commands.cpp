@@ -90,6 +90,7 @@ public:
         case SDLK_i:        cmd.type = ct::show_inventory;   break;
         case SDLK_ESCAPE:   cmd.type = ct::cancel;           break;
         case SDLK_HOME:     cmd.type = ct::center_on_player; break;
+        case SDLK_F3:       cmd.type = ct::toggle_profiler;  break;
         case SDLK_RETURN:   BK_FALLTHROUGH
         case SDLK_RETURN2:  BK_FALLTHROUGH
         case SDLK_KP_ENTER: cmd.type = ct::confirm;          break;
@@ -49,6 +49,7 @@ enum class command_type : uint32_t {
   , BK_DECLARE_COMMAND(show_inventory)
   , BK_DECLARE_COMMAND(show_equipment)
   , BK_DECLARE_COMMAND(get)
+  , BK_DECLARE_COMMAND(toggle_profiler)
 };
 #undef BK_DECLARE_COMMAND
 
@@ -4,13 +4,45 @@
 #include "output.hpp"
 
 #include "bklib/dictionary.hpp"
+#include "bklib/byte_stream.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
 
-void bkrl::process_tags(creature_def&)
+void bkrl::process_tags(creature_def& def)
 {
+    using namespace bklib::literals;
+
+    for (auto const& tag : def.tags) {
+        switch (static_cast<uint32_t>(tag)) {
+        case "AGGRESSIVE"_hash : def.flags.set(creature_flag::is_aggressive); break;
+        default:
+            break;
+        }
+    }
+}
+
+namespace {
+
+//! Wandering creatures move on 1 in wander_turns turns.
+constexpr int wander_turns = 3;
+
+//! How far, in blocks, the sound of a fight carries; see map::make_noise.
+constexpr int combat_noise_radius = 1;
+
+//! The time until @p c next wanders; rather than rolling every turn, roll how many turns to wait.
+bkrl::game_time wander_delay(bkrl::random_t& random, bkrl::creature const& c) noexcept {
+    bkrl::game_time turns = 1;
+    while (!bkrl::x_in_y_chance(random, 1, wander_turns)) {
+        ++turns;
+    }
+
+    return c.action_time(turns * bkrl::ticks_per_turn);
 }
 
+} //namespace
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // bkrl::creature
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -21,6 +53,12 @@ bool bkrl::creature::is_player() const noexcept
     return flags_.test(creature_flag::is_player);
 }
 
+//--------------------------------------------------------------------------------------------------
+bool bkrl::creature::is_aggressive() const noexcept
+{
+    return flags_.test(creature_flag::is_aggressive);
+}
+
 //--------------------------------------------------------------------------------------------------
 bool bkrl::creature::is_dead() const noexcept
 {
@@ -39,6 +77,13 @@ void bkrl::creature::move_to(bklib::ipoint2 const p) noexcept
     pos_ = p;
 }
 
+//--------------------------------------------------------------------------------------------------
+bkrl::game_time bkrl::creature::action_time(game_time const cost) const noexcept
+{
+    auto const speed = static_cast<game_time>(speed_);
+    return std::max(game_time {1}, (cost * static_cast<game_time>(speed_normal) + speed - 1) / speed);
+}
+
 //--------------------------------------------------------------------------------------------------
 bklib::ipoint2 bkrl::creature::position() const noexcept
 {
@@ -79,23 +124,7 @@ bool bkrl::creature::can_get_item(item const& i) const
 //--------------------------------------------------------------------------------------------------
 bool bkrl::creature::can_enter_terrain(terrain_entry const& ter) const
 {
-    switch (ter.type) {
-    case terrain_type::stair: BK_FALLTHROUGH
-    case terrain_type::empty: BK_FALLTHROUGH
-    case terrain_type::floor:
-        break;
-    case terrain_type::door:
-        if (!door {ter}.is_open()) {
-            return false;
-        }
-        break;
-    case terrain_type::wall: BK_FALLTHROUGH
-    case terrain_type::rock: BK_FALLTHROUGH
-    default:
-        return false;
-    }
-
-    return true;
+    return is_passable(ter);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -159,9 +188,42 @@ bkrl::creature::creature(
   , stats_ {}
   , items_ {}
   , flags_ (def.flags)
+  , speed_ {std::max(def.speed, int16_t {1})}
 {
 }
 
+//--------------------------------------------------------------------------------------------------
+void bkrl::creature::write(bklib::byte_writer& out) const
+{
+    out.write(id_);
+    out.write(def_);
+    out.write(pos_);
+    out.write(stats_);
+    out.write(flags_);
+    out.write(speed_);
+
+    items_.write(out);
+    equip_.write(out, items_);
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::creature bkrl::creature::read(bklib::byte_reader& in)
+{
+    creature result;
+
+    result.id_    = in.read<instance_id_t<tag_creature>>();
+    result.def_   = in.read<def_id_t<tag_creature>>();
+    result.pos_   = in.read<bklib::ipoint2>();
+    result.stats_ = in.read<creature_stats>();
+    result.flags_ = in.read<creature_flags>();
+    result.speed_ = in.read<int16_t>();
+
+    result.items_ = item_pile::read(in);
+    result.equip_.read(in, result.items_);
+
+    return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 int bkrl::creature::modify(stat_type const stat, int const mod)
 {
@@ -287,13 +349,21 @@ bool bkrl::move_by(context& ctx, creature& c, map& m, bklib::ivec2 const v)
         return false;
     }
 
-    auto const& ter = m.at(to);
-    if (!c.can_enter_terrain(ter)) {
+    if (!m.is_passable(to)) {
         return false;
     }
 
     if (auto const other = m.creature_at(to)) {
+        if (other->is_dead()) {
+            return true;
+        }
+
         attack(ctx, m, c, *other);
+
+        if (other->is_dead()) {
+            kill(ctx, m, *other);
+        }
+
         return true;
     }
 
@@ -305,12 +375,11 @@ bool bkrl::move_by(context& ctx, creature& c, map& m, bklib::ivec2 const v)
 //--------------------------------------------------------------------------------------------------
 void bkrl::attack(context& ctx, map& m, creature& att, creature& def)
 {
-    //TODO consider removing the m parameter
-
     auto const att_info = ctx.data.find(att.def());
     auto const def_info = ctx.data.find(def.def());
 
     def.modify(stat_type::health, -1);
+    m.make_noise(def.position(), combat_noise_radius);
 
     auto const att_name = att_info ? att_info->name.c_str() : "player";
     auto const def_name = def_info ? def_info->name.c_str() : "player";
@@ -318,41 +387,136 @@ void bkrl::attack(context& ctx, map& m, creature& att, creature& def)
 }
 
 //--------------------------------------------------------------------------------------------------
-void bkrl::advance(context& ctx, map& m, creature& c)
+bkrl::random_t bkrl::decision_random(uint64_t const seed, creature const& c) noexcept
 {
-    if (c.is_dead()) {
-        return;
-    }
+    return random_t {seed, uint64_t {static_cast<uint32_t>(c.id())}};
+}
 
-    if (c.is_player()) {
-        return;
+//--------------------------------------------------------------------------------------------------
+bkrl::creature_action bkrl::decide(map const& m, creature const& c, random_t& random)
+{
+    using type = creature_action::type;
+
+    creature_action result;
+
+    if (c.is_dead() || c.is_player()) {
+        return result;
     }
 
-    auto& random = ctx.random[random_stream::creature];
+    // within range of the player, head for it a step a turn, one step of a shortest path at a time
+    if (c.is_aggressive()) {
+        auto const v = m.player_distances().downhill(c.position());
+        if (abs_max(v) != 0) {
+            result.v     = v;
+            result.what  = type::chase;
+            result.delay = c.action_time(ticks_per_turn);
 
-    if (!x_in_y_chance(random, 1, 3)) {
-        return;
+            return result;
+        }
     }
 
-    bklib::ivec2 const v {
+    result.v = bklib::ivec2 {
         random_range(random, -1, 1)
       , random_range(random, -1, 1)
     };
 
-    move_by(ctx, c, m, v);
+    auto const to = c.position() + result.v;
+
+    result.what = (to == c.position() || !intersects(m.bounds(), to) || !m.is_passable(to))
+      ? type::wait
+      : type::step;
+
+    result.delay = wander_delay(random, c);
+
+    return result;
 }
 
 //--------------------------------------------------------------------------------------------------
-void bkrl::advance(context& ctx, map& m, creature_map& cmap)
+bkrl::game_time bkrl::apply(context& ctx, map& m, creature& c, creature_action const& action)
 {
-    cmap.for_each_data([&](creature& c) {
-        advance(ctx, m, c);
-    });
+    using type = creature_action::type;
 
-    cmap.remove_if(
-        [ ](bklib::ipoint2, creature const& c) { return c.is_dead(); }
-      , [&](bklib::ipoint2, creature&       c) { kill(ctx, m, c); }
-    );
+    auto const to = c.position() + action.v;
+
+    auto const hit = [&](creature& other) {
+        if (other.is_dead()) {
+            return;
+        }
+
+        attack(ctx, m, c, other);
+
+        if (other.is_dead()) {
+            kill(ctx, m, other);
+        }
+    };
+
+    // whoever is in the way now; the first applied takes a free spot
+    auto const other = (action.what == type::wait) ? nullptr : m.creature_at(to);
+
+    switch (action.what) {
+    case type::wait:
+        break;
+    case type::move:
+        if (!other) {
+            m.move_creature_to(c, to);
+        }
+        break;
+    case type::attack:
+        // if the target has moved off, or died, the blow misses
+        if (other) {
+            hit(*other);
+        }
+        break;
+    case type::step:
+        if (!other) {
+            m.move_creature_to(c, to);
+        } else {
+            hit(*other);
+        }
+        break;
+    case type::chase:
+        if (!other) {
+            m.move_creature_to(c, to);
+        } else if (other->is_player()) {
+            hit(*other);
+        }
+        break;
+    default:
+        BK_UNREACHABLE;
+    }
+
+    return action.delay;
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::game_time bkrl::catch_up(context& ctx, map& m, creature& c, game_time const elapsed)
+{
+    if (c.is_dead() || c.is_player()) {
+        return 0;
+    }
+
+    auto& random = ctx.random[random_stream::creature];
+
+    // a random walk of n steps ends up about sqrt(n) from where it started; rather than taking
+    // each step, walk about that far in a straight line, stopping at anything in the way.
+    auto const steps    = elapsed / c.action_time(wander_turns * ticks_per_turn);
+    auto const distance = static_cast<int>(std::sqrt(static_cast<double>(steps)));
+
+    bklib::ivec2 const v {
+        random_range(random, -1, 1)
+      , random_range(random, -1, 1)
+    };
+
+    for (auto n = random_range(random, 0, distance); n > 0; --n) {
+        auto const to = c.position() + v;
+        if (!intersects(to, m.bounds()) || !can_place_at(m, to, c)) {
+            break;
+        }
+
+        m.move_creature_to(c, to);
+    }
+
+    return wander_delay(random, c);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -362,6 +526,12 @@ void bkrl::kill(context& ctx, map& m, creature& c)
         BK_ASSERT(false); //TODO
     }
 
+    // the player stays where it fell; the game ends the run from there
+    if (c.is_player()) {
+        ctx.out.write("You die.");
+        return;
+    }
+
     auto const& name = c.friendly_name(ctx);
     ctx.out.write("The {} dies.", name);
 
@@ -15,6 +15,7 @@
 
 namespace bklib { template <typename T> class spatial_map_2d; }
 namespace bklib { template <typename T> class dictionary; }
+namespace bklib { class byte_writer; class byte_reader; }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 namespace bkrl {
@@ -27,8 +28,17 @@ class  creature;
 class  creature_factory;
 struct terrain_entry;
 using  creature_map = bklib::spatial_map_2d<creature>;
+using  creature_handle = bklib::tagged_value<creature_map, uint32_t>; //!< see bklib::spatial_map_handle
 using  creature_dictionary = bklib::dictionary<creature_def>;
 
+//--------------------------------------------------------------------------------------------------
+//! Game time in ticks. An action of normal cost by a creature of normal speed takes a turn.
+//--------------------------------------------------------------------------------------------------
+using game_time = uint64_t;
+
+constexpr game_time ticks_per_turn = 100;
+constexpr int16_t   speed_normal   = 100;
+
 //--------------------------------------------------------------------------------------------------
 //!
 //--------------------------------------------------------------------------------------------------
@@ -56,6 +66,7 @@ struct creature_def : definition_base {
     id_type        id;
     creature_flags flags;
     random_integer stat_hp;
+    int16_t        speed = speed_normal; //!< relative to speed_normal; > 0
 };
 
 void process_tags(creature_def& def);
@@ -179,11 +190,17 @@ public:
     bool is_player() const noexcept;
     bool is_dead() const noexcept;
 
+    //! Chases the player when it is near; see decide.
+    bool is_aggressive() const noexcept;
+
     void move_by(bklib::ivec2 v) noexcept;
     void move_to(bklib::ipoint2 p) noexcept;
 
     bklib::ipoint2 position() const noexcept;
 
+    //! The time taken by an action costing @p cost ticks at speed_normal.
+    game_time action_time(game_time cost) const noexcept;
+
     instance_id_t<tag_creature> id() const noexcept;
     def_id_t<tag_creature> def() const noexcept;
 
@@ -223,7 +240,14 @@ public:
     int current(stat_type stat) const noexcept;
 
     bklib::utf8_string friendly_name(context const& ctx) const;
+
+    //----------------------------------------------------------------------------------------------
+    //! Serialize, along with held and equipped items, for paging out (see map::enable_paging).
+    //----------------------------------------------------------------------------------------------
+    void write(bklib::byte_writer& out) const;
+    static creature read(bklib::byte_reader& in);
 private:
+    creature() = default;
     creature(instance_id_t<tag_creature> id, creature_def const& def, bklib::ipoint2 p);
 
     instance_id_t<tag_creature> id_;
@@ -233,6 +257,7 @@ private:
     item_pile            items_;
     equipment            equip_;
     creature_flags       flags_;
+    int16_t              speed_;
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -261,8 +286,45 @@ void kill(context& ctx, map& m, creature& c);
 item_pile* make_corpse(context& ctx, map& m, creature const& c);
 item_pile* drop_all(context& ctx, map& m, creature& c);
 
-void advance(context& ctx, map& m, creature& c);
-void advance(context& ctx, map& m, creature_map& cmap);
+//--------------------------------------------------------------------------------------------------
+//! What a creature has decided to do with its next action; see decide.
+//--------------------------------------------------------------------------------------------------
+struct creature_action {
+    enum class type : uint8_t {
+        wait
+      , move   //!< move by v if the spot is free
+      , attack //!< attack whoever is at v
+      , step   //!< move by v, or attack whoever is in the way
+      , chase  //!< move by v, or attack the player if they are in the way; wait for anyone else
+    };
+
+    type         what  = type::wait;
+    bklib::ivec2 v     = bklib::ivec2 {0, 0}; //!< the direction of a move or attack
+    game_time    delay = 0; //!< the time until the next action, or 0 if it shouldn't be scheduled again
+};
+
+//! The random stream for @p c's decisions in a round of actions started with @p seed. Each
+//! creature has a stream of its own, so its decisions don't depend on the order they are made in.
+random_t decision_random(uint64_t seed, creature const& c) noexcept;
+
+//--------------------------------------------------------------------------------------------------
+//! Decide on the next action for @p c. The map is only read, so many creatures can decide at once;
+//! and only the terrain is looked at, not who is where, so the decision is the same whether it is
+//! made before or after the actions of the others acting at the same time are applied. See apply.
+//--------------------------------------------------------------------------------------------------
+creature_action decide(map const& m, creature const& c, random_t& random);
+
+//--------------------------------------------------------------------------------------------------
+//! Carry out an @p action decided on for @p c, dealing with whoever is in the way now: a move into
+//! a spot someone has since taken does nothing, and an attack hits whoever is there now.
+//! @return the time until @p c should next act, or 0 if it shouldn't be scheduled again.
+//--------------------------------------------------------------------------------------------------
+game_time apply(context& ctx, map& m, creature& c, creature_action const& action);
+
+//! Catch @p c up on @p elapsed ticks spent dormant (see map::set_activity_radius) in a single step
+//! that roughly matches the actions it would have taken.
+//! @return as for apply.
+game_time catch_up(context& ctx, map& m, creature& c, game_time elapsed);
 
 bool has_tag(creature_def const& def, def_id_t<tag_string_tag> tag);
 bool has_tag(creature const& c, creature_dictionary const& defs, def_id_t<tag_string_tag> tag);
@@ -0,0 +1,398 @@
+#include "distance_map.hpp"
+#include "map.hpp"
+#include "direction.hpp"
+
+#include "bklib/assert.hpp"
+
+#include <algorithm>
+
+namespace {
+
+//! The direction from a cell to the neighbour in direction @p d of it, and back.
+constexpr uint8_t opposite(uint32_t const d) noexcept {
+    return static_cast<uint8_t>(7u - d);
+}
+
+constexpr uint32_t step_cost(uint32_t const d) noexcept {
+    return (bkrl::x_off[d] && bkrl::y_off[d]) ? bkrl::path_cost_diagonal : bkrl::path_cost_straight;
+}
+
+template <typename Container, typename T>
+bool erase_value(Container& c, T const& value) {
+    auto const it = std::find(begin(c), end(c), value);
+    if (it == end(c)) {
+        return false;
+    }
+
+    c.erase(it);
+    return true;
+}
+
+} //namespace
+
+constexpr uint32_t bkrl::distance_map::unreachable;
+constexpr uint8_t  bkrl::distance_map::no_parent;
+constexpr uint8_t  bkrl::distance_map::blocked;
+constexpr uint32_t bkrl::distance_map::queue_size;
+
+//--------------------------------------------------------------------------------------------------
+bkrl::distance_map::distance_map(int const range)
+  : range_ {range}
+  , max_distance_ {range > 0
+      ? static_cast<uint32_t>(range) * path_cost_straight
+      : unreachable - 1}
+{
+    BK_PRECONDITION(range >= 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::distance_map::~distance_map() = default;
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::add_goal(bklib::ipoint2 const p)
+{
+    if (is_goal_(p)) {
+        return;
+    }
+
+    goals_.push_back(p);
+
+    if (!erase_value(removed_, p)) {
+        added_.push_back(p);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::remove_goal(bklib::ipoint2 const p)
+{
+    if (!erase_value(goals_, p)) {
+        return;
+    }
+
+    if (!erase_value(added_, p)) {
+        removed_.push_back(p);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::move_goal(bklib::ipoint2 const from, bklib::ipoint2 const to)
+{
+    if (from != to) {
+        remove_goal(from);
+        add_goal(to);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::clear_goals()
+{
+    while (!goals_.empty()) {
+        remove_goal(goals_.back());
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::update(map const& m)
+{
+    changed_ = 0;
+
+    auto const window = window_(m);
+
+    if (passable_.bits().empty() || window != passable_.bounds()) {
+        passable_.copy(m, window);
+        added_.clear();
+        removed_.clear();
+        rebuild_();
+        return;
+    }
+
+    // the bits of the last copy are only kept (swapped out) if there is a new one to diff
+    terrain_changes_.clear();
+    if (passable_.copy(m, window, previous_)) {
+        passable_.differences(previous_, terrain_changes_);
+    }
+
+    // first everything that can only lower distances, along with newly impassable cells; the
+    // removed goals are still goals. Lowering first means that when a goal moves a step, only the
+    // cells still nearer the old position than the new need raising.
+    invalid_.clear();
+    for (auto const p : terrain_changes_) {
+        auto const i = index_of_(p);
+        if (passable_.is_passable(x(p), y(p))) {
+            parent_[i] = no_parent;
+        } else {
+            parent_[i] = blocked;
+            invalid_.push_back(i);
+        }
+    }
+
+    raise_();
+
+    for (auto const p : terrain_changes_) {
+        auto const i = index_of_(p);
+        if (parent_[i] == blocked) {
+            continue;
+        }
+
+        if (is_goal_(p)) {
+            lower_(i, 0, no_parent);
+        } else {
+            relax_from_neighbours_(i);
+        }
+    }
+
+    for (auto const p : added_) {
+        if (intersects(passable_.bounds(), p) && parent_[index_of_(p)] != blocked) {
+            lower_(index_of_(p), 0, no_parent);
+        }
+    }
+
+    propagate_();
+
+    // then the removed goals
+    invalid_.clear();
+    for (auto const p : removed_) {
+        if (intersects(passable_.bounds(), p)) {
+            invalid_.push_back(index_of_(p));
+        }
+    }
+
+    raise_();
+    propagate_();
+
+    added_.clear();
+    removed_.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::rebuild_()
+{
+    auto const r = passable_.bounds();
+
+    width_ = r.width() + 2;
+    for (auto d = 0u; d < 8u; ++d) {
+        step_[d] = y_off[d] * width_ + x_off[d];
+    }
+
+    auto const cells = static_cast<size_t>(width_) * static_cast<size_t>(r.height() + 2);
+    distance_.assign(cells, unreachable);
+    parent_.assign(cells, blocked);
+
+    for (int y = r.top; y < r.bottom; ++y) {
+        for (int x = r.left; x < r.right; ++x) {
+            if (passable_.is_passable(x, y)) {
+                parent_[index_of_(bklib::ipoint2 {x, y})] = no_parent;
+            }
+        }
+    }
+
+    for (auto const p : goals_) {
+        if (intersects(r, p) && parent_[index_of_(p)] != blocked) {
+            lower_(index_of_(p), 0, no_parent);
+        }
+    }
+
+    propagate_();
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::raise_()
+{
+    for (auto const i : invalid_) {
+        if (distance_[i] != unreachable) {
+            ++changed_;
+        }
+
+        distance_[i] = unreachable;
+        if (parent_[i] != blocked) {
+            parent_[i] = no_parent;
+        }
+    }
+
+    // and every cell whose parent is one of them; invalid_ grows as it is walked
+    for (size_t k = 0; k < invalid_.size(); ++k) {
+        auto const i = invalid_[k];
+
+        for (auto d = 0u; d < 8u; ++d) {
+            auto const j = static_cast<uint32_t>(static_cast<int>(i) + step_[d]);
+            if (parent_[j] != opposite(d)) {
+                continue;
+            }
+
+            distance_[j] = unreachable;
+            parent_[j]   = no_parent;
+            invalid_.push_back(j);
+            ++changed_;
+        }
+    }
+
+    // the cells bordering those left reachable know the way now
+    for (auto const i : invalid_) {
+        if (parent_[i] != blocked) {
+            relax_from_neighbours_(i);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::relax_from_neighbours_(uint32_t const i)
+{
+    auto    best   = distance_[i];
+    uint8_t parent = no_parent;
+
+    for (auto d = 0u; d < 8u; ++d) {
+        auto const j = static_cast<uint32_t>(static_cast<int>(i) + step_[d]);
+        if (parent_[j] == blocked || distance_[j] == unreachable) {
+            continue;
+        }
+
+        auto const nd = distance_[j] + step_cost(d);
+        if (nd < best) {
+            best   = nd;
+            parent = static_cast<uint8_t>(d);
+        }
+    }
+
+    if (parent != no_parent && best <= max_distance_) {
+        lower_(i, best, parent);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::lower_(uint32_t const i, uint32_t const d, uint8_t const parent)
+{
+    distance_[i] = d;
+    parent_[i]   = parent;
+    seeds_.push_back(seed_t {d, i});
+    ++changed_;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::distance_map::propagate_()
+{
+    std::sort(begin(seeds_), end(seeds_), [](seed_t const& a, seed_t const& b) noexcept {
+        return a.d < b.d;
+    });
+
+    size_t   next   = 0;
+    size_t   queued = 0;
+    uint32_t d      = 0;
+
+    for (;; ++d) {
+        if (queued == 0) {
+            if (next == seeds_.size()) {
+                break;
+            }
+
+            d = seeds_[next].d;
+        }
+
+        for (; next < seeds_.size() && seeds_[next].d == d; ++next) {
+            bucket_(d).push_back(seeds_[next].index);
+            ++queued;
+        }
+
+        auto& bucket = bucket_(d);
+        while (!bucket.empty()) {
+            auto const i = bucket.back();
+            bucket.pop_back();
+            --queued;
+
+            if (distance_[i] != d) {
+                continue; // stale; lowered since
+            }
+
+            for (auto dir = 0u; dir < 8u; ++dir) {
+                auto const j  = static_cast<uint32_t>(static_cast<int>(i) + step_[dir]);
+                auto const nd = d + step_cost(dir);
+                if (parent_[j] == blocked || nd >= distance_[j] || nd > max_distance_) {
+                    continue;
+                }
+
+                distance_[j] = nd;
+                parent_[j]   = opposite(dir);
+                bucket_(nd).push_back(j);
+                ++queued;
+                ++changed_;
+            }
+        }
+    }
+
+    seeds_.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+uint32_t bkrl::distance_map::distance(bklib::ipoint2 const p) const noexcept
+{
+    return intersects(passable_.bounds(), p)
+      ? distance_[index_of_(p)]
+      : unreachable;
+}
+
+//--------------------------------------------------------------------------------------------------
+bklib::ivec2 bkrl::distance_map::downhill(bklib::ipoint2 const p) const noexcept
+{
+    if (!intersects(passable_.bounds(), p)) {
+        return {0, 0};
+    }
+
+    auto const d = parent_[index_of_(p)];
+    return d >= no_parent
+      ? bklib::ivec2 {0, 0}
+      : bklib::ivec2 {x_off[d], y_off[d]};
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::distance_map::is_goal_(bklib::ipoint2 const p) const noexcept
+{
+    return std::find(begin(goals_), end(goals_), p) != end(goals_);
+}
+
+//--------------------------------------------------------------------------------------------------
+bklib::irect bkrl::distance_map::window_(map const& m) const noexcept
+{
+    auto const bounds = m.bounds();
+    if (range_ <= 0) {
+        return bounds;
+    }
+
+    // everything within range of a goal in bounds; a step moves at most a cell in each direction
+    // and costs at least path_cost_straight
+    bklib::irect needed;
+    auto first  = true;
+
+    for (auto const p : goals_) {
+        if (!intersects(bounds, p)) {
+            continue;
+        }
+
+        auto const r = bklib::irect {x(p) - range_, y(p) - range_, x(p) + range_ + 1, y(p) + range_ + 1};
+        if (first) {
+            needed = r;
+            first  = false;
+        } else {
+            needed.left   = std::min(needed.left,   r.left);
+            needed.top    = std::min(needed.top,    r.top);
+            needed.right  = std::max(needed.right,  r.right);
+            needed.bottom = std::max(needed.bottom, r.bottom);
+        }
+    }
+
+    // nothing in range of anything
+    if (first) {
+        return bklib::irect {bounds.left, bounds.top, bounds.left, bounds.top};
+    }
+
+    needed = intersection(needed, bounds);
+
+    auto const current = passable_.bounds();
+    if (!passable_.bits().empty()
+     && intersection(current, bounds) == current
+     && intersection(current, needed) == needed
+    ) {
+        return current;
+    }
+
+    auto const slack = static_cast<int>(size_block);
+    return intersection(round_to_blocks(bklib::add_border(needed, slack)), bounds);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "path.hpp"
+
+#include "bklib/math.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace bkrl {
+
+class map;
+
+//--------------------------------------------------------------------------------------------------
+//! The distance from every cell within range of a set of goals (the player, stairs, items, ...) to
+//! the nearest of them over the passable terrain, and the first step of a shortest path there; a
+//! "Dijkstra map". Steps are as for path_finder: to any of the 8 neighbouring cells, diagonal steps
+//! costing path_cost_diagonal and straight ones path_cost_straight.
+//!
+//! Creatures heading for a goal read the step to take in O(1) rather than each searching for a path
+//! of their own. Changes to the goals and to the terrain are applied by update(), which only
+//! recomputes the cells whose distance they could change: cells closer to a new goal (or through a
+//! newly passable cell) than before, and those whose shortest path went through a removed goal (or
+//! a newly impassable cell). For a single goal that moves, that is most of the cells in range, so
+//! the range is best limited to as far as anything will follow the goal from.
+//!
+//! Only a window of the map is kept: the whole blocks around the bounding box of the goals, grown by
+//! the range (the whole of the map's bounds if the range is unlimited), and a block more on each
+//! side so that goals can move a little before it has to move too; about 5 bytes a cell of it.
+//! Besides copying a bit a cell of the window's passability once the terrain has been written to,
+//! the cost of update() depends on the number of distances changed rather than on the size of the
+//! map or window; but for the first update(), or any after the window moves, which computes
+//! everything in the new window. Reading from several threads at once is fine, as long as none of
+//! them is updating.
+//--------------------------------------------------------------------------------------------------
+class distance_map {
+public:
+    static constexpr uint32_t unreachable = std::numeric_limits<uint32_t>::max();
+
+    //! @param range Only cells within this many (straight) steps of a goal get a distance; 0 for no
+    //!        limit.
+    explicit distance_map(int range = 0);
+    ~distance_map();
+
+    distance_map(distance_map const&) = delete;
+    distance_map& operator=(distance_map const&) = delete;
+
+    //! Add a goal at @p p; nothing if there already is one. Takes effect on the next update().
+    void add_goal(bklib::ipoint2 p);
+
+    //! Remove the goal at @p p; nothing if there is none. Takes effect on the next update().
+    void remove_goal(bklib::ipoint2 p);
+
+    //! Move the goal at @p from to @p to, or add it if there is none.
+    void move_goal(bklib::ipoint2 from, bklib::ipoint2 to);
+
+    void clear_goals();
+
+    std::vector<bklib::ipoint2> const& goals() const noexcept {
+        return goals_;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Bring the distances up to date with the goals and with the terrain of @p m. Goals outside of
+    //! the bounds of @p m, or on impassable cells, are ignored until they are on passable ones.
+    //! Everything is recomputed the first time, or if the window (see above) has to move.
+    //----------------------------------------------------------------------------------------------
+    void update(map const& m);
+
+    //! The distance from @p p to the nearest goal in steps of path_cost_straight and
+    //! path_cost_diagonal, as of the last update(); unreachable if there is none within range.
+    uint32_t distance(bklib::ipoint2 p) const noexcept;
+
+    //! The step from @p p towards the nearest goal, as of the last update(); {0, 0} at a goal, or if
+    //! there is none within range.
+    bklib::ivec2 downhill(bklib::ipoint2 p) const noexcept;
+
+    //! How many times the last update() changed the distance of a cell; a measure of its cost.
+    size_t changed() const noexcept {
+        return changed_;
+    }
+private:
+    //! The cells within range are a shortest path tree; each points at its parent, the neighbour a
+    //! shortest path goes through next. Goals, and unreachable cells, have no parent; impassable
+    //! cells are blocked.
+    static constexpr uint8_t no_parent = 8;
+    static constexpr uint8_t blocked   = 9;
+
+    //! The cells are laid out as passable_grid lays out its bits, border and all, so a neighbour is
+    //! always a fixed offset away; the border is blocked.
+    uint32_t index_of_(bklib::ipoint2 const p) const noexcept {
+        auto const r = passable_.bounds();
+        return static_cast<uint32_t>((y(p) - r.top + 1) * width_ + (x(p) - r.left + 1));
+    }
+
+    bool is_goal_(bklib::ipoint2 p) const noexcept;
+
+    //! The window to keep for the goals and the bounds of @p m; the current one if it still covers
+    //! everything within range.
+    bklib::irect window_(map const& m) const noexcept;
+
+    //! Recompute everything.
+    void rebuild_();
+
+    //! Make the cells at invalid_ unreachable, along with every cell whose shortest path went
+    //! through one of them, then give those that can still reach a goal the distance through their
+    //! neighbours.
+    void raise_();
+
+    //! Give the cell at @p i the shortest distance through any of its neighbours, if that is less
+    //! than it has and within range.
+    void relax_from_neighbours_(uint32_t i);
+
+    //! Set the distance of the cell at @p i, and seed propagate_() with it.
+    void lower_(uint32_t i, uint32_t d, uint8_t parent);
+
+    //! Dijkstra from the seeded cells, lowering the distance of their neighbours.
+    void propagate_();
+
+    struct seed_t {
+        uint32_t d;
+        uint32_t index;
+    };
+
+    //! Steps cost at most path_cost_diagonal, so while propagating every queued distance is within
+    //! that of the lowest, and a ring of buckets by distance is a priority queue. The seeds can be
+    //! further apart; they are sorted, and join the queue as it reaches their distance.
+    static constexpr uint32_t queue_size = path_cost_diagonal + 1;
+
+    std::vector<uint32_t>& bucket_(uint32_t const d) noexcept {
+        return queue_[d % queue_size];
+    }
+
+    int      range_;
+    uint32_t max_distance_;
+
+    int width_ = 0;   //!< passable_.bounds().width() + 2
+    int step_[8] {};  //!< the offset of the neighbour in each direction
+
+    std::vector<bklib::ipoint2> goals_;
+    std::vector<bklib::ipoint2> added_;   //!< goals added since the last update
+    std::vector<bklib::ipoint2> removed_; //!< goals removed since the last update
+
+    passable_grid         passable_;      //!< the window; see window_
+    std::vector<uint64_t> previous_;      //!< passable_ as of the last update
+
+    std::vector<bklib::ipoint2> terrain_changes_; //!< cells whose passability changed
+
+    std::vector<uint32_t> distance_;      //!< one per cell of the window and its border
+    std::vector<uint8_t>  parent_;        //!< the same; an index into x_off and y_off, or the above
+
+    std::vector<uint32_t> invalid_;       //!< cells to raise
+    std::vector<seed_t>   seeds_;
+    std::vector<uint32_t> queue_[queue_size];
+
+    size_t changed_ = 0;
+};
+
+} //namespace bkrl
@@ -4,6 +4,7 @@
 #include "bklib/assert.hpp"
 #include "bklib/flag_set.hpp"
 #include "bklib/algorithm.hpp"
+#include "bklib/byte_stream.hpp"
 
 namespace {
 
@@ -234,3 +235,31 @@ bkrl::equipment::find_slot_(equip_slot const slot) const
         return s.type == slot;
     });
 }
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::equipment::write(bklib::byte_writer& out, item_pile const& items) const
+{
+    for (auto const& slot : slots_) {
+        auto index = int32_t {-1};
+
+        if (slot.itm) {
+            auto const it = std::find_if(std::begin(items), std::end(items), [&](item const& i) {
+                return &i == slot.itm;
+            });
+
+            BK_PRECONDITION(it != std::end(items));
+            index = static_cast<int32_t>(std::distance(std::begin(items), it));
+        }
+
+        out.write(index);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::equipment::read(bklib::byte_reader& in, item_pile& items)
+{
+    for (auto& slot : slots_) {
+        auto const index = in.read<int32_t>();
+        slot.itm = (index < 0) ? nullptr : &items.advance(index);
+    }
+}
@@ -7,6 +7,8 @@
 #include <vector>
 #include <cstdint>
 
+namespace bklib { class byte_writer; class byte_reader; }
+
 namespace bkrl {
 
 enum class equip_result_t : int {
@@ -82,6 +84,13 @@ public:
 
     template <typename Predicate>
     void unequip(Predicate&& predicate);
+
+    //----------------------------------------------------------------------------------------------
+    //! Serialize which of @p items, the items held by the owner, are in each slot; read points the
+    //! slots back into the equivalent pile.
+    //----------------------------------------------------------------------------------------------
+    void write(bklib::byte_writer& out, item_pile const& items) const;
+    void read(bklib::byte_reader& in, item_pile& items);
 private:
     slot_t const* find_slot_(equip_slot const slot) const;
 
@@ -12,7 +12,9 @@
 #include "map.hpp"
 #include "message_log.hpp"
 #include "output.hpp"
+#include "profiler.hpp"
 #include "random.hpp"
+#include "render_list.hpp"
 #include "renderer.hpp"
 #include "system.hpp"
 #include "text.hpp"
@@ -22,10 +24,17 @@
 #include "bklib/math.hpp"
 #include "bklib/scope_guard.hpp"
 #include "bklib/string.hpp"
+#include "bklib/swap_buffer.hpp"
 #include "bklib/timer.hpp"
 
-namespace bkrl {
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
 
+namespace bkrl {
 
 /////////////////////////
 
@@ -98,6 +107,15 @@ private:
 
 //--------------------------------------------------------------------------------------------------
 // Game simulation state.
+//
+// The simulation runs on its own thread: input from the system is posted to it as jobs, and each
+// frame it records into a render_list which is handed to the main thread to be replayed against
+// the renderer. A slow turn delays the next frame's contents, but not event handling or
+// presentation, and vice versa.
+//
+// Nothing is polled: a frame is recorded only when something has invalidated the last one (see
+// force_render_), and otherwise the simulation sleeps until the next job or timer deadline while
+// the main thread sleeps until the next event or frame.
 //--------------------------------------------------------------------------------------------------
 class game {
 public:
@@ -143,7 +161,8 @@ public:
 
     //----------------------------------------------------------------------------------------------
     void do_quit() {
-        system_->quit();
+        quit_requested_ = true;
+        system_->wake();
     }
 
     //----------------------------------------------------------------------------------------------
@@ -181,6 +200,12 @@ public:
     void on_show_equipment();
     void do_show_equipment();
 
+    //----------------------------------------------------------------------------------------------
+    void on_toggle_profiler() {
+        show_profiler_ = !show_profiler_;
+        force_render_();
+    }
+
     command_handler_result on_command(command const& cmd);
     void on_command_result(command_type cmd, command_result result);
 
@@ -199,6 +224,23 @@ private:
     void force_render_() {
         render_flag_ = render_type::force_update;
     }
+
+    //! Run @p job on the simulation thread.
+    template <typename Job>
+    void post_(Job&& job) {
+        {
+            std::lock_guard<std::mutex> lock {jobs_mutex_};
+            jobs_.emplace_back(std::forward<Job>(job));
+        }
+
+        jobs_cv_.notify_one();
+    }
+
+    void run_simulation_() noexcept;
+    void stop_simulation_() noexcept;
+
+    //! Replay the most recent frame from the simulation, if there is a new one.
+    void present_();
 private:
     bklib::timer        timer_;
     random_state        random_;
@@ -218,8 +260,6 @@ private:
     output              output_;
     std::unique_ptr<inventory> inventory_;
 
-    std::chrono::high_resolution_clock::time_point last_frame_;
-
     key_mod_state  prev_key_mods_ = system_->current_key_mods();
 
     //! The last screen position of the mouse
@@ -233,7 +273,22 @@ private:
 
     map_inspect_message inspect_message_;
 
+    std::unique_ptr<profiler_overlay> profiler_overlay_;
+    bool show_profiler_ = false;
+
     context ctx_;
+
+    //! Frames recorded by the simulation thread (the writer) for the main thread (the reader).
+    bklib::swap_buffer<std::unique_ptr<render_list>> frames_ {make_render_list};
+
+    std::mutex                         jobs_mutex_;
+    std::condition_variable            jobs_cv_;
+    std::vector<std::function<void()>> jobs_;     //!< guarded by jobs_mutex_
+    bool                               stopping_ = false; //!< guarded by jobs_mutex_
+
+    std::atomic<bool>  quit_requested_ {false};
+    std::atomic<bool>  simulation_stopped_ {false};
+    std::exception_ptr simulation_error_;
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -247,6 +302,53 @@ inline decltype(auto) random_definition(random_t& random, bklib::dictionary<T> c
 
 namespace {
 
+//--------------------------------------------------------------------------------------------------
+//! Whether @p cmd can end up advancing the game.
+bool takes_turn(bkrl::command_type const cmd) noexcept
+{
+    using ct = bkrl::command_type;
+
+    switch (cmd) {
+    case ct::use:            BK_FALLTHROUGH
+    case ct::dir_here:       BK_FALLTHROUGH
+    case ct::dir_north:      BK_FALLTHROUGH
+    case ct::dir_south:      BK_FALLTHROUGH
+    case ct::dir_east:       BK_FALLTHROUGH
+    case ct::dir_west:       BK_FALLTHROUGH
+    case ct::dir_n_west:     BK_FALLTHROUGH
+    case ct::dir_n_east:     BK_FALLTHROUGH
+    case ct::dir_s_west:     BK_FALLTHROUGH
+    case ct::dir_s_east:     BK_FALLTHROUGH
+    case ct::dir_up:         BK_FALLTHROUGH
+    case ct::dir_down:       BK_FALLTHROUGH
+    case ct::open:           BK_FALLTHROUGH
+    case ct::close:          BK_FALLTHROUGH
+    case ct::get:            BK_FALLTHROUGH
+    case ct::drop:           BK_FALLTHROUGH
+    case ct::show_equipment: BK_FALLTHROUGH
+    case ct::show_inventory:
+        return true;
+    case ct::none:             BK_FALLTHROUGH
+    case ct::raw:              BK_FALLTHROUGH
+    case ct::text:             BK_FALLTHROUGH
+    case ct::invalid:          BK_FALLTHROUGH
+    case ct::scroll:           BK_FALLTHROUGH
+    case ct::zoom:             BK_FALLTHROUGH
+    case ct::center_on_player: BK_FALLTHROUGH
+    case ct::cancel:           BK_FALLTHROUGH
+    case ct::confirm:          BK_FALLTHROUGH
+    case ct::yes:              BK_FALLTHROUGH
+    case ct::no:               BK_FALLTHROUGH
+    case ct::quit:             BK_FALLTHROUGH
+    case ct::toggle_profiler:
+        return false;
+    default:
+        break;
+    }
+
+    return false;
+}
+
 //--------------------------------------------------------------------------------------------------
 bkrl::definitions load_definitions(
     bkrl::creature_dictionary& creatures
@@ -266,7 +368,20 @@ bkrl::definitions load_definitions(
 std::unique_ptr<bkrl::map> generate_map(bkrl::context& ctx)
 {
     using namespace bkrl;
-    return std::make_unique<map>(ctx);
+
+    // creatures further than this many blocks from the player, and from any noise, are dormant;
+    // enough to cover the view at the default zoom.
+    constexpr int activity_radius = 4;
+
+    // creatures decide on the simulation thread and these; leave one for the main thread
+    auto const threads = std::thread::hardware_concurrency();
+    auto const workers = threads > 2 ? threads - 2 : 0u;
+
+    auto result = std::make_unique<map>(ctx);
+    result->set_activity_radius(activity_radius);
+    result->set_worker_count(workers);
+
+    return result;
 }
 
 } //namespace
@@ -296,9 +411,9 @@ bkrl::game::game()
   , current_map_ {nullptr}
   , output_ {}
   , inventory_ {make_item_list(*text_renderer_)}
-  , last_frame_ {std::chrono::high_resolution_clock::now()}
   , message_log_ {make_message_log(*text_renderer_)}
   , inspect_message_ {*text_renderer_, bklib::irect {0, 0, system_->client_width(), system_->client_height()}}
+  , profiler_overlay_ {make_profiler_overlay(*text_renderer_)}
   , ctx_ (make_context())
 {
     //
@@ -328,16 +443,23 @@ bkrl::game::game()
         on_command_result(cmd, result);
     });
 
+    //
+    // system callbacks are made on this (the main) thread; anything touching the game's state is
+    // posted to the simulation thread.
+    //
     system_->on_window_resize = [&](int const w, int const h) {
-        view_.set_window_size(w, h);
+        post_([&, w, h] {
+            view_.set_window_size(w, h);
+        });
     };
 
     system_->on_text_input = [&](bklib::utf8_string_view const str) {
-        command_translator_->on_text(str);
+        post_([&, text = str.to_string()] {
+            command_translator_->on_text(text);
+        });
     };
 
-    auto const check_key_mods_changed = [&] {
-        auto const cur = system_->current_key_mods();
+    auto const check_key_mods_changed = [&](key_mod_state const cur) {
         if (cur == prev_key_mods_) {
             return;
         }
@@ -349,48 +471,60 @@ bkrl::game::game()
     };
 
     system_->on_key_up = [&](int const key) {
-        check_key_mods_changed();
-        command_translator_->on_key_up(key, prev_key_mods_);
+        post_([&, key, mods = system_->current_key_mods()] {
+            check_key_mods_changed(mods);
+            command_translator_->on_key_up(key, prev_key_mods_);
+        });
     };
 
     system_->on_key_down = [&](int const key) {
-        check_key_mods_changed();
-        command_translator_->on_key_down(key, prev_key_mods_);
+        post_([&, key, mods = system_->current_key_mods()] {
+            check_key_mods_changed(mods);
+            command_translator_->on_key_down(key, prev_key_mods_);
+        });
     };
 
     system_->on_mouse_motion = [&](mouse_state const m) {
-        if (inventory_->on_mouse_move(m)) {
-            return;
-        }
+        post_([&, m] {
+            if (inventory_->on_mouse_move(m)) {
+                return;
+            }
 
-        if (m.is_down(mouse_button::right)) {
-            on_scroll(m.dx, m.dy);
-        } else {
-            on_mouse_over(m.x, m.y);
-        }
+            if (m.is_down(mouse_button::right)) {
+                on_scroll(m.dx, m.dy);
+            } else {
+                on_mouse_over(m.x, m.y);
+            }
+        });
     };
 
     system_->on_mouse_scroll = [&](mouse_state const m) {
-        if (inventory_->on_mouse_scroll(m)) {
-            return;
-        }
+        post_([&, m] {
+            if (inventory_->on_mouse_scroll(m)) {
+                return;
+            }
 
-        if (m.sy > 0) {
-            on_zoom(0.1, 0.1);
-        } else if (m.sy < 0) {
-            on_zoom(-0.1, -0.1);
-        }
+            if (m.sy > 0) {
+                on_zoom(0.1, 0.1);
+            } else if (m.sy < 0) {
+                on_zoom(-0.1, -0.1);
+            }
+        });
     };
 
     system_->on_mouse_button = [&](mouse_button_state const m) {
-        if (inventory_->on_mouse_button(m)) {
-            return;
-        }
+        post_([&, m] {
+            inventory_->on_mouse_button(m);
+        });
     };
 
+    // the prompt decides; see do_quit
     system_->on_request_quit = [&] {
-        on_quit();
-        return !system_->is_running();
+        post_([&] {
+            on_quit();
+        });
+
+        return false;
     };
 
     ////
@@ -400,11 +534,101 @@ bkrl::game::game()
         message_log_->show(message_log::show_type::less);
     });
 
-    while (system_->is_running()) {
-        system_->do_events_wait();
-        timer_.update();
-        render();
+    force_render_();
+
+    {
+        std::thread simulation {[&] { run_simulation_(); }};
+        BK_SCOPE_EXIT {
+            stop_simulation_();
+            simulation.join();
+        };
+
+        // the simulation wakes this thread up for each new frame
+        while (system_->is_running() && !simulation_stopped_) {
+            system_->do_events_wait();
+
+            if (quit_requested_) {
+                system_->quit();
+            }
+
+            present_();
+        }
+    }
+
+    if (simulation_error_) {
+        std::rethrow_exception(simulation_error_);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::game::run_simulation_() noexcept
+{
+    try {
+        std::vector<std::function<void()>> jobs;
+
+        for (;;) {
+            render();
+
+            {
+                std::unique_lock<std::mutex> lock {jobs_mutex_};
+                auto const ready = [&] { return stopping_ || !jobs_.empty(); };
+
+                if (timer_.empty()) {
+                    jobs_cv_.wait(lock, ready);
+                } else {
+                    jobs_cv_.wait_until(lock, timer_.next_deadline(), ready);
+                }
+
+                if (stopping_) {
+                    break;
+                }
+
+                jobs.swap(jobs_);
+            }
+
+            // input can change anything that is visible
+            if (!jobs.empty()) {
+                force_render_();
+            }
+
+            for (auto& job : jobs) {
+                job();
+            }
+
+            jobs.clear();
+
+            if (timer_.update() > 0) {
+                force_render_();
+            }
+        }
+    } catch (...) {
+        simulation_error_ = std::current_exception();
+    }
+
+    simulation_stopped_ = true;
+    system_->wake();
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::game::stop_simulation_() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock {jobs_mutex_};
+        stopping_ = true;
+    }
+
+    jobs_cv_.notify_one();
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::game::present_()
+{
+    if (!frames_.acquire()) {
+        return;
     }
+
+    frames_.front()->replay(*renderer_);
+    renderer_->present();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -439,39 +663,63 @@ void bkrl::game::generate_map()
 //--------------------------------------------------------------------------------------------------
 void bkrl::game::render()
 {
-    using namespace std::chrono_literals;
-    constexpr auto const frame_time = std::chrono::duration_cast<std::chrono::nanoseconds>(1s) / 60;
-
-    auto const now = std::chrono::high_resolution_clock::now();
-    if (render_flag_ == render_type::wait && now < last_frame_ + frame_time) {
+    if (render_flag_ == render_type::wait) {
         return;
     }
 
-    last_frame_ = now;
     render_flag_ = render_type::wait;
 
-    renderer_->clear();
-    renderer_->clear_clip_region();
+    // recorded here, on the simulation thread; see present_
+    auto& render = *frames_.back();
+    render.reset();
 
-    auto const scale = view_.get_zoom();
-    auto const trans = view_.get_scroll();
+    {
+        BK_PROFILE_ZONE(frame);
 
-    renderer_->set_scale(x(scale), y(scale));
-    renderer_->set_translation(x(trans), y(trans));
+        render.clear();
+        render.clear_clip_region();
 
-    current_map().draw(*renderer_, view_);
+        auto const scale = view_.get_zoom();
+        auto const trans = view_.get_scroll();
 
-    message_log_->draw(*renderer_);
-    inventory_->draw(*renderer_);
-    inspect_message_.draw(*renderer_);
+        render.set_scale(x(scale), y(scale));
+        render.set_translation(x(trans), y(trans));
 
-    renderer_->present();
+        current_map().draw(render, view_);
+
+        message_log_->draw(render);
+        inventory_->draw(render);
+        inspect_message_.draw(render);
+
+        // shows the previous frame; the overlay itself counts towards this one
+        if (show_profiler_) {
+            profiler_overlay_->draw(render, profiler::get());
+        }
+    }
+
+    BK_PROFILE_COUNT(draw_calls, render.size());
+    BK_PROFILE_COMMIT(frame);
+    BK_PROFILE_COMMIT(draw_calls);
+    BK_PROFILE_COMMIT(text_layout);
+
+    frames_.publish();
+    system_->wake();
 }
 
 //--------------------------------------------------------------------------------------------------
 void bkrl::game::advance()
 {
-    bkrl::advance(ctx_, current_map());
+    {
+        BK_PROFILE_ZONE(turn);
+        bkrl::advance(ctx_, current_map());
+    }
+
+    // render data updated outside of a turn, by the player say, counts towards the next one
+    BK_PROFILE_COMMIT(turn);
+    BK_PROFILE_COMMIT(creatures);
+    BK_PROFILE_COMMIT(items);
+    BK_PROFILE_COMMIT(render_data);
+
     force_render_();
 }
 
@@ -518,8 +766,8 @@ void bkrl::game::on_zoom(double const zx, double const zy)
 //--------------------------------------------------------------------------------------------------
 void bkrl::game::do_zoom(double const zx, double const zy)
 {
-    auto const w = system_->client_width();
-    auto const h = system_->client_height();
+    auto const w = view_.window_w();
+    auto const h = view_.window_h();
     auto const p = view_.screen_to_world_as(w / 2.0, h / 2.0);
     auto const z = view_.get_zoom();
 
@@ -710,6 +958,12 @@ bkrl::equip_result_t bkrl::equip_item(
 //--------------------------------------------------------------------------------------------------
 bkrl::command_handler_result bkrl::game::on_command(command const& cmd)
 {
+    // a dead player can still look around and quit, but takes no more turns
+    if (get_player().is_dead() && takes_turn(cmd.type)) {
+        display_message("You are dead.");
+        return command_handler_result::capture;
+    }
+
     switch (cmd.type) {
     case command_type::none:    break;
     case command_type::raw:     break;
@@ -763,6 +1017,9 @@ bkrl::command_handler_result bkrl::game::on_command(command const& cmd)
     case command_type::center_on_player:
         on_center_on_player();
         break;
+    case command_type::toggle_profiler:
+        on_toggle_profiler();
+        break;
     default:
         break;
     }
@@ -827,6 +1084,8 @@ void bkrl::game::on_command_result(command_type const cmd, command_result const
         break;
     case command_type::show_inventory:
         break;
+    case command_type::toggle_profiler:
+        break;
     default:
         break;
     }
@@ -1131,7 +1390,7 @@ void bkrl::open_doors(
   , command_translator& commands
   , creature&           subject
   , map&                current_map
-  , find_around_result_t<terrain_entry*> const& doors
+  , find_around_result_t<bool> const& doors
 ) {
     ctx.out.write("Open in which direction?");
     commands.push_handler(filter_text_and_raw([&, doors](command const& cmd) {
@@ -1331,7 +1590,7 @@ void bkrl::close_doors(
   , command_translator& commands
   , creature&           subject
   , map&                current_map
-  , find_around_result_t<terrain_entry*> const& doors
+  , find_around_result_t<bool> const& doors
 ) {
     ctx.out.write("Close in which direction?");
     commands.push_handler(filter_text_and_raw([&, doors](command const& cmd) {
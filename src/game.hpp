@@ -155,7 +155,7 @@ void open_doors(
   , command_translator& commands
   , creature&           subject
   , map&                current_map
-  , find_around_result_t<terrain_entry*> const& doors
+  , find_around_result_t<bool> const& doors
 );
 
 //--------------------------------------------------------------------------------------------------
@@ -222,7 +222,7 @@ void close_doors(
   , command_translator& commands
   , creature&           subject
   , map&                current_map
-  , find_around_result_t<terrain_entry*> const& doors
+  , find_around_result_t<bool> const& doors
 );
 
 //--------------------------------------------------------------------------------------------------
@@ -4,6 +4,7 @@
 #include "map.hpp"
 #include "inventory.hpp"
 #include "bklib/dictionary.hpp"
+#include "bklib/byte_stream.hpp"
 #include "external/format.h"
 
 bkrl::item_data_t::item_data_t(item_data_t&& other) noexcept
@@ -61,6 +62,97 @@ bkrl::item::item(
     static_assert(std::is_nothrow_move_constructible<item>::value, "");
 }
 
+//--------------------------------------------------------------------------------------------------
+void bkrl::item::write(bklib::byte_writer& out) const
+{
+    out.write(def_);
+    out.write(id_);
+    out.write(flags_);
+    out.write(slots_);
+    out.write(data_.type);
+
+    switch (data_.type) {
+    case item_data_type::container:
+        out.write(!!data_.data);
+        if (data_.data) {
+            reinterpret_cast<item_pile const*>(data_.data)->write(out);
+        }
+        break;
+    case item_data_type::none: BK_FALLTHROUGH
+    case item_data_type::corpse:
+        out.write(data_.data);
+        break;
+    default:
+        BK_PRECONDITION_SAFE(false && "unreachable");
+        break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::item bkrl::item::read(bklib::byte_reader& in)
+{
+    item result;
+
+    result.def_       = in.read<def_id_t<tag_item>>();
+    result.id_        = in.read<instance_id_t<tag_item>>();
+    result.flags_     = in.read<item_flags>();
+    result.slots_     = in.read<item_slots>();
+    result.data_.type = in.read<item_data_type>();
+
+    switch (result.data_.type) {
+    case item_data_type::container:
+        if (in.read<bool>()) {
+            auto pile = std::make_unique<item_pile>(item_pile::read(in));
+            result.data_.data = reinterpret_cast<uint64_t>(pile.release());
+        }
+        break;
+    case item_data_type::none: BK_FALLTHROUGH
+    case item_data_type::corpse:
+        result.data_.data = in.read<uint64_t>();
+        break;
+    default:
+        BK_PRECONDITION_SAFE(false && "unreachable");
+        break;
+    }
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// bkrl::item_pile
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::item_pile::write(bklib::byte_writer& out) const
+{
+    auto const count = static_cast<uint32_t>(std::distance(std::begin(items_), std::end(items_)));
+    out.write(count);
+
+    for (auto const& itm : items_) {
+        itm.write(out);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::item_pile bkrl::item_pile::read(bklib::byte_reader& in)
+{
+    auto const count = in.read<uint32_t>();
+
+    std::vector<item> items;
+    items.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        items.push_back(item::read(in));
+    }
+
+    // insert pushes to the front
+    item_pile result;
+    for (auto it = items.rbegin(); it != items.rend(); ++it) {
+        result.insert(std::move(*it));
+    }
+
+    return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 void bkrl::process_tags(item_def& def)
 {
@@ -15,6 +15,7 @@
 
 namespace bklib { template <typename T> class spatial_map_2d; }
 namespace bklib { template <typename T> class dictionary; }
+namespace bklib { class byte_writer; class byte_reader; }
 
 namespace bkrl {
 
@@ -27,6 +28,7 @@ class  item_factory;
 struct terrain_entry;
 using  item_dictionary = bklib::dictionary<item_def>;
 using  item_map = bklib::spatial_map_2d<item_pile>;
+using  item_handle = bklib::tagged_value<item_map, uint32_t>; //!< see bklib::spatial_map_handle
 
 //--------------------------------------------------------------------------------------------------
 //!
@@ -177,7 +179,14 @@ public:
     }
 
     int32_t weight() const { return 0; } // TODO
+
+    //----------------------------------------------------------------------------------------------
+    //! Serialize, along with the contents of a container, for paging out (see map::enable_paging).
+    //----------------------------------------------------------------------------------------------
+    void write(bklib::byte_writer& out) const;
+    static item read(bklib::byte_reader& in);
 private:
+    item() = default;
     item(instance_id_t<tag_item> id, item_def const& def);
 
     def_id_t<tag_item>      def_;
@@ -303,6 +312,10 @@ public:
     const_iterator find_if(const_iterator const before, const_iterator const last, Predicate&& pred) const {
         return find_if_(before, last, std::forward<Predicate>(pred));
     }
+
+    //! See item::write; the order of the items is kept.
+    void write(bklib::byte_writer& out) const;
+    static item_pile read(bklib::byte_reader& in);
 private:
     template <typename Predicate>
     iterator find_if_(iterator before, iterator const last, Predicate&& pred) {
@@ -667,6 +667,7 @@ public:
 
         switch (field_ = static_cast<field>(hash)) {
         case field::stat_hp : break;
+        case field::speed : break;
         case field::none : BK_FALLTHROUGH
         default:
             return default_result();
@@ -695,8 +696,33 @@ public:
         return default_result();
     }
 
+    //----------------------------------------------------------------------------------------------
+    bool on_uint(unsigned const n) override final {
+        if (field_ != field::speed) {
+            return default_result();
+        }
+
+        using speed_t = decltype(bkrl::creature_def::speed);
+
+        // a creature of speed 0 would never act; rejected as an invalid value like any other
+        constexpr auto const max = static_cast<unsigned>(std::numeric_limits<speed_t>::max());
+        if (n == 0 || n > max) {
+            return default_result();
+        }
+
+        def_.speed = static_cast<speed_t>(n);
+
+        field_ = field::none;
+        push(base_parser_);
+
+        return true;
+    }
+
     //----------------------------------------------------------------------------------------------
     bool on_start_object() override final {
+        // optional; not carried over from the previous definition
+        def_.speed = bkrl::speed_normal;
+
         push(base_parser_);
         return base_parser_.StartObject();
     }
@@ -721,6 +747,7 @@ private:
     enum class field : uint32_t {
         none
       , BK_HASHED_ENUM(stat_hp)
+      , BK_HASHED_ENUM(speed)
     } field_ = field::none;
 };
 
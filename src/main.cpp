@@ -6,7 +6,7 @@
 
 #include <map>
 
-int run_unit_tests();
+int run_unit_tests(bool benchmarks);
 
 namespace {
 #if !defined(BK_TESTS_ONLY)
@@ -24,10 +24,12 @@ int main(int const argc, char const* argv[]) try {
 
     bool flag_no_unit_tests = false;
     bool flag_no_run_game   = false;
+    bool flag_benchmarks    = false;
 
     std::map<uint32_t, std::reference_wrapper<bool>> const flags {
         {"--no-unit-tests"_hash, std::ref(flag_no_unit_tests)}
       , {"--no-run-game"_hash,   std::ref(flag_no_run_game)}
+      , {"--benchmarks"_hash,    std::ref(flag_benchmarks)}
     };
 
     for (int i = 1; i < argc; ++i) {
@@ -38,7 +40,7 @@ int main(int const argc, char const* argv[]) try {
     }
 
     if (!flag_no_unit_tests) {
-        run_unit_tests();
+        run_unit_tests(flag_benchmarks);
     }
 
     if (!flag_no_run_game) {
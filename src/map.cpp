@@ -4,9 +4,19 @@
 #include "color.hpp"
 #include "context.hpp"
 #include "bsp_layout.hpp"
+#include "profiler.hpp"
 
 #include "bklib/algorithm.hpp"
+#include "bklib/byte_stream.hpp"
 #include "bklib/dictionary.hpp"
+#include "bklib/scope_guard.hpp"
+#include "bklib/worker_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <tuple>
+#include <unordered_map>
 
 namespace {
 
@@ -17,41 +27,49 @@ find_creature_by_id(bkrl::instance_id_t<bkrl::tag_creature> const id) noexcept {
     };
 }
 
-inline decltype(auto) find_by_pos(bklib::ipoint2 const p) noexcept {
-    auto const x_pos = x(p);
-    auto const y_pos = y(p);
-
-    return [x_pos, y_pos](auto const& data) noexcept {
-        return (data.x == x_pos) && (data.y == y_pos);
-    };
-}
-
 } // namespace
 
 //--------------------------------------------------------------------------------------------------
 //--------------------------------------------------------------------------------------------------
 namespace {
 
-template <typename T, typename Function>
-void for_each_block_in(bkrl::chunk_t<T> const& chunk, bklib::irect const r, Function&& f)
+//! Call f(block, x, y) for each allocated block overlapping @p r; (x, y) is the block's top left cell.
+template <typename T, typename Block, typename Function>
+void for_each_block_in(bkrl::chunk_table_t<T, Block> const& table, bklib::irect const r, Function&& f)
 {
-    constexpr auto const w = static_cast<int>(bkrl::size_block);
-    constexpr auto const h = static_cast<int>(bkrl::size_block);
-
-    auto const rw = r.width();
-    auto const blocks_x = rw / w + (r.left % w ? 1 : 0) + (rw % w ? 1 : 0);
+    constexpr auto const size = static_cast<int>(bkrl::size_block);
 
-    auto const rh = r.height();
-    auto const blocks_y = rh / h + (r.top % h ? 1 : 0) + (rh % h ? 1 : 0);
+    for (auto y = bkrl::block_of(r.top) * size; y < r.bottom; y += size) {
+        for (auto x = bkrl::block_of(r.left) * size; x < r.right; x += size) {
+            if (auto const block = table.find_block(x, y)) {
+                f(*block, x, y);
+            }
+        }
+    }
+}
 
-    auto const x0 = w * (r.left / w);
-    auto const y0 = h * (r.top  / h);
+//! Versions are unique across all maps, so a renderer caching blocks by position can't confuse
+//! the same block of two different maps.
+uint64_t next_block_version() noexcept {
+    static std::atomic<uint64_t> version {0};
+    return ++version;
+}
 
-    for (auto yi = 0; (yi < blocks_y * h) && (yi < h * h - r.top); yi += h) {
-        for (auto xi = 0; (xi < blocks_x * w) && (xi < w * w - r.left); xi += w) {
-            f(chunk.block_at(r.left + xi, r.top + yi), xi + x0, yi + y0);
-        }
+//! The colour a cell is given in terrain overviews.
+bkrl::color4 overview_color(uint16_t const base_index) noexcept {
+    using bkrl::make_color;
+
+    switch (base_index) {
+    default  : break;
+    case '*' : return make_color(100, 90,  80);
+    case '>' : return make_color(230, 200, 40);
+    case '.' : return make_color(60,  60,  70);
+    case '#' : return make_color(170, 170, 170);
+    case '\\': BK_FALLTHROUGH
+    case '+' : return make_color(150, 100, 40);
     }
+
+    return make_color(0, 0, 0, 0);
 }
 } //namespace
 
@@ -63,71 +81,135 @@ public:
         colors_ = &colors;
     }
 
-    void draw(renderer& render, bklib::irect const bounds, view const& v) const {
+    void set_pager(std::unique_ptr<chunk_pager> pager) {
+        terrain_data_.set_pager(std::move(pager), [this](int const x, int const y) {
+            on_page_out_(x, y);
+        });
+    }
+
+    void draw(renderer& render, bklib::irect const bounds, view const& v) {
         auto const r = intersection(bounds, v.screen_to_world());
         if (!r) {
             return;
         }
 
-        for_each_block_in(terrain_data_, r, [&](auto const& block, int const x, int const y) {
-            auto const base = block.data.data();
-            constexpr auto const off_texture = offsetof(terrain_render_data_t, base_index);
-            constexpr auto const siz_texture = sizeof(terrain_render_data_t::base_index);
-            constexpr auto const stride = sizeof(terrain_render_data_t);
+        auto const zoom = x(v.get_zoom());
+        if (zoom < overview_zoom) {
+            draw_overview(render, r, v.tile_w() * zoom
+              , [&](int const x, int const y, int const w, int const h) {
+                    auto const tw = v.tile_w();
+                    auto const th = v.tile_h();
+                    return renderer::rect_t {x * tw, y * th, w * tw, h * th};
+                });
+        } else {
+            draw_blocks_(render, r);
+        }
 
-            render.draw_cells(x, y, size_block, size_block, base, off_texture, siz_texture, stride);
+        // only the buckets for the blocks overlapping the view are visited
+        item_data_.for_each_at(r, [&](point_t, item_render_data_t const& i) {
+            render.draw_cell(i.x, i.y, i.base_index, i.color);
         });
 
-        for (auto const& i : item_data_) {
-            render.draw_cell(i.x, i.y, i.base_index, i.color);
+        creature_data_.for_each_at(r, [&](point_t, creature_render_data_t const& c) {
+            render.draw_cell(c.x, c.y, c.base_index, c.color);
+        });
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Draw the terrain overview of each chunk overlapping @p r, choosing the level of detail from
+    //! the size of a cell on screen; to_rect(x, y, w, h) maps a region of cells to the destination.
+    //! Overviews dropped when their chunk was paged out are rebuilt, paging it back in.
+    //----------------------------------------------------------------------------------------------
+    template <typename ToRect>
+    void draw_overview(renderer& render, bklib::irect const r, double const cell_size
+      , ToRect&& to_rect
+    ) {
+        auto level = 0u;
+        while (level + 1 < overview_levels && cell_size * (1 << level) < overview_texel_size) {
+            ++level;
         }
 
-        for (auto const& c : creature_data_) {
-            render.draw_cell(c.x, c.y, c.base_index, c.color);
+        constexpr auto const size = static_cast<int>(size_chunk);
+        auto const side = size_chunk >> level;
+
+        for (auto y = align_(r.top, size); y < r.bottom; y += size) {
+            for (auto x = align_(r.left, size); x < r.right; x += size) {
+                auto it = overviews_.find(chunk_key_(x, y));
+                if (it == std::end(overviews_)) {
+                    if (!terrain_data_.find_block(x, y)) {
+                        continue;
+                    }
+
+                    it = build_overview_(x, y);
+                }
+
+                auto const& ov = it->second;
+                auto const key = (uint64_t {level} << 62) | chunk_key_(x, y);
+
+                render.draw_texels_cached(key, ov.version, to_rect(x, y, size, size)
+                  , side, side, ov.texels[level].data());
+            }
         }
     }
 
     void update_creature_pos(point_t const from, point_t const to) {
+        BK_PROFILE_ZONE(render_data);
+        flush_batch_();
         update_pos_(creature_data_, from, to);
     }
 
     void update_item_pos(point_t const from, point_t const to) {
+        BK_PROFILE_ZONE(render_data);
+        flush_batch_();
         update_pos_(item_data_, from, to);
     }
 
     void update_or_add(item_def const* idef, point_t const p) {
+        BK_PROFILE_ZONE(render_data);
+
         constexpr uint16_t const fallback_symbol = '?';
         color4 const fallback_color = make_color(255, 0, 255);
 
         item_render_data_t data {
-            static_cast<int16_t>(x(p))
-          , static_cast<int16_t>(y(p))
+            static_cast<int32_t>(x(p))
+          , static_cast<int32_t>(y(p))
           , static_cast<uint16_t>(idef ? idef->symbol[0] : fallback_symbol)
           , idef ? get_color_(*idef) : fallback_color
         };
 
-        update_or_add_(item_data_, p, std::move(data));
+        update_or_add_(item_data_, pending_items_, p, std::move(data));
     }
 
     void update_or_add(creature_def const* cdef, point_t const p) {
+        BK_PROFILE_ZONE(render_data);
+
         constexpr uint16_t const fallback_symbol = '?';
         color4 const fallback_color = make_color(255, 0, 255);
 
         creature_render_data_t data {
-            static_cast<int16_t>(x(p))
-          , static_cast<int16_t>(y(p))
+            static_cast<int32_t>(x(p))
+          , static_cast<int32_t>(y(p))
           , static_cast<uint16_t>(cdef ? cdef->symbol[0] : fallback_symbol)
           , cdef ? get_color_(*cdef) : fallback_color
         };
 
-        update_or_add_(creature_data_, p, std::move(data));
+        update_or_add_(creature_data_, pending_creatures_, p, std::move(data));
+    }
+
+    //! Note that the terrain render data for the block containing @p p has changed.
+    void touch_block(point_t const p) {
+        BK_PROFILE_ZONE(render_data);
+        block_versions_[block_key(x(p), y(p))] = next_block_version();
+        update_overview_(p);
     }
 
     void update_terrain(terrain_entry const& ter, point_t const p) {
+        BK_PROFILE_ZONE(render_data);
+
         auto const x_pos = x(p);
         auto const y_pos = y(p);
 
-        auto& index = terrain_data_.block_at(x_pos, y_pos).cell_at(x_pos, y_pos).base_index;
+        auto& index = terrain_data_.cell_at(x_pos, y_pos).base_index;
 
         switch (ter.type) {
         default :
@@ -143,13 +225,94 @@ public:
     }
 
     void clear_item_at(point_t const p) {
+        BK_PROFILE_ZONE(render_data);
+        flush_batch_();
         clear_at_(item_data_, p);
     }
 
     void clear_creature_at(point_t const p) {
+        BK_PROFILE_ZONE(render_data);
+        flush_batch_();
         clear_at_(creature_data_, p);
     }
+
+    //! Until end_batch(), update_or_add appends to a pending list without searching for an existing
+    //! entry; pending entries aren't drawn.
+    void begin_batch() {
+        batching_ = true;
+    }
+
+    void end_batch() {
+        BK_PROFILE_ZONE(render_data);
+        flush_batch_();
+    }
 private:
+    void draw_blocks_(renderer& render, bklib::irect const r) const {
+        for_each_block_in(terrain_data_, r, [&](auto const& block, int const x, int const y) {
+            auto const base = block.data.data();
+            constexpr auto const off_texture = offsetof(terrain_render_data_t, base_index);
+            constexpr auto const siz_texture = sizeof(terrain_render_data_t::base_index);
+            constexpr auto const stride = sizeof(terrain_render_data_t);
+
+            render.draw_cells_cached(block_key(x, y), block_version_(x, y)
+              , x, y, size_block, size_block, base, off_texture, siz_texture, stride);
+        });
+    }
+
+    //! Drop all but the last entry added for each position.
+    template <typename Container>
+    static void merge_pending_(Container& c) {
+        using value_t = typename Container::value_type;
+
+        std::stable_sort(begin(c), end(c), [](value_t const& a, value_t const& b) noexcept {
+            return std::tie(a.y, a.x) < std::tie(b.y, b.x);
+        });
+
+        auto out = begin(c);
+        for (auto it = begin(c); it != end(c); ++it) {
+            auto const next = std::next(it);
+            if (next != end(c) && next->x == it->x && next->y == it->y) {
+                continue;
+            }
+
+            *out++ = std::move(*it);
+        }
+
+        c.erase(out, end(c));
+    }
+
+    void flush_batch_() {
+        if (!batching_) {
+            return;
+        }
+
+        batching_ = false;
+        flush_pending_(item_data_, pending_items_);
+        flush_pending_(creature_data_, pending_creatures_);
+    }
+
+    //! Overwrite the entries already present at the pending positions and insert the rest.
+    template <typename T>
+    static void flush_pending_(bklib::spatial_map_2d<T>& m, std::vector<T>& pending) {
+        merge_pending_(pending);
+
+        std::vector<std::pair<point_t, T>> added;
+        added.reserve(pending.size());
+
+        for (auto& value : pending) {
+            auto const p = point_t {value.x, value.y};
+            if (auto const existing = m.at(p)) {
+                *existing = std::move(value);
+            } else {
+                added.emplace_back(p, std::move(value));
+            }
+        }
+
+        // pending is sorted by position, so runs of the same block share a bucket lookup
+        m.bulk_insert(begin(added), end(added));
+        pending.clear();
+    }
+
     template <typename T>
     color4 get_color_(T const& def) const {
         auto default_color = color4 {255, 255, 255, 255};
@@ -167,41 +330,210 @@ private:
         return default_color;
     }
 
-    template <typename Container>
-    static void clear_at_(Container& c, point_t const p) {
-        auto const it = bklib::find_if(c, find_by_pos(p));
-        BK_PRECONDITION(it != std::end(c));
-        c.erase(it);
+    template <typename T>
+    static void clear_at_(bklib::spatial_map_2d<T>& m, point_t const p) {
+        m.remove(p);
     }
 
-    template <typename Container, typename T>
-    static void update_or_add_(Container& c, point_t const p, T&& value) {
-        if (auto const maybe = bklib::find_maybe(c, find_by_pos(p))) {
-            *maybe = std::forward<T>(value);
+    template <typename T>
+    void update_or_add_(bklib::spatial_map_2d<T>& m, std::vector<T>& pending, point_t const p
+      , T&& value
+    ) {
+        if (batching_) {
+            pending.push_back(std::move(value));
+        } else if (auto const existing = m.at(p)) {
+            *existing = std::move(value);
         } else {
-            c.push_back(std::forward<T>(value));
+            m.insert(p, std::move(value));
         }
     }
 
-    template <typename Container>
-    static void update_pos_(Container& c, point_t const from, point_t const to) {
-        auto const ptr = bklib::find_maybe(c, find_by_pos(from));
-        BK_ASSERT(ptr);
+    template <typename T>
+    static void update_pos_(bklib::spatial_map_2d<T>& m, point_t const from, point_t const to) {
+        auto const h = m.handle_at(from);
+        auto const ok = m.relocate(h, to);
+        BK_ASSERT(ok);
+
+        auto& value = *m.get(h);
+        value.x = static_cast<int32_t>(x(to));
+        value.y = static_cast<int32_t>(y(to));
+    }
+
+    //! Levels of detail of the terrain overviews; level n has a texel per 2^n x 2^n cells.
+    static constexpr unsigned overview_levels = 3;
+
+    //! The overview replaces the terrain itself below this zoom.
+    static constexpr double overview_zoom = 0.5;
+
+    //! The coarsest level used still has texels of at least this many pixels.
+    static constexpr double overview_texel_size = 2.0;
+
+    struct overview_t {
+        std::array<std::vector<color4>, overview_levels> texels;
+        uint64_t version = 0;
+    };
+
+    //! Bring the overview of the block containing @p p up to date with its render data; all of the
+    //! chunk's if it has no overview yet.
+    void update_overview_(point_t const p) {
+        constexpr auto const size = static_cast<int>(size_block);
+
+        auto const x0 = align_(x(p), size);
+        auto const y0 = align_(y(p), size);
+
+        auto const block = terrain_data_.find_block(x0, y0);
+        if (!block) {
+            return;
+        }
 
-        ptr->x = static_cast<int16_t>(x(to));
-        ptr->y = static_cast<int16_t>(y(to));
+        auto const it = overviews_.find(chunk_key_(x0, y0));
+        if (it == std::end(overviews_)) {
+            build_overview_(x0, y0);
+            return;
+        }
+
+        update_overview_block_(it->second, *block, x0, y0);
+        it->second.version = next_block_version();
+    }
+
+    //! Build the overview of the chunk containing (x, y) from all of its blocks.
+    //! @pre the chunk has render data.
+    std::unordered_map<uint64_t, overview_t>::iterator build_overview_(int const x, int const y) {
+        constexpr auto const size = static_cast<int>(size_block);
+
+        auto const x0 = align_(x, static_cast<int>(size_chunk));
+        auto const y0 = align_(y, static_cast<int>(size_chunk));
+
+        auto const it = overviews_.emplace(chunk_key_(x0, y0), overview_t {}).first;
+        auto& ov = it->second;
+
+        for (auto level = 0u; level < overview_levels; ++level) {
+            auto const side = size_chunk >> level;
+            ov.texels[level].resize(side * side);
+        }
+
+        // the blocks of a chunk are in memory together
+        for (auto by = y0; by < y0 + static_cast<int>(size_chunk); by += size) {
+            for (auto bx = x0; bx < x0 + static_cast<int>(size_chunk); bx += size) {
+                auto const block = terrain_data_.find_block(bx, by);
+                BK_ASSERT(block);
+                update_overview_block_(ov, *block, bx, by);
+            }
+        }
+
+        ov.version = next_block_version();
+        return it;
+    }
+
+    //! Copy the block at (x0, y0) into @p ov, from the full detail level down.
+    static void update_overview_block_(overview_t& ov, block_t<terrain_render_data_t> const& block
+      , int const x0, int const y0
+    ) {
+        // the block's position within its chunk
+        auto const bx = static_cast<size_t>(x0 - align_(x0, static_cast<int>(size_chunk)));
+        auto const by = static_cast<size_t>(y0 - align_(y0, static_cast<int>(size_chunk)));
+
+        for (auto yi = 0u; yi < size_block; ++yi) {
+            for (auto xi = 0u; xi < size_block; ++xi) {
+                ov.texels[0][(by + yi) * size_chunk + bx + xi] =
+                    overview_color(block.data[yi * size_block + xi].base_index);
+            }
+        }
+
+        for (auto level = 1u; level < overview_levels; ++level) {
+            auto const& src = ov.texels[level - 1];
+            auto&       dst = ov.texels[level];
+
+            auto const src_side = size_chunk >> (level - 1);
+            auto const dst_side = size_chunk >> level;
+            auto const n        = size_block >> level;
+
+            for (auto yi = (by >> level); yi < (by >> level) + n; ++yi) {
+                for (auto xi = (bx >> level); xi < (bx >> level) + n; ++xi) {
+                    auto const i = (yi * 2) * src_side + xi * 2;
+                    for (auto c = 0u; c < 4u; ++c) {
+                        dst[yi * dst_side + xi][c] = static_cast<uint8_t>((
+                            src[i][c] + src[i + 1][c] + src[i + src_side][c] + src[i + src_side + 1][c]
+                        ) / 4);
+                    }
+                }
+            }
+        }
+    }
+
+    //! Blocks not touched since their chunk was last paged in share the version of the chunk; 0
+    //! if it has never been paged out.
+    uint64_t block_version_(int const x, int const y) const {
+        auto const it = block_versions_.find(block_key(x, y));
+        if (it != std::end(block_versions_)) {
+            return it->second;
+        }
+
+        auto const chunk = paged_out_versions_.find(chunk_key_(x, y));
+        return (chunk != std::end(paged_out_versions_)) ? chunk->second : 0;
     }
 
-    chunk_t<terrain_render_data_t>      terrain_data_;
-    std::vector<creature_render_data_t> creature_data_;
-    std::vector<item_render_data_t>     item_data_;
+    //! Drop what is kept alongside the render data of the chunk at (x0, y0); it is rebuilt as the
+    //! chunk is used again. The chunk gets a new version, as its blocks may have changed since a
+    //! renderer last saw them.
+    void on_page_out_(int const x0, int const y0) {
+        constexpr auto const size = static_cast<int>(size_block);
+
+        overviews_.erase(chunk_key_(x0, y0));
+
+        for (auto y = y0; y < y0 + static_cast<int>(size_chunk); y += size) {
+            for (auto x = x0; x < x0 + static_cast<int>(size_chunk); x += size) {
+                block_versions_.erase(block_key(x, y));
+            }
+        }
+
+        paged_out_versions_[chunk_key_(x0, y0)] = next_block_version();
+    }
+
+    //! floor(n / size) * size for both positive and negative n.
+    static int align_(int const n, int const size) noexcept {
+        return bklib::floor_div(n, size) * size;
+    }
+
+    //! The top two bits are left clear for the level of detail; see draw_overview.
+    static uint64_t chunk_key_(int const x, int const y) noexcept {
+        constexpr auto const size = static_cast<int>(size_chunk);
+        return bklib::grid_key(bklib::floor_div(x, size), bklib::floor_div(y, size))
+             & (~uint64_t {0} >> 2);
+    }
+
+    chunk_table_t<terrain_render_data_t> terrain_data_;
+    std::unordered_map<uint64_t, uint64_t> block_versions_;     //!< see touch_block
+    std::unordered_map<uint64_t, uint64_t> paged_out_versions_; //!< by chunk; see block_version_
+    std::unordered_map<uint64_t, overview_t> overviews_;        //!< by chunk
+    bklib::spatial_map_2d<creature_render_data_t> creature_data_;
+    bklib::spatial_map_2d<item_render_data_t>     item_data_;
+    std::vector<creature_render_data_t> pending_creatures_; //!< see begin_batch
+    std::vector<item_render_data_t>     pending_items_;
 
     color_dictionary const* colors_ = nullptr;
+
+    bool batching_ = false;
 };
 
+//--------------------------------------------------------------------------------------------------
+uint64_t bkrl::map::next_terrain_revision_() noexcept
+{
+    // unique across all maps, as for next_block_version
+    static std::atomic<uint64_t> revision {0};
+    return ++revision;
+}
+
 //--------------------------------------------------------------------------------------------------
 bkrl::map::map()
+  : map {bklib::irect {0, 0, static_cast<int>(size_chunk), static_cast<int>(size_chunk)}}
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::map::map(bklib::irect const bounds)
   : render_data_ {std::make_unique<render_data_t>()}
+  , bounds_ {bounds}
 {
 }
 
@@ -245,6 +577,8 @@ bkrl::map::map(context& ctx)
     //
     // add items, creatures, and features
     //
+    begin_batch();
+
     for (auto const& room : rooms_) {
         // add a random door
         auto const& region = room.region;
@@ -270,7 +604,7 @@ bkrl::map::map(context& ctx)
         }
     }
 
-    update_render_data();
+    end_batch();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -285,14 +619,379 @@ void  bkrl::map::set_draw_colors(color_dictionary const& colors)
 //--------------------------------------------------------------------------------------------------
 void bkrl::map::draw(renderer& render, view const& v) const
 {
+    update_render_data();
     render_data_->draw(render, bounds(), v);
 }
 
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::draw_minimap(renderer& render, bklib::irect const dst) const
+{
+    update_render_data();
+
+    auto const b = bounds();
+    if (b.width() <= 0 || b.height() <= 0) {
+        return;
+    }
+
+    auto const sx = static_cast<double>(dst.width())  / b.width();
+    auto const sy = static_cast<double>(dst.height()) / b.height();
+
+    auto const scale = render.get_scale();
+    auto const trans = render.get_translation();
+    auto const clip  = render.get_clip_region();
+
+    BK_SCOPE_EXIT {
+        render.set_scale(x(scale), y(scale));
+        render.set_translation(x(trans), y(trans));
+        render.set_clip_region(clip);
+    };
+
+    render.set_scale(1.0);
+    render.set_translation(0.0, 0.0);
+    render.set_clip_region(make_renderer_rect(dst));
+
+    render_data_->draw_overview(render, b, std::min(sx, sy)
+      , [&](int const x, int const y, int const w, int const h) {
+            return renderer::rect_t {
+                dst.left + bklib::floor_to<int>((x - b.left) * sx)
+              , dst.top  + bklib::floor_to<int>((y - b.top)  * sy)
+              , bklib::ceil_to<int>(w * sx)
+              , bklib::ceil_to<int>(h * sy)
+            };
+        });
+}
+
 //--------------------------------------------------------------------------------------------------
 void bkrl::map::advance(context& ctx)
 {
-    bkrl::advance(ctx, *this, items_);
-    bkrl::advance(ctx, *this, creatures_);
+    page_payloads_(ctx.data);
+
+    {
+        BK_PROFILE_ZONE(items);
+        bkrl::advance(ctx, *this, items_);
+    }
+
+    {
+        BK_PROFILE_ZONE(creatures);
+
+        auto const now   = scheduler_.now();
+        auto const until = now + ticks_per_turn;
+
+        if (auto const player = creatures_.get(player_)) {
+            activity_.begin_turn(player->position());
+        } else {
+            activity_.begin_turn();
+        }
+
+        activity_.wake([&](creature_handle const h, game_time const since) {
+            auto const c = creatures_.get(h);
+            if (!c) {
+                return; // removed while asleep
+            }
+
+            if (auto const delay = bkrl::catch_up(ctx, *this, *c, now - since)) {
+                scheduler_.schedule_in(h, delay);
+            }
+        });
+
+        auto const act = [&](creature_handle const who, creature& c, creature_action const& what) {
+            if (auto const delay = bkrl::apply(ctx, *this, c, what)) {
+                scheduler_.schedule_in(who, delay);
+            }
+        };
+
+        // decisions don't depend on who is where (see bkrl::decide), so with no one to split a
+        // round with each creature decides as it acts, without a pass to collect the round first
+        auto const split = workers_ && !terrain_entries_.is_paged();
+
+        creature_handle h;
+        while (scheduler_.next(until, h)) {
+            auto const when = scheduler_.now();
+
+            // drawn once a round rather than by each decision, so that the streams don't depend on
+            // how the round is split up
+            auto const seed = uint64_t {ctx.random[random_stream::creature]()};
+
+            round_.clear();
+            auto chasing = false;
+            do {
+                auto const c = creatures_.get(h);
+                if (!c) {
+                    continue; // removed since it was scheduled, or killed earlier in the round
+                }
+
+                if (!activity_.is_active(c->position())) {
+                    activity_.sleep(h, c->position(), when);
+                    continue;
+                }
+
+                // only the terrain and the player matter, and neither changes during a round
+                if (!chasing && c->is_aggressive()) {
+                    chasing = true;
+                    update_player_distances_();
+                }
+
+                if (split) {
+                    round_.push_back(pending_action_t {h, creature_action {}});
+                } else {
+                    auto random = decision_random(seed, *c);
+                    act(h, *c, decide(*this, *c, random));
+                }
+            } while (scheduler_.next(when, h));
+
+            if (round_.empty()) {
+                continue;
+            }
+
+            auto const decided = decide_round_(seed);
+
+            for (auto& p : round_) {
+                auto const c = creatures_.get(p.who);
+                if (!c) {
+                    continue; // killed earlier in the round
+                }
+
+                if (!decided) {
+                    auto random = decision_random(seed, *c);
+                    p.what = decide(*this, *c, random);
+                }
+
+                act(p.who, *c, p.what);
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::map::decide_round_(uint64_t const seed)
+{
+    BK_PRECONDITION(workers_ && !terrain_entries_.is_paged());
+
+    if (round_.size() < min_split_) {
+        return false;
+    }
+
+    constexpr size_t grain = 64;
+
+    map const& frozen = *this;
+
+    workers_->for_each_range(round_.size(), grain, [&](size_t const first, size_t const last) {
+        for (auto i = first; i < last; ++i) {
+            auto& p = round_[i];
+            auto const& c = *frozen.get_creature(p.who);
+
+            auto random = decision_random(seed, c);
+            p.what = decide(frozen, c, random);
+        }
+    });
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::update_player_distances_()
+{
+    auto&       field  = player_distances_;
+    auto const  player = creatures_.get(player_);
+    auto const& goals  = field.goals();
+
+    if (!player) {
+        field.clear_goals();
+    } else if (goals.empty()) {
+        field.add_goal(player->position());
+    } else {
+        field.move_goal(goals.front(), player->position());
+    }
+
+    field.update(*this);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::page_payloads_(definitions const& defs)
+{
+    if (!payloads_) {
+        return;
+    }
+
+    enum class record : uint8_t {
+        creature, items
+    };
+
+    constexpr auto size = static_cast<int>(size_chunk);
+
+    auto const key_of = [](bklib::ipoint2 const p) noexcept {
+        return bklib::grid_key(bklib::floor_div(x(p), size), bklib::floor_div(y(p), size));
+    };
+
+    // restoring creatures reads terrain, which can page other chunks out; those are left for the
+    // next call
+    auto const paged_out = std::move(paged_out_);
+    auto const paged_in  = std::move(paged_in_);
+    paged_out_.clear();
+    paged_in_.clear();
+
+    std::vector<char> buffer;
+
+    //
+    // out: chunks that are still paged out; a chunk can be paged out more than once between calls
+    // but its payload only goes out the first time
+    //
+    std::vector<creature_handle> creatures;
+    std::vector<bklib::ipoint2>  piles;
+
+    for (auto const p : paged_out) {
+        if (terrain_entries_.is_resident(x(p), y(p))) {
+            continue;
+        }
+
+        bklib::irect const r {x(p), y(p), x(p) + size, y(p) + size};
+
+        creatures.clear();
+        creatures_.for_each_at(r, [&](bklib::ipoint2 const q, creature const& c) {
+            if (!c.is_player()) {
+                creatures.push_back(creatures_.handle_at(q));
+            }
+        });
+
+        piles.clear();
+        items_.for_each_at(r, [&](bklib::ipoint2 const q, item_pile const&) {
+            piles.push_back(q);
+        });
+
+        if (creatures.empty() && piles.empty()) {
+            continue;
+        }
+
+        buffer.clear();
+        bklib::byte_writer out {buffer};
+
+        for (auto const h : creatures) {
+            out.write(record::creature);
+            out.write(scheduler_.now());
+            remove_creature(h).write(out);
+        }
+
+        for (auto const q : piles) {
+            out.write(record::items);
+            out.write(q);
+            remove_items_at(q).write(out);
+        }
+
+        payloads_->append(key_of(p), buffer.data(), buffer.size());
+    }
+
+    //
+    // in: chunks that are back in memory
+    //
+    for (auto const p : paged_in) {
+        buffer.clear();
+        if (!terrain_entries_.is_resident(x(p), y(p)) || !payloads_->take(key_of(p), buffer)) {
+            continue;
+        }
+
+        std::vector<char> deferred;
+        bklib::byte_writer later {deferred};
+
+        bklib::byte_reader in {buffer.data(), buffer.data() + buffer.size()};
+        while (!in.empty()) {
+            switch (in.read<record>()) {
+            case record::creature : {
+                auto const since = in.read<game_time>();
+                auto c = creature::read(in);
+
+                // something else can have moved in while the creature was away
+                auto const where = creature_at(c.position())
+                  ? find_first_around(*this, c.position(), [&](bklib::ipoint2 const q) {
+                        return !creature_at(q) && can_place_at(*this, q, c);
+                    })
+                  : placement_result_t {c.position(), true};
+
+                if (!where) {
+                    later.write(record::creature);
+                    later.write(since);
+                    c.write(later);
+                    break;
+                }
+
+                auto const q   = where.where;
+                auto const def = defs.find(c.def());
+
+                c.move_to(q);
+                creatures_.insert(q, std::move(c));
+                render_data_->update_or_add(def, q);
+
+                // catches up on the time spent paged out when next active; see advance
+                activity_.sleep(creatures_.handle_at(q), q, since);
+                break;
+            }
+            case record::items : {
+                auto const q = in.read<bklib::ipoint2>();
+                place_items_at(defs, item_pile::read(in), q);
+                break;
+            }
+            default:
+                BK_PRECONDITION_SAFE(false && "unreachable");
+                break;
+            }
+        }
+
+        // try again the next time the chunk is paged in
+        if (!deferred.empty()) {
+            payloads_->append(key_of(p), deferred.data(), deferred.size());
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::set_worker_count(size_t const workers, size_t const min_round)
+{
+    workers_   = workers ? std::make_unique<bklib::worker_pool>(workers) : nullptr;
+    min_split_ = min_round;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::set_activity_radius(int const radius)
+{
+    activity_.set_radius(radius);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::enable_paging(bklib::utf8_string_view const filename, size_t const budget)
+{
+    // split the budget in proportion to the size of a cell of each
+    constexpr auto const terrain_size = sizeof(terrain_entry);
+    constexpr auto const render_size  = sizeof(terrain_render_data_t);
+    constexpr auto const total_size   = terrain_size + render_size;
+
+    auto const render_filename = filename.to_string() + ".render";
+
+    // a small page, as most chunks hold only a few creatures and items
+    constexpr size_t payload_page_size = 4 * 1024;
+
+    auto const payload_filename = filename.to_string() + ".payload";
+    payloads_ = std::make_unique<payload_pager>(payload_filename, payload_page_size);
+
+    terrain_entries_.set_pager(std::make_unique<chunk_pager>(filename
+      , sizeof(terrain_block_t) * chunk_t<terrain_entry, terrain_block_t>::block_count
+      , budget / total_size * terrain_size)
+      , [this](int const x, int const y) { paged_out_.push_back(bklib::ipoint2 {x, y}); }
+      , [this](int const x, int const y) { paged_in_.push_back(bklib::ipoint2 {x, y}); });
+
+    render_data_->set_pager(std::make_unique<chunk_pager>(render_filename
+      , sizeof(block_t<terrain_render_data_t>) * chunk_t<terrain_render_data_t>::block_count
+      , budget / total_size * render_size));
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::begin_batch()
+{
+    render_data_->begin_batch();
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::end_batch()
+{
+    render_data_->end_batch();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -319,6 +1018,22 @@ void bkrl::map::move_creature_to(
     move_creature_to(*ptr, p);
 }
 
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::move_creature_to(creature_handle const h, bklib::ipoint2 const to)
+{
+    auto const c = creatures_.get(h);
+    BK_PRECONDITION(c);
+
+    auto const from = c->position();
+
+    if (!creatures_.relocate(h, to)) {
+        BK_ASSERT(false);
+    }
+
+    c->move_to(to);
+    render_data_->update_creature_pos(from, to);
+}
+
 //--------------------------------------------------------------------------------------------------
 bkrl::creature const* bkrl::map::find_creature(
     std::function<bool (creature const&)> const& predicate
@@ -333,6 +1048,24 @@ bkrl::creature* bkrl::map::find_creature(
     return creatures_.find(predicate);
 }
 
+//--------------------------------------------------------------------------------------------------
+std::vector<bkrl::creature*> bkrl::map::nearest_creatures(
+    bklib::ipoint2 const p
+  , size_t         const k
+  , int            const max_distance
+) {
+    return creatures_.nearest(p, k, max_distance);
+}
+
+//--------------------------------------------------------------------------------------------------
+std::vector<bkrl::creature const*> bkrl::map::nearest_creatures(
+    bklib::ipoint2 const p
+  , size_t         const k
+  , int            const max_distance
+) const {
+    return creatures_.nearest(p, k, max_distance);
+}
+
 //--------------------------------------------------------------------------------------------------
 bkrl::item_pile* bkrl::map::place_item_at(
     item&&               itm
@@ -383,8 +1116,14 @@ void bkrl::map::place_creature_at(
     BK_PRECONDITION(intersects(p, bounds()));
     BK_PRECONDITION(!creature_at(p));
 
-    creatures_.insert(p, std::move(c));
+    auto const& inserted = creatures_.insert(p, std::move(c));
     render_data_->update_or_add(&def, p);
+
+    if (inserted.is_player()) {
+        player_ = creatures_.handle_at(p);
+    } else {
+        scheduler_.schedule_in(creatures_.handle_at(p), ticks_per_turn);
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -404,7 +1143,7 @@ void bkrl::map::fill(bklib::irect r, terrain_type const value, terrain_type cons
 {
     for (int y = r.top; y < r.bottom; ++y) {
         for (int x = r.left; x < r.right; ++x) {
-            auto& cell = at(x, y);
+            auto cell = at(x, y);
 
             if (y == r.top  || y == r.bottom - 1
              || x == r.left || x == r.right - 1
@@ -420,26 +1159,24 @@ void bkrl::map::fill(bklib::irect r, terrain_type const value, terrain_type cons
 }
 
 //--------------------------------------------------------------------------------------------------
-void bkrl::map::update_render_data(bklib::ipoint2 const p)
+void bkrl::map::update_render_data() const
 {
-    update_render_data(x(p), y(p));
-}
+    constexpr auto const size = static_cast<int>(size_block);
 
-//--------------------------------------------------------------------------------------------------
-void bkrl::map::update_render_data(int const x, int const y)
-{
-    auto const& ter = terrain_entries_.block_at(x, y).cell_at(x, y);
-    render_data_->update_terrain(ter, bklib::ipoint2 {x, y});
-}
+    for (auto const key : dirty_blocks_) {
+        auto const x0 = bklib::grid_key_x(key) * size;
+        auto const y0 = bklib::grid_key_y(key) * size;
 
-//--------------------------------------------------------------------------------------------------
-void bkrl::map::update_render_data()
-{
-    for (auto y = 0; y < static_cast<int>(size_chunk); ++y) {
-        for (auto x = 0; x < static_cast<int>(size_chunk); ++x) {
-            update_render_data(x, y);
+        if (auto const block = terrain_entries_.find_block(x0, y0)) {
+            for_each_cell(*block, x0, y0, [&](int const x, int const y, terrain_entry const& ter) {
+                render_data_->update_terrain(ter, bklib::ipoint2 {x, y});
+            });
+
+            render_data_->touch_block(bklib::ipoint2 {x0, y0});
         }
     }
+
+    dirty_blocks_.clear();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -486,6 +1223,52 @@ bkrl::creature bkrl::map::remove_creature_at(bklib::ipoint2 const p)
     return creatures_.remove(p);
 }
 
+//--------------------------------------------------------------------------------------------------
+bkrl::creature bkrl::map::remove_creature(creature_handle const h)
+{
+    auto const c = creatures_.get(h);
+    BK_PRECONDITION(c);
+
+    render_data_->clear_creature_at(c->position());
+    return creatures_.remove(h);
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::item_handle bkrl::map::items_handle_at(bklib::ipoint2 const p) const
+{
+    return items_.handle_at(p);
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::item_pile* bkrl::map::get_items(item_handle const h)
+{
+    return items_.get(h);
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::item_pile const* bkrl::map::get_items(item_handle const h) const
+{
+    return items_.get(h);
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::creature_handle bkrl::map::creature_handle_at(bklib::ipoint2 const p) const
+{
+    return creatures_.handle_at(p);
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::creature* bkrl::map::get_creature(creature_handle const h)
+{
+    return creatures_.get(h);
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::creature const* bkrl::map::get_creature(creature_handle const h) const
+{
+    return creatures_.get(h);
+}
+
 //--------------------------------------------------------------------------------------------------
 bkrl::item_pile* bkrl::map::items_at(bklib::ipoint2 const p)
 {
@@ -540,6 +1323,110 @@ bool bkrl::map::can_place_creature_at(bklib::ipoint2 const p) const
     return !creature_at(p);
 }
 
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_creature_in(
+    bklib::irect const r
+  , std::function<void (creature&)> const& f
+) {
+    creatures_.for_each_at(r, [&](bklib::ipoint2, creature& c) { f(c); });
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_creature_in(
+    bklib::irect const r
+  , std::function<void (creature const&)> const& f
+) const {
+    creatures_.for_each_at(r, [&](bklib::ipoint2, creature const& c) { f(c); });
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_creature_in_radius(
+    bklib::ipoint2 const p
+  , int const r
+  , std::function<void (creature&)> const& f
+) {
+    creatures_.for_each_in_radius(p, r, [&](bklib::ipoint2, creature& c) { f(c); });
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_creature_in_radius(
+    bklib::ipoint2 const p
+  , int const r
+  , std::function<void (creature const&)> const& f
+) const {
+    creatures_.for_each_in_radius(p, r, [&](bklib::ipoint2, creature const& c) { f(c); });
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_creature_in_circle(
+    bklib::ipoint2 const p
+  , int const r
+  , std::function<void (creature&)> const& f
+) {
+    creatures_.for_each_in_circle(p, r, [&](bklib::ipoint2, creature& c) { f(c); });
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_creature_in_circle(
+    bklib::ipoint2 const p
+  , int const r
+  , std::function<void (creature const&)> const& f
+) const {
+    creatures_.for_each_in_circle(p, r, [&](bklib::ipoint2, creature const& c) { f(c); });
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_items_in(
+    bklib::irect const r
+  , std::function<void (bklib::ipoint2, item_pile&)> const& f
+) {
+    items_.for_each_at(r, f);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_items_in(
+    bklib::irect const r
+  , std::function<void (bklib::ipoint2, item_pile const&)> const& f
+) const {
+    items_.for_each_at(r, f);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_items_in_radius(
+    bklib::ipoint2 const p
+  , int const r
+  , std::function<void (bklib::ipoint2, item_pile&)> const& f
+) {
+    items_.for_each_in_radius(p, r, f);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_items_in_radius(
+    bklib::ipoint2 const p
+  , int const r
+  , std::function<void (bklib::ipoint2, item_pile const&)> const& f
+) const {
+    items_.for_each_in_radius(p, r, f);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_items_in_circle(
+    bklib::ipoint2 const p
+  , int const r
+  , std::function<void (bklib::ipoint2, item_pile&)> const& f
+) {
+    items_.for_each_in_circle(p, r, f);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::map::for_each_items_in_circle(
+    bklib::ipoint2 const p
+  , int const r
+  , std::function<void (bklib::ipoint2, item_pile const&)> const& f
+) const {
+    items_.for_each_in_circle(p, r, f);
+}
+
 //--------------------------------------------------------------------------------------------------
 bkrl::placement_result_t
 bkrl::generate_creature(context& ctx, map& m, creature_def const& def, bklib::ipoint2 const p) {
@@ -625,7 +1512,7 @@ void bkrl::advance(context& ctx, map& m)
 //--------------------------------------------------------------------------------------------------
 bool bkrl::set_door_state(map& m, bklib::ipoint2 const p, door::state const state)
 {
-    auto& ter = m.at(p);
+    auto ter = m.at(p);
     door d {ter};
 
     if (!d.set_open_close(state)) {
@@ -633,7 +1520,6 @@ bool bkrl::set_door_state(map& m, bklib::ipoint2 const p, door::state const stat
     }
 
     ter = d;
-    m.update_render_data(p);
 
     return true;
 }
@@ -6,16 +6,30 @@
 #include "identifier.hpp"
 #include "random.hpp"
 #include "direction.hpp"
+#include "chunk_pager.hpp"
+#include "scheduler.hpp"
+#include "activity.hpp"
+#include "distance_map.hpp"
 
 #include "bklib/math.hpp"
 #include "bklib/spatial_map.hpp"
+#include "bklib/assert.hpp"
 
 #include <array>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <type_traits>
+#include <utility>
 #include <bitset>
 #include <vector>
 #include <functional>
 #include <cstdint>
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace bklib { class worker_pool; }
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 namespace bkrl {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -28,6 +42,30 @@ struct color_def;
 constexpr size_t size_block = 16;
 constexpr size_t size_chunk = size_block * size_block;
 
+//! The block containing the cell coordinate @p n; for both positive and negative n.
+constexpr int block_of(int const n) noexcept {
+    return bklib::floor_div(n, static_cast<int>(size_block));
+}
+
+//! The key of the block containing the cell (x, y); see bklib::grid_key.
+constexpr uint64_t block_key(int const x, int const y) noexcept {
+    return bklib::grid_key(block_of(x), block_of(y));
+}
+
+//! The smallest region of whole blocks containing @p r.
+inline bklib::irect round_to_blocks(bklib::irect const r) noexcept {
+    constexpr auto const size = static_cast<int>(size_block);
+    return {block_of(r.left) * size, block_of(r.top) * size
+          , (block_of(r.right - 1) + 1) * size, (block_of(r.bottom - 1) + 1) * size};
+}
+
+//! How many steps from the player aggressive creatures notice it, and chase it from.
+constexpr int chase_range = 32;
+
+//! The fewest creatures acting at once for deciding on their actions to be split between workers
+//! (see map::set_worker_count); handing out smaller rounds costs more than it saves.
+constexpr size_t min_split_round = 512;
+
 //--------------------------------------------------------------------------------------------------
 //! Base map data block 16 x 16 currently (see size_block)
 //--------------------------------------------------------------------------------------------------
@@ -56,48 +94,403 @@ struct block_t {
     std::array<T, size_block * size_block> data;
 };
 
+struct terrain_block_t;
+class  map;
+
 //--------------------------------------------------------------------------------------------------
-//! Map "chunk" consisting of 16 x 16 block_t currently (see size_chunk)
+//! A reference to a terrain_entry stored in a terrain_block_t; it reads and writes the entry's
+//! fields in their separate planes. Assigning to it, or to one of its fields, assigns to the
+//! referenced entry and brings the block's passability and opacity masks up to date; for a cell of
+//! a map (see map::at) it also marks the cell's block as written. Reading is never a write.
+//! A reference to a cell of a paged map (see map::at) keeps the cell's chunk in memory for as long
+//! as it exists, so keep references short lived.
 //--------------------------------------------------------------------------------------------------
-template <typename T>
-struct chunk_t {
-    chunk_t() {
-        data.resize(size_block * size_block);
+struct terrain_ref {
+    //! A field of the referenced entry; reads as its value, and assigning to it is a write.
+    template <typename T>
+    class field_ref {
+    public:
+        field_ref(terrain_ref& owner, T& value) noexcept
+          : owner_ (owner)
+          , value_ (value)
+        {
+        }
+
+        field_ref(field_ref const&) = delete;
+
+        field_ref& operator=(field_ref const& rhs) noexcept {
+            return *this = static_cast<T>(rhs);
+        }
+
+        field_ref& operator=(T const value) noexcept {
+            value_ = value;
+            owner_.on_write_();
+            return *this;
+        }
+
+        operator T() const noexcept {
+            return value_;
+        }
+    private:
+        terrain_ref& owner_;
+        T&           value_;
+    };
+
+    terrain_ref(terrain_block_t& block, size_t index) noexcept;
+
+    //! A reference to the cell at (x, y) of @p m, stored in @p block; pins the cell's chunk.
+    terrain_ref(terrain_block_t& block, map& m, int x, int y) noexcept;
+
+    terrain_ref(terrain_ref const& other) noexcept;
+    ~terrain_ref();
+
+    terrain_ref& operator=(terrain_ref const& rhs) noexcept {
+        return *this = static_cast<terrain_entry>(rhs);
     }
 
-    block_t<T>& block_at(int const x, int const y) noexcept {
-        auto const yi = static_cast<size_t>(y) / size_block;
-        auto const xi = static_cast<size_t>(x) / size_block;
-        return data[yi * size_block + xi];
+    terrain_ref& operator=(terrain_entry const& rhs) noexcept;
+
+    template <typename T
+        , std::enable_if_t<std::is_base_of<terrain_data_base, T>::value>* = nullptr>
+    terrain_ref& operator=(T const& other) {
+        data = other.to_data();
+        return *this;
     }
 
-    T& cell_at(int const x, int const y) noexcept {
-        auto const yb = static_cast<size_t>(y) / size_block;
+    operator terrain_entry() const noexcept;
+
+    field_ref<terrain_type>  type;
+    field_ref<uint16_t>      variant;
+    field_ref<terrain_flags> flags;
+    field_ref<uint64_t>      data;
+private:
+    terrain_ref(terrain_block_t& block, size_t index, map* m, int x, int y) noexcept;
+
+    void on_write_() noexcept;
+
+    terrain_block_t* block_;
+    size_t           index_;
+    map*             map_; //!< the map the cell belongs to, if any; see map::at
+    int              x_;
+    int              y_;
+};
+
+//--------------------------------------------------------------------------------------------------
+//! Structure of arrays counterpart to block_t<terrain_entry>: each field of the entries in the
+//! block lives in its own contiguous plane, so scans that only look at e.g. the type touch only
+//! that plane. Cells are accessed through terrain_ref, or by value when const.
+//!
+//! The block also keeps one bit per cell of whether it is passable and whether it is opaque (see
+//! is_passable and is_opaque), bit (y * size_block + x) % 64 of word (y * size_block + x) / 64.
+//! Passability is stored inverted so that a zeroed block, all terrain_type::empty, is consistent.
+//--------------------------------------------------------------------------------------------------
+struct terrain_block_t {
+    static constexpr size_t cell_count = size_block * size_block;
+    static constexpr size_t word_count = cell_count / 64;
+
+    terrain_ref cell_at(int const x, int const y) noexcept {
+        return {*this, index_of(x, y)};
+    }
+
+    terrain_entry cell_at(int const x, int const y) const noexcept {
+        return entry_at_(index_of(x, y));
+    }
+
+    bool is_passable(int const x, int const y) const noexcept {
+        return !test_(impassable, index_of(x, y));
+    }
+
+    bool is_opaque(int const x, int const y) const noexcept {
+        return test_(opaque, index_of(x, y));
+    }
+
+    //! The index of the cell at (x, y) within the planes; x and y are world coordinates.
+    static size_t index_of(int const x, int const y) noexcept {
         auto const yi = static_cast<size_t>(y) % size_block;
-        auto const xb = static_cast<size_t>(x) / size_block;
         auto const xi = static_cast<size_t>(x) % size_block;
+        return yi * size_block + xi;
+    }
 
-        return data[yb * size_block + xb].data[yi * size_block + xi];
+    //! Recompute the mask bits for the cell at @p i from its entry.
+    void update_masks(size_t const i) noexcept {
+        auto const ter = entry_at_(i);
+        assign_(impassable, i, !bkrl::is_passable(ter));
+        assign_(opaque,     i,  bkrl::is_opaque(ter));
     }
 
-    T const& cell_at(int const x, int const y) const noexcept {
-        return const_cast<chunk_t*>(this)->cell_at(x, y);
+    template <typename Function>
+    void for_each_cell(Function&& f, int const x0, int const y0) const {
+        for (auto i = 0u; i < cell_count; ++i) {
+            auto const yi = i / size_block;
+            auto const xi = i % size_block;
+            f(x0 + xi, y0 + yi, entry_at_(i));
+        }
+    }
+
+    std::array<terrain_type,  cell_count> type;
+    std::array<uint16_t,      cell_count> variant;
+    std::array<terrain_flags, cell_count> flags;
+    std::array<uint64_t,      cell_count> data;
+
+    std::array<uint64_t, word_count> impassable;
+    std::array<uint64_t, word_count> opaque;
+private:
+    static bool test_(std::array<uint64_t, word_count> const& mask, size_t const i) noexcept {
+        return !!(mask[i / 64] & (uint64_t {1} << (i % 64)));
+    }
+
+    static void assign_(std::array<uint64_t, word_count>& mask, size_t const i, bool const value) noexcept {
+        auto const bit = uint64_t {1} << (i % 64);
+        mask[i / 64] = value ? (mask[i / 64] | bit) : (mask[i / 64] & ~bit);
     }
 
-    block_t<T> const& block_at(int const x, int const y) const noexcept {
+    terrain_entry entry_at_(size_t const i) const noexcept {
+        return terrain_entry {data[i], flags[i], type[i], variant[i]};
+    }
+};
+
+//--------------------------------------------------------------------------------------------------
+//! Map "chunk" consisting of 16 x 16 blocks currently (see size_chunk); the blocks are block_t<T>
+//! unless another layout for them is given (e.g. terrain_block_t).
+//--------------------------------------------------------------------------------------------------
+template <typename T, typename Block = block_t<T>>
+struct chunk_t {
+    static constexpr size_t block_count = size_block * size_block;
+
+    chunk_t()
+      : owned {std::make_unique<Block[]>(block_count)}
+      , data  {owned.get()}
+    {
+    }
+
+    //! A chunk using @p storage for its blocks (e.g. a mapped page) rather than allocating its own.
+    //! @pre @p storage holds at least block_count blocks and outlives the chunk.
+    explicit chunk_t(Block* const storage) noexcept
+      : data {storage}
+    {
+    }
+
+    //! @p x and @p y are world coordinates; only their position within the chunk is used.
+    Block& block_at(int const x, int const y) noexcept {
+        auto const yi = (static_cast<size_t>(y) % size_chunk) / size_block;
+        auto const xi = (static_cast<size_t>(x) % size_chunk) / size_block;
+        return data[yi * size_block + xi];
+    }
+
+    Block const& block_at(int const x, int const y) const noexcept {
         return const_cast<chunk_t*>(this)->block_at(x, y);
     }
 
+    decltype(auto) cell_at(int const x, int const y) noexcept {
+        return block_at(x, y).cell_at(x, y);
+    }
+
+    decltype(auto) cell_at(int const x, int const y) const noexcept {
+        return block_at(x, y).cell_at(x, y);
+    }
+
     template <typename Function>
     void for_each_cell(Function&& f, int const x0, int const y0) const {
-        for (auto i = 0u; i < data.size(); ++i) {
+        for (auto i = 0u; i < block_count; ++i) {
             auto const yi = i / size_block;
             auto const xi = i % size_block;
             data[i].for_each_cell(std::forward<Function>(f), x0 + xi * size_block, y0 + yi * size_block);
         }
     }
 
-    std::vector<block_t<T>> data;
+    std::unique_ptr<Block[]> owned; //!< nullptr if the blocks are stored elsewhere
+    Block*                   data;
+};
+
+//--------------------------------------------------------------------------------------------------
+//! Sparse, unbounded grid of chunk_t addressed by chunk coordinate.
+//! Chunks are allocated on the first non-const access to one of their cells; cells in chunks that
+//! have never been allocated read as a value initialized T and use no memory.
+//!
+//! With a pager (see set_pager) chunks live in pages of the pager's file instead, and the least
+//! recently used chunks are unmapped to stay within its budget; they're mapped back in when next
+//! accessed. A reference to a cell is then only valid until another chunk is accessed, unless its
+//! chunk is pinned (see pin). Any access, const or not, can then map a chunk back in and throw
+//! whatever chunk_pager::map throws.
+//!
+//! Const access from several threads at once is safe as long as there is no pager.
+//--------------------------------------------------------------------------------------------------
+template <typename T, typename Block = block_t<T>>
+class chunk_table_t {
+public:
+    using chunk_type      = chunk_t<T, Block>;
+    using const_reference = decltype(std::declval<Block const&>().cell_at(0, 0));
+
+    //----------------------------------------------------------------------------------------------
+    //! @param on_page_out Called as on_page_out(x, y) with the top left cell of each chunk as it is
+    //!        paged out; for dropping anything kept alongside the chunk.
+    //! @param on_page_in  Likewise as each chunk is paged (back) in, including the first time.
+    //! @pre no chunks have been allocated yet.
+    //----------------------------------------------------------------------------------------------
+    void set_pager(std::unique_ptr<chunk_pager> pager
+      , std::function<void (int, int)> on_page_out = {}
+      , std::function<void (int, int)> on_page_in  = {}
+    ) {
+        static_assert(std::is_trivially_copyable<Block>::value, "Block must be trivially copyable to be paged");
+
+        BK_PRECONDITION(chunks_.empty());
+        BK_PRECONDITION(!pager || pager->page_size() >= sizeof(Block) * chunk_type::block_count);
+
+        pager_       = std::move(pager);
+        on_page_out_ = std::move(on_page_out);
+        on_page_in_  = std::move(on_page_in);
+    }
+
+    decltype(auto) cell_at(int const x, int const y) {
+        return chunk_at_(x, y).cell_at(x, y);
+    }
+
+    const_reference cell_at(int const x, int const y) const {
+        auto const chunk = find_chunk_(x, y);
+        return chunk ? chunk->cell_at(x, y) : empty_value_();
+    }
+
+    Block& block_at(int const x, int const y) {
+        return chunk_at_(x, y).block_at(x, y);
+    }
+
+    //! @return the block containing (x, y), or nullptr if it hasn't been allocated.
+    Block const* find_block(int const x, int const y) const {
+        auto const chunk = find_chunk_(x, y);
+        return chunk ? &chunk->block_at(x, y) : nullptr;
+    }
+
+    //! Call f(chunk, x, y) for each allocated chunk; (x, y) is the chunk's top left cell.
+    template <typename Function>
+    void for_each_chunk(Function&& f) const {
+        for (auto const& c : chunks_) {
+            f(static_cast<chunk_type const&>(*c.second)
+              , bklib::grid_key_x(c.first) * chunk_size_, bklib::grid_key_y(c.first) * chunk_size_);
+        }
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Keep the chunk containing (x, y) in memory until a matching unpin(); pins nest. Nothing if
+    //! there is no pager.
+    //! @pre the chunk is in memory; e.g. one of its cells has just been accessed.
+    //----------------------------------------------------------------------------------------------
+    void pin(int const x, int const y) noexcept {
+        if (pager_) {
+            pager_->pin(key_(x, y));
+        }
+    }
+
+    void unpin(int const x, int const y) noexcept {
+        if (pager_) {
+            pager_->unpin(key_(x, y));
+        }
+    }
+
+    //! The number of chunks currently in memory.
+    size_t chunk_count() const noexcept {
+        return chunks_.size();
+    }
+
+    bool is_paged() const noexcept {
+        return !!pager_;
+    }
+
+    //! @return false if the chunk containing (x, y) is paged out; always true if there's no pager.
+    bool is_resident(int const x, int const y) const noexcept {
+        return !pager_ || chunks_.find(key_(x, y)) != std::end(chunks_);
+    }
+private:
+    static constexpr int chunk_size_ = static_cast<int>(size_chunk);
+
+    static uint64_t key_(int const x, int const y) noexcept {
+        return bklib::grid_key(bklib::floor_div(x, chunk_size_), bklib::floor_div(y, chunk_size_));
+    }
+
+    static T const& empty_value_() noexcept {
+        static T const value {};
+        return value;
+    }
+
+    chunk_type* find_chunk_(int const x, int const y) const {
+        auto const key  = key_(x, y);
+        auto const last = last_.load(std::memory_order_relaxed);
+        if (last && key == last->first) {
+            return last->second.get();
+        }
+
+        auto const it = chunks_.find(key);
+        if (it == std::end(chunks_)) {
+            // chunks that have been paged out still exist
+            return (pager_ && pager_->has_page(key))
+              ? const_cast<chunk_table_t*>(this)->page_in_(key)
+              : nullptr;
+        }
+
+        if (pager_) {
+            pager_->touch(key);
+        }
+
+        last_.store(&*it, std::memory_order_relaxed);
+
+        return it->second.get();
+    }
+
+    chunk_type& chunk_at_(int const x, int const y) {
+        if (auto const chunk = find_chunk_(x, y)) {
+            return *chunk;
+        }
+
+        auto const key = key_(x, y);
+
+        if (pager_) {
+            return *page_in_(key);
+        }
+
+        auto const it = chunks_.emplace(key, std::make_unique<chunk_type>()).first;
+        last_.store(&*it, std::memory_order_relaxed);
+
+        return *it->second;
+    }
+
+    //! Map the page for @p key, then unmap least recently used chunks until within budget; pinned
+    //! chunks stay, so if only the new chunk could go, stay over budget for now.
+    chunk_type* page_in_(uint64_t const key) {
+        auto const storage = static_cast<Block*>(pager_->map(key));
+        auto const it = chunks_.emplace(key, nullptr).first;
+        it->second = std::make_unique<chunk_type>(storage);
+
+        last_.store(&*it, std::memory_order_relaxed);
+
+        if (on_page_in_) {
+            on_page_in_(bklib::grid_key_x(key) * chunk_size_, bklib::grid_key_y(key) * chunk_size_);
+        }
+
+        while (pager_->over_budget() && pager_->lru() != key) {
+            auto const victim = pager_->lru();
+            BK_ASSERT(!pager_->is_pinned(victim));
+
+            chunks_.erase(victim);
+            pager_->unmap(victim);
+
+            if (on_page_out_) {
+                on_page_out_(bklib::grid_key_x(victim) * chunk_size_
+                           , bklib::grid_key_y(victim) * chunk_size_);
+            }
+        }
+
+        return it->second.get();
+    }
+
+    using table_t = std::unordered_map<uint64_t, std::unique_ptr<chunk_type>>;
+
+    table_t                        chunks_;
+    std::unique_ptr<chunk_pager>   pager_;
+    std::function<void (int, int)> on_page_out_;
+    std::function<void (int, int)> on_page_in_;
+
+    //! The entry of the most recently accessed chunk; atomic so that concurrent readers can update
+    //! it (see above). Entries are only erased when paging, and never the one being accessed.
+    mutable std::atomic<typename table_t::value_type const*> last_ {nullptr};
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -158,20 +551,119 @@ struct room_data_t {
 //--------------------------------------------------------------------------------------------------
 class map {
 public:
+    //! A map with the default bounds of a single chunk.
     map();
+
+    //! An empty map with the given bounds; the bounds may be arbitrarily large.
+    explicit map(bklib::irect bounds);
+
     explicit map(context& ctx);
     ~map();
 
     void set_draw_colors(bklib::dictionary<color_def> const& colors);
     void draw(renderer& render, view const& v) const;
+
+    //----------------------------------------------------------------------------------------------
+    //! Draw an overview of the whole map (see bounds) scaled to fit @p dst, in screen coordinates.
+    //! Below a zoom of 0.5 draw() uses the same overview in place of the terrain.
+    //----------------------------------------------------------------------------------------------
+    void draw_minimap(renderer& render, bklib::irect dst) const;
+
+    //----------------------------------------------------------------------------------------------
+    //! Advance the map by a turn; only the creatures due to act in it are touched.
+    //! The creatures due to act at the same time act one at a time in the order they were
+    //! scheduled. What each does doesn't depend on who is where (see bkrl::decide), so deciding can
+    //! happen for all of them before any action is applied (see bkrl::apply) with the same result.
+    //----------------------------------------------------------------------------------------------
     void advance(context& ctx);
 
+    //----------------------------------------------------------------------------------------------
+    //! Split deciding on actions between @p workers threads besides the calling one, for rounds of
+    //! at least @p min_round creatures acting at the same time; smaller rounds decide and act in a
+    //! single pass on the calling thread. The results are the same for any number of workers.
+    //! While terrain is paged (see enable_paging) it can't be read from several threads, and
+    //! deciding stays on the calling thread.
+    //----------------------------------------------------------------------------------------------
+    void set_worker_count(size_t workers, size_t min_round = min_split_round);
+
+    //! The time up to which the map has been advanced.
+    game_time now() const noexcept {
+        return scheduler_.now();
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Creatures further than @p radius blocks (see size_block) from the player, and out of range
+    //! of any noise made during the previous turn (see make_noise), are dormant: they take no
+    //! actions and cost nothing per turn. When their block becomes active again they catch up on
+    //! the time spent asleep in a single step (see bkrl::catch_up). A radius of 0, the default,
+    //! keeps every creature active.
+    //! @pre radius >= 0
+    //----------------------------------------------------------------------------------------------
+    void set_activity_radius(int radius);
+
+    //! Make the creatures within @p radius blocks of @p p active for the next turn.
+    void make_noise(bklib::ipoint2 const p, int const radius) {
+        activity_.make_noise(p, radius);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Distances to the player over the terrain, within chase_range steps of it. Only kept up to
+    //! date while aggressive creatures are deciding what to do (see bkrl::decide), which read the
+    //! way to the player from it rather than each searching for a path.
+    //----------------------------------------------------------------------------------------------
+    distance_map const& player_distances() const noexcept {
+        return player_distances_;
+    }
+
+    //! The number of creatures that have been put to sleep and not yet woken.
+    size_t dormant_count() const noexcept {
+        return activity_.dormant_count();
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Between begin_batch() and end_batch() creatures and items can be placed without the
+    //! per-placement search of the render data; the pending updates are merged in one pass when
+    //! the batch ends, or before anything is moved or removed. Lookups are unaffected.
+    //----------------------------------------------------------------------------------------------
+    void begin_batch();
+    void end_batch();
+
     void move_creature_to(creature& c, bklib::ipoint2 p);
     void move_creature_to(instance_id_t<tag_creature> id, bklib::ipoint2 p);
 
+    //----------------------------------------------------------------------------------------------
+    //! @pre @p h must refer to a creature on this map.
+    //----------------------------------------------------------------------------------------------
+    void move_creature_to(creature_handle h, bklib::ipoint2 p);
+
     creature const* find_creature(std::function<bool (creature const&)> const& predicate) const;
     creature* find_creature(std::function<bool (creature const&)> const& predicate);
 
+    //----------------------------------------------------------------------------------------------
+    //! The (up to) @p k creatures nearest to @p p, and no further than @p max_distance, for which
+    //! pred(creature const&) is true; nearest first.
+    //----------------------------------------------------------------------------------------------
+    template <typename Predicate>
+    std::vector<creature*> nearest_creatures(
+        bklib::ipoint2 const p, size_t const k, int const max_distance, Predicate&& pred
+    ) {
+        return creatures_.nearest(p, k, max_distance, [&](bklib::ipoint2, creature const& c) {
+            return pred(c);
+        });
+    }
+
+    template <typename Predicate>
+    std::vector<creature const*> nearest_creatures(
+        bklib::ipoint2 const p, size_t const k, int const max_distance, Predicate&& pred
+    ) const {
+        return creatures_.nearest(p, k, max_distance, [&](bklib::ipoint2, creature const& c) {
+            return pred(c);
+        });
+    }
+
+    std::vector<creature*>       nearest_creatures(bklib::ipoint2 p, size_t k, int max_distance);
+    std::vector<creature const*> nearest_creatures(bklib::ipoint2 p, size_t k, int max_distance) const;
+
     //----------------------------------------------------------------------------------------------
     //! @pre @p p must be a valid map position.
     //----------------------------------------------------------------------------------------------
@@ -181,12 +673,15 @@ public:
     //----------------------------------------------------------------------------------------------
     //! @pre @p p must be a valid map position.
     //! @pre a creature must not already exist at @p p.
+    //! Creatures other than the player first act on the following turn.
     //----------------------------------------------------------------------------------------------
     void place_creature_at(creature&& c, creature_def const& def, bklib::ipoint2 p);
 
-    void update_render_data(bklib::ipoint2 p);
-    void update_render_data(int x, int y);
-    void update_render_data();
+    //----------------------------------------------------------------------------------------------
+    //! Rebuild the terrain render data for the blocks written to since the last update. draw()
+    //! does this itself; there is no need to call it after changing terrain.
+    //----------------------------------------------------------------------------------------------
+    void update_render_data() const;
 
     //----------------------------------------------------------------------------------------------
     //! @pre @p p must be a valid map position.
@@ -208,9 +703,26 @@ public:
     //----------------------------------------------------------------------------------------------
     creature remove_creature_at(bklib::ipoint2 p);
 
+    //----------------------------------------------------------------------------------------------
+    //! @pre @p h must refer to a creature on this map.
+    //----------------------------------------------------------------------------------------------
+    creature remove_creature(creature_handle h);
+
     item_pile*       items_at(bklib::ipoint2 p);
     item_pile const* items_at(bklib::ipoint2 p) const;
 
+    //----------------------------------------------------------------------------------------------
+    //! Handles remain valid until the object they refer to is removed from the map; after that
+    //! they are stale and get_* returns nullptr.
+    //----------------------------------------------------------------------------------------------
+    item_handle      items_handle_at(bklib::ipoint2 p) const;
+    item_pile*       get_items(item_handle h);
+    item_pile const* get_items(item_handle h) const;
+
+    creature_handle creature_handle_at(bklib::ipoint2 p) const;
+    creature*       get_creature(creature_handle h);
+    creature const* get_creature(creature_handle h) const;
+
     bool can_place_item_at(bklib::ipoint2 p) const;
 
     creature*       creature_at(bklib::ipoint2 p);
@@ -218,20 +730,97 @@ public:
 
     bool can_place_creature_at(bklib::ipoint2 p) const;
 
+    //----------------------------------------------------------------------------------------------
+    //! Range queries; only the creatures / items near the query region are visited.
+    //! *_in_radius uses the Chebyshev (8-way step) distance; *_in_circle the Euclidean distance.
+    //! @pre f must not add, remove or move creatures / items.
+    //----------------------------------------------------------------------------------------------
+    void for_each_creature_in(bklib::irect r, std::function<void (creature&)> const& f);
+    void for_each_creature_in(bklib::irect r, std::function<void (creature const&)> const& f) const;
+    void for_each_creature_in_radius(bklib::ipoint2 p, int r, std::function<void (creature&)> const& f);
+    void for_each_creature_in_radius(bklib::ipoint2 p, int r, std::function<void (creature const&)> const& f) const;
+    void for_each_creature_in_circle(bklib::ipoint2 p, int r, std::function<void (creature&)> const& f);
+    void for_each_creature_in_circle(bklib::ipoint2 p, int r, std::function<void (creature const&)> const& f) const;
+
+    void for_each_items_in(bklib::irect r, std::function<void (bklib::ipoint2, item_pile&)> const& f);
+    void for_each_items_in(bklib::irect r, std::function<void (bklib::ipoint2, item_pile const&)> const& f) const;
+    void for_each_items_in_radius(bklib::ipoint2 p, int r, std::function<void (bklib::ipoint2, item_pile&)> const& f);
+    void for_each_items_in_radius(bklib::ipoint2 p, int r, std::function<void (bklib::ipoint2, item_pile const&)> const& f) const;
+    void for_each_items_in_circle(bklib::ipoint2 p, int r, std::function<void (bklib::ipoint2, item_pile&)> const& f);
+    void for_each_items_in_circle(bklib::ipoint2 p, int r, std::function<void (bklib::ipoint2, item_pile const&)> const& f) const;
+
+    //----------------------------------------------------------------------------------------------
+    //! The region the level occupies; terrain can be read and written outside of it, but level
+    //! generation and creature / item placement are limited to it.
+    //----------------------------------------------------------------------------------------------
     bklib::irect bounds() const noexcept {
-        return {0, 0, static_cast<int>(size_chunk), static_cast<int>(size_chunk)};
+        return bounds_;
     }
 
-    terrain_entry& at(int const x, int const y) noexcept {
-        return terrain_entries_.block_at(x, y).cell_at(x, y);
+    //----------------------------------------------------------------------------------------------
+    //! Terrain storage is allocated a chunk (size_chunk x size_chunk) at a time on the first
+    //! non-const access; const access to untouched terrain reads as terrain_type::empty.
+    //! Terrain is stored a field per plane (see terrain_block_t), so non-const access returns a
+    //! terrain_ref rather than a terrain_entry&; while paged, its chunk stays in memory for as long
+    //! as the reference exists. Writes through the reference mark the block for its render data to
+    //! be rebuilt (see update_render_data) and change terrain_revision.
+    //! While paged (see enable_paging), reads as well as writes can page terrain back in, and so
+    //! throw bklib::io_error.
+    //----------------------------------------------------------------------------------------------
+    terrain_ref at(int const x, int const y) {
+        return {terrain_entries_.block_at(x, y), *this, x, y};
+    }
+
+    terrain_entry at(int const x, int const y) const {
+        return terrain_entries_.cell_at(x, y);
+    }
+
+    terrain_entry at(bklib::ipoint2 const p) const { return at(x(p), y(p)); }
+    terrain_ref   at(bklib::ipoint2 const p)       { return at(x(p), y(p)); }
+
+    //----------------------------------------------------------------------------------------------
+    //! Bit lookups kept up to date with every terrain write; equivalent to
+    //! bkrl::is_passable(at(p)) and bkrl::is_opaque(at(p)).
+    //----------------------------------------------------------------------------------------------
+    bool is_passable(bklib::ipoint2 const p) const {
+        auto const block = terrain_entries_.find_block(x(p), y(p));
+        return !block || block->is_passable(x(p), y(p));
     }
 
-    terrain_entry const& at(int const x, int const y) const noexcept {
-        return const_cast<map*>(this)->at(x, y);
+    bool is_opaque(bklib::ipoint2 const p) const {
+        auto const block = terrain_entries_.find_block(x(p), y(p));
+        return block && block->is_opaque(x(p), y(p));
     }
 
-    terrain_entry const& at(bklib::ipoint2 const p) const noexcept { return const_cast<map*>(this)->at(p); }
-    terrain_entry&       at(bklib::ipoint2 const p)       noexcept { return at(x(p), y(p)); }
+    //! The terrain block containing @p p, or nullptr if it hasn't been allocated (all empty); for
+    //! scanning its planes or masks directly.
+    terrain_block_t const* find_terrain_block(bklib::ipoint2 const p) const {
+        return terrain_entries_.find_block(x(p), y(p));
+    }
+
+    //! Changes whenever terrain is written (see at); revisions are unique across all maps. For
+    //! caching things derived from the terrain, such as path_finder's.
+    uint64_t terrain_revision() const noexcept {
+        return terrain_revision_;
+    }
+
+    //! The number of terrain chunks in memory.
+    size_t chunk_count() const noexcept {
+        return terrain_entries_.chunk_count();
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! Page terrain (and its render data) out to files named after @p filename, keeping at most
+    //! about @p budget bytes of it in memory; the chunks used least recently are paged out first.
+    //! The overviews (see draw_minimap) of chunks are dropped along with their render data, and
+    //! rebuilt when next drawn.
+    //! The creatures (other than the player) and items on a chunk follow it out, and back in, at
+    //! the start of the next advance; until then they stay on the map as usual. Creatures that
+    //! come back catch up on the time they spent paged out (see catch_up) once active again.
+    //! @pre no terrain has been written yet.
+    //! @throws bklib::io_error if the page files can't be created.
+    //----------------------------------------------------------------------------------------------
+    void enable_paging(bklib::utf8_string_view filename, size_t budget);
 
     void fill(bklib::irect r, terrain_type value);
     void fill(bklib::irect r, terrain_type value, terrain_type border);
@@ -240,16 +829,132 @@ public:
         rooms_.push_back(std::move(data));
     }
 private:
+    friend struct terrain_ref;
+
+    static uint64_t next_terrain_revision_() noexcept;
+
+    void mark_dirty_(int const x, int const y) {
+        terrain_revision_ = next_terrain_revision_();
+
+        auto const key = block_key(x, y);
+
+        // writes tend to come in runs within the same block
+        if (!dirty_blocks_.empty() && key == last_dirty_) {
+            return;
+        }
+
+        dirty_blocks_.insert(key);
+        last_dirty_ = key;
+    }
+
+    //! Fill in the decisions for round_ using workers_, if the round is worth splitting up.
+    //! @pre workers_ is set, and terrain isn't paged.
+    //! @return false if nothing was decided, and each creature should decide as it acts.
+    bool decide_round_(uint64_t seed);
+
+    //! Bring player_distances_ up to date with the position of the player and the terrain.
+    void update_player_distances_();
+
+    //! Page the creatures and items of chunks paged out since the last call out to payloads_, and
+    //! those of chunks paged back in since then back in; see enable_paging.
+    void page_payloads_(definitions const& defs);
+
     class render_data_t;
     std::unique_ptr<render_data_t> render_data_;
 
-    chunk_t<terrain_entry> terrain_entries_;
+    bklib::irect bounds_;
+
+    chunk_table_t<terrain_entry, terrain_block_t> terrain_entries_;
+
+    mutable std::unordered_set<uint64_t> dirty_blocks_; //!< blocks with stale render data
+    uint64_t                             last_dirty_ = 0;
+    uint64_t                             terrain_revision_ = next_terrain_revision_();
+
+    std::unique_ptr<payload_pager>      payloads_;  //!< nullptr unless paged; see page_payloads_
+    mutable std::vector<bklib::ipoint2> paged_out_; //!< chunks paged out since page_payloads_
+    mutable std::vector<bklib::ipoint2> paged_in_;  //!< chunks paged in since page_payloads_
+
+    creature_map     creatures_;
+    turn_scheduler   scheduler_; //!< the next action of each active creature other than the player
+    activity_regions activity_;
+    creature_handle  player_;
+
+    struct pending_action_t {
+        creature_handle who;
+        creature_action what;
+    };
+
+    std::vector<pending_action_t>       round_;   //!< the creatures acting at the current time
+    std::unique_ptr<bklib::worker_pool> workers_; //!< nullptr if decisions aren't split
+    size_t                              min_split_ = min_split_round;
+    distance_map                        player_distances_ {chase_range};
 
-    creature_map creatures_;
-    item_map     items_;
+    item_map         items_;
     std::vector<room_data_t> rooms_;
 };
 
+//--------------------------------------------------------------------------------------------------
+inline terrain_ref::terrain_ref(
+    terrain_block_t& block, size_t const index, map* const m, int const x, int const y
+) noexcept
+  : type    (*this, block.type[index])
+  , variant (*this, block.variant[index])
+  , flags   (*this, block.flags[index])
+  , data    (*this, block.data[index])
+  , block_  {&block}
+  , index_  {index}
+  , map_    {m}
+  , x_      {x}
+  , y_      {y}
+{
+    if (map_) {
+        map_->terrain_entries_.pin(x_, y_);
+    }
+}
+
+inline terrain_ref::terrain_ref(terrain_block_t& block, size_t const index) noexcept
+  : terrain_ref {block, index, nullptr, 0, 0}
+{
+}
+
+inline terrain_ref::terrain_ref(terrain_block_t& block, map& m, int const x, int const y) noexcept
+  : terrain_ref {block, terrain_block_t::index_of(x, y), &m, x, y}
+{
+}
+
+inline terrain_ref::terrain_ref(terrain_ref const& other) noexcept
+  : terrain_ref {*other.block_, other.index_, other.map_, other.x_, other.y_}
+{
+}
+
+inline terrain_ref::~terrain_ref() {
+    if (map_) {
+        map_->terrain_entries_.unpin(x_, y_);
+    }
+}
+
+inline terrain_ref& terrain_ref::operator=(terrain_entry const& rhs) noexcept {
+    block_->type[index_]    = rhs.type;
+    block_->variant[index_] = rhs.variant;
+    block_->flags[index_]   = rhs.flags;
+    block_->data[index_]    = rhs.data;
+
+    on_write_();
+    return *this;
+}
+
+inline terrain_ref::operator terrain_entry() const noexcept {
+    return terrain_entry {data, flags, type, variant};
+}
+
+inline void terrain_ref::on_write_() noexcept {
+    block_->update_masks(index_);
+
+    if (map_) {
+        map_->mark_dirty_(x_, y_);
+    }
+}
+
 template <typename T>
 using base_type_of_t = std::remove_const_t<
     std::remove_reference_t<
@@ -378,7 +1083,6 @@ item_pile* with_pile_at(definitions const& defs, Map&& m, bklib::ipoint2 const p
 
     if (auto const maybe_pile = m.items_at(p)) {
         f(*maybe_pile);
-        m.update_render_data(p);
         return maybe_pile;
     }
 
@@ -497,9 +1201,10 @@ find_neighboring_items(map const& m, bklib::ipoint2 const where, Predicate&& pre
     return find_neighboring_items(const_cast<map&>(m), where, std::forward<Predicate>(pred));
 }
 
+//! Terrain isn't addressable (see map::at), so the result only records which neighbors matched.
 template <typename Predicate>
-find_around_result_t<terrain_entry*>
-find_neighboring_terrain(map& m, bklib::ipoint2 const where, Predicate&& pred) {
+find_around_result_t<bool>
+find_neighboring_terrain(map const& m, bklib::ipoint2 const where, Predicate&& pred) {
     std::array<bklib::ipoint2, 9> const points {
         where + index_to_offset(0)
       , where + index_to_offset(1)
@@ -525,35 +1230,17 @@ find_neighboring_terrain(map& m, bklib::ipoint2 const where, Predicate&& pred) {
       , bklib::intersects(bounds, points[8]) && pred(m.at(points[8]))
     };
 
-    std::array<terrain_entry*, 9> const pointers {
-        matches[0] ? &m.at(points[0]) : nullptr
-      , matches[1] ? &m.at(points[1]) : nullptr
-      , matches[2] ? &m.at(points[2]) : nullptr
-      , matches[3] ? &m.at(points[3]) : nullptr
-      , matches[4] ? &m.at(points[4]) : nullptr
-      , matches[5] ? &m.at(points[5]) : nullptr
-      , matches[6] ? &m.at(points[6]) : nullptr
-      , matches[7] ? &m.at(points[7]) : nullptr
-      , matches[8] ? &m.at(points[8]) : nullptr
-    };
-
     size_t count = 0;
     size_t index = 0;
 
     for (auto i = 0u; i < 9u; ++i) {
-        if (pointers[i]) {
+        if (matches[i]) {
             ++count;
             index = i;
         }
     }
 
-    return {pointers, count, index};
-}
-
-template <typename Predicate>
-find_around_result_t<terrain_entry const*>
-find_neighboring_terrain(map const& m, bklib::ipoint2 const where, Predicate&& pred) {
-    return find_neighboring_terrain(const_cast<map&>(m), where, std::forward<Predicate>(pred));
+    return {matches, count, index};
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
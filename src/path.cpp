@@ -0,0 +1,604 @@
+#include "path.hpp"
+#include "map.hpp"
+#include "direction.hpp"
+
+#include "bklib/assert.hpp"
+
+#include <boost/predef.h>
+
+#if defined(BOOST_COMP_MSVC_AVAILABLE)
+#   include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+constexpr uint32_t cost_straight = bkrl::path_cost_straight;
+constexpr uint32_t cost_diagonal = bkrl::path_cost_diagonal;
+constexpr uint32_t cost_door     = cost_straight; //!< the extra cost of opening a closed door
+
+constexpr int sign(int const n) noexcept {
+    return (n > 0) - (n < 0);
+}
+
+//! The index of the lowest set bit of @p n.
+//! @pre n != 0
+int lowest_bit(uint64_t const n) noexcept {
+#if defined(BOOST_COMP_MSVC_AVAILABLE)
+    unsigned long i;
+    _BitScanForward64(&i, n);
+    return static_cast<int>(i);
+#else
+    return __builtin_ctzll(n);
+#endif
+}
+
+//! The index of the highest set bit of @p n.
+//! @pre n != 0
+int highest_bit(uint64_t const n) noexcept {
+#if defined(BOOST_COMP_MSVC_AVAILABLE)
+    unsigned long i;
+    _BitScanReverse64(&i, n);
+    return static_cast<int>(i);
+#else
+    return 63 - __builtin_clzll(n);
+#endif
+}
+
+//! Bits @p first to first + 63 of the @p words words at @p row; bits outside of the row are 0.
+uint64_t bits_at(uint64_t const* const row, int const words, int const first) noexcept {
+    auto const w   = bklib::floor_div(first, 64);
+    auto const off = first - w * 64;
+
+    auto const word = [&](int const i) noexcept {
+        return (i >= 0 && i < words) ? row[i] : uint64_t {0};
+    };
+
+    return off
+      ? (word(w) >> off) | (word(w + 1) << (64 - off))
+      : word(w);
+}
+
+//! The octile distance between (x0, y0) and @p p, in the fixed point costs above.
+uint32_t octile_distance(int const x0, int const y0, bklib::ipoint2 const p) noexcept {
+    auto const dx = static_cast<uint32_t>(std::abs(bklib::x(p) - x0));
+    auto const dy = static_cast<uint32_t>(std::abs(bklib::y(p) - y0));
+
+    return dx < dy
+      ? cost_diagonal * dx + cost_straight * (dy - dx)
+      : cost_diagonal * dy + cost_straight * (dx - dy);
+}
+
+//! The least power of 2 >= @p n.
+size_t ceil_pow2(size_t const n) noexcept {
+    size_t result = 1;
+    while (result < n) {
+        result *= 2;
+    }
+    return result;
+}
+
+//! The part of @p r within @p bounds; empty, at the top left of @p r, if there is none.
+bklib::irect clip(bklib::irect const r, bklib::irect const bounds) noexcept {
+    auto result = intersection(r, bounds);
+    result.right  = std::max(result.right,  result.left);
+    result.bottom = std::max(result.bottom, result.top);
+    return result;
+}
+
+} //namespace
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::passable_grid::is_copy_of(map const& m, bklib::irect const r) const noexcept
+{
+    return !bits_.empty() && bounds_ == clip(r, m.bounds()) && revision_ == m.terrain_revision();
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::passable_grid::copy(map const& m, bklib::irect const r, std::vector<uint64_t>& previous)
+{
+    if (is_copy_of(m, r)) {
+        return false;
+    }
+
+    previous.swap(bits_);
+    return copy(m, r);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::passable_grid::copy(map const& m, bklib::irect const r)
+{
+    if (is_copy_of(m, r)) {
+        return false;
+    }
+
+    constexpr auto const size = static_cast<int>(size_block);
+
+    bounds_   = clip(r, m.bounds());
+    revision_ = m.terrain_revision();
+
+    stride_ = static_cast<size_t>(bounds_.width() + 2 + 63) / 64;
+    bits_.assign(stride_ * static_cast<size_t>(bounds_.height() + 2), 0);
+
+    if (bounds_.width() <= 0 || bounds_.height() <= 0) {
+        return true;
+    }
+
+    // a row of a block at a time; 16 bits of the block's mask
+    for (auto by = block_of(bounds_.top); by <= block_of(bounds_.bottom - 1); ++by) {
+        for (auto bx = block_of(bounds_.left); bx <= block_of(bounds_.right - 1); ++bx) {
+            auto const x0 = bx * size;
+            auto const y0 = by * size;
+
+            auto const block = m.find_terrain_block(bklib::ipoint2 {x0, y0});
+
+            // the part of the row within bounds_
+            auto const lo = std::max(bounds_.left - x0, 0);
+            auto const hi = std::min(bounds_.right - x0, size);
+
+            auto const col = static_cast<size_t>(x0 + lo - bounds_.left + 1);
+            auto const w   = col / 64;
+            auto const off = col % 64;
+
+            for (auto r = std::max(bounds_.top - y0, 0); r < std::min(bounds_.bottom - y0, size); ++r) {
+                auto const i    = static_cast<size_t>(r) * size_block;
+                auto const bits = block
+                  ? ~block->impassable[i / 64] >> (i % 64)
+                  : ~uint64_t {0};
+
+                auto const row = static_cast<size_t>(y0 + r - bounds_.top + 1) * stride_;
+                auto const v   = (bits & ((uint64_t {1} << hi) - 1)) >> lo;
+
+                bits_[row + w] |= v << off;
+                if (off + static_cast<size_t>(hi - lo) > 64) {
+                    bits_[row + w + 1] |= v >> (64 - off);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::passable_grid::differences(
+    std::vector<uint64_t> const&       previous
+  , std::vector<bklib::ipoint2>&       out
+) const {
+    BK_PRECONDITION(previous.size() == bits_.size());
+
+    for (size_t i = 0; i < bits_.size(); ++i) {
+        for (auto diff = bits_[i] ^ previous[i]; diff; diff &= diff - 1) {
+            auto const col = (i % stride_) * 64 + static_cast<size_t>(lowest_bit(diff));
+            out.push_back(bklib::ipoint2 {
+                bounds_.left + static_cast<int>(col) - 1
+              , bounds_.top  + static_cast<int>(i / stride_) - 1
+            });
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::path_finder::path_finder() = default;
+
+//--------------------------------------------------------------------------------------------------
+bkrl::path_finder::~path_finder() = default;
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::path_finder::find_path(
+    map const&                         m
+  , bklib::ipoint2               const from
+  , bklib::ipoint2               const to
+  , std::vector<bklib::ipoint2>&       path
+  , path_options                 const options
+) {
+    BK_PRECONDITION(options.max_length >= 0);
+
+    path.clear();
+    expanded_ = 0;
+
+    goal_       = to;
+    open_doors_ = options.open_doors;
+    max_cost_   = options.max_length > 0
+      ? static_cast<uint32_t>(options.max_length) * cost_straight
+      : std::numeric_limits<uint32_t>::max();
+
+    if (!intersects(m.bounds(), from) || !intersects(m.bounds(), to)) {
+        return false;
+    }
+
+    if (from == to) {
+        return true;
+    }
+
+    // too far for any path within the limit; this also keeps the window small
+    if (octile_distance(x(from), y(from), to) > max_cost_) {
+        return false;
+    }
+
+    // no cell of a path within the limit is further than that from the start
+    auto const needed = [&] {
+        auto const n = options.max_length;
+        return n > 0
+          ? bklib::irect {std::min(x(from), x(to)) - n, std::min(y(from), y(to)) - n
+                        , std::max(x(from), x(to)) + n + 1, std::max(y(from), y(to)) + n + 1}
+          : m.bounds();
+    }();
+
+    prepare_(m, needed);
+
+    if (!is_passable_(x(to), y(to)) && !(open_doors_ && is_closed_door_(x(to), y(to)))) {
+        return false;
+    }
+
+    auto const jump  = options.jump_points && !options.open_doors;
+    auto const start = index_of_(x(from), y(from));
+    auto const goal  = index_of_(x(to), y(to));
+
+    open_f_ = octile_distance(x(from), y(from), goal_);
+    push_(x(from), y(from), start, 0);
+
+    while (open_count_ > 0) {
+        auto* bucket = &bucket_(open_f_);
+        while (bucket->empty()) {
+            bucket = &bucket_(++open_f_);
+        }
+
+        auto const top = bucket->back();
+        bucket->pop_back();
+        --open_count_;
+
+        auto& n = nodes_[top.index];
+        if (n.closed || n.g != top.g) {
+            continue; // stale; the node was reached more cheaply since
+        }
+
+        if (top.index == goal) {
+            build_path_(goal, path);
+            clear_open_();
+            return true;
+        }
+
+        n.closed = true;
+        ++expanded_;
+
+        if (jump) {
+            expand_jump_(top.index);
+        } else {
+            expand_a_star_(top.index);
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::path_finder::find_path(
+    map const&                         m
+  , creature const&                    c
+  , bklib::ipoint2               const to
+  , std::vector<bklib::ipoint2>&       path
+  , path_options                 const options
+) {
+    return find_path(m, c.position(), to, path, options);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::path_finder::prepare_(map const& m, bklib::irect const needed)
+{
+    map_ = &m;
+
+    // keep the last window while it is current and covers the query
+    auto const last = passable_.bounds();
+    auto const keep = passable_.is_copy_of(m, last)
+                   && intersection(last, needed) == intersection(m.bounds(), needed);
+
+    bounds_ = keep ? last : intersection(round_to_blocks(needed), m.bounds());
+
+    if (passable_.copy(m, bounds_)) {
+        copy_columns_();
+    }
+
+    // every node is stale once query_ moves on; only grow the buffers
+    auto const cells = static_cast<size_t>(bounds_.width()) * static_cast<size_t>(bounds_.height());
+    if (nodes_.size() < cells) {
+        nodes_.resize(cells, node_t {0, 0, 0, false});
+    }
+
+    // enough buckets for the f of open nodes to span twice the cost of the longest possible jump,
+    // or a step through a door
+    auto const span    = static_cast<size_t>(std::max(bounds_.width(), bounds_.height()));
+    auto const longest = std::max(cost_diagonal * span, size_t {cost_diagonal + cost_door});
+    auto const buckets = ceil_pow2(2 * longest + 1);
+    if (open_.size() < buckets) {
+        open_.resize(buckets);
+    }
+
+    if (++query_ == 0) {
+        std::fill(begin(nodes_), end(nodes_), node_t {0, 0, 0, false});
+        query_ = 1;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::path_finder::copy_columns_()
+{
+    auto const& bits   = passable_.bits();
+    auto const  stride = passable_.stride();
+
+    auto const rows = static_cast<size_t>(bounds_.height() + 2);
+    auto const cols = static_cast<size_t>(bounds_.width() + 2);
+
+    column_stride_ = (rows + 63) / 64;
+    passable_columns_.assign(column_stride_ * cols, 0);
+
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t w = 0; w < stride; ++w) {
+            for (auto word = bits[r * stride + w]; word; word &= word - 1) {
+                auto const c = w * 64 + static_cast<size_t>(lowest_bit(word));
+                passable_columns_[c * column_stride_ + r / 64] |= uint64_t {1} << (r % 64);
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::path_finder::is_closed_door_(int const x, int const y) const
+{
+    return intersects(bounds_, bklib::ipoint2 {x, y})
+        && is_door(map_->at(x, y), door::state::closed);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::path_finder::push_(int const x, int const y, uint32_t const parent, uint32_t const g)
+{
+    auto const i = index_of_(x, y);
+    auto& n = nodes_[i];
+
+    if (n.query != query_) {
+        n = node_t {query_, g, parent, false};
+    } else if (n.closed || n.g <= g) {
+        return;
+    } else {
+        n.g      = g;
+        n.parent = parent;
+    }
+
+    auto const f = g + octile_distance(x, y, goal_);
+    if (f > max_cost_) {
+        return;
+    }
+
+    bucket_(f).push_back(open_t {g, i});
+    ++open_count_;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::path_finder::clear_open_() noexcept
+{
+    for (auto f = open_f_; open_count_ > 0; ++f) {
+        auto& bucket = bucket_(f);
+        open_count_ -= bucket.size();
+        bucket.clear();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::path_finder::expand_a_star_(uint32_t const i)
+{
+    auto const p = point_at_(i);
+    auto const g = nodes_[i].g;
+
+    for (auto d = 0u; d < 8u; ++d) {
+        auto const nx = x(p) + x_off[d];
+        auto const ny = y(p) + y_off[d];
+
+        auto cost = (x_off[d] && y_off[d]) ? cost_diagonal : cost_straight;
+
+        if (!is_passable_(nx, ny)) {
+            if (!open_doors_ || !is_closed_door_(nx, ny)) {
+                continue;
+            }
+
+            cost += cost_door;
+        }
+
+        push_(nx, ny, i, g + cost);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::path_finder::expand_jump_(uint32_t const i)
+{
+    auto const p  = point_at_(i);
+    auto const x0 = x(p);
+    auto const y0 = y(p);
+    auto const g  = nodes_[i].g;
+
+    auto const try_jump = [&](int const dx, int const dy) {
+        auto jx = x0;
+        auto jy = y0;
+
+        if (!jump_(jx, jy, dx, dy)) {
+            return;
+        }
+
+        auto const steps = static_cast<uint32_t>(std::max(std::abs(jx - x0), std::abs(jy - y0)));
+        push_(jx, jy, i, g + steps * ((dx && dy) ? cost_diagonal : cost_straight));
+    };
+
+    auto const parent = nodes_[i].parent;
+
+    // the start; every direction
+    if (parent == i) {
+        for (auto d = 0u; d < 8u; ++d) {
+            try_jump(x_off[d], y_off[d]);
+        }
+
+        return;
+    }
+
+    // otherwise only the natural neighbours in the direction travelled, and any forced ones
+    auto const q  = point_at_(parent);
+    auto const dx = sign(x0 - x(q));
+    auto const dy = sign(y0 - y(q));
+
+    if (dx && dy) {
+        try_jump(dx, dy);
+        try_jump(dx, 0);
+        try_jump(0, dy);
+
+        if (!is_passable_(x0 - dx, y0)) {
+            try_jump(-dx, dy);
+        }
+
+        if (!is_passable_(x0, y0 - dy)) {
+            try_jump(dx, -dy);
+        }
+    } else if (dx) {
+        try_jump(dx, 0);
+
+        if (!is_passable_(x0, y0 + 1)) {
+            try_jump(dx, 1);
+        }
+
+        if (!is_passable_(x0, y0 - 1)) {
+            try_jump(dx, -1);
+        }
+    } else {
+        try_jump(0, dy);
+
+        if (!is_passable_(x0 + 1, y0)) {
+            try_jump(1, dy);
+        }
+
+        if (!is_passable_(x0 - 1, y0)) {
+            try_jump(-1, dy);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::path_finder::jump_(int& x, int& y, int const dx, int const dy) const noexcept
+{
+    if (!dx || !dy) {
+        return jump_straight_(x, y, dx, dy);
+    }
+
+    for (;;) {
+        x += dx;
+        y += dy;
+
+        if (!is_passable_(x, y)) {
+            return false;
+        }
+
+        if (bklib::ipoint2 {x, y} == goal_) {
+            return true;
+        }
+
+        if ((!is_passable_(x - dx, y) && is_passable_(x - dx, y + dy))
+         || (!is_passable_(x, y - dy) && is_passable_(x + dx, y - dy))
+        ) {
+            return true;
+        }
+
+        auto hx = x, hy = y;
+        auto vx = x, vy = y;
+        if (jump_straight_(hx, hy, dx, 0) || jump_straight_(vx, vy, 0, dy)) {
+            return true;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::path_finder::jump_straight_(int& x, int& y, int const dx, int const dy) const noexcept
+{
+    // scan along a row of passable_, or for vertical jumps a row of passable_columns_; in grid
+    // coordinates, which include the border
+    auto const vertical = (dx == 0);
+
+    auto const& grid   = vertical ? passable_columns_ : passable_.bits();
+    auto const  words  = static_cast<int>(vertical ? column_stride_ : passable_.stride());
+    auto const  d      = vertical ? dy : dx;
+
+    auto const gx = x - bounds_.left + 1;
+    auto const gy = y - bounds_.top  + 1;
+    auto const r  = vertical ? gx : gy;
+    auto const c  = vertical ? gy : gx;
+
+    auto const goal_x = bklib::x(goal_) - bounds_.left + 1;
+    auto const goal_y = bklib::y(goal_) - bounds_.top  + 1;
+    auto const goal_r = vertical ? goal_x : goal_y;
+    auto const goal_c = vertical ? goal_y : goal_x;
+
+    // the row scanned and those either side of it; always within the grid as the start is in bounds
+    auto const here  = grid.data() + static_cast<size_t>(r) * static_cast<size_t>(words);
+    auto const above = here - words;
+    auto const below = here + words;
+
+    auto const stop = [&](int const col) noexcept {
+        if (vertical) {
+            y = col + bounds_.top - 1;
+        } else {
+            x = col + bounds_.left - 1;
+        }
+
+        return true;
+    };
+
+    // a cell ends the scan if it is blocked, the goal, or has a neighbour beside it that is only
+    // reachable through it; the border guarantees a blocked cell is eventually found
+    if (d > 0) {
+        for (auto first = c + 1; ; first += 64) {
+            auto const blocked = ~bits_at(here, words, first);
+            auto const forced  = (~bits_at(above, words, first) & bits_at(above, words, first + 1))
+                               | (~bits_at(below, words, first) & bits_at(below, words, first + 1));
+            auto const goal    = (goal_r == r && goal_c >= first && goal_c < first + 64)
+              ? uint64_t {1} << (goal_c - first)
+              : uint64_t {0};
+
+            if (auto const found = blocked | forced | goal) {
+                auto const i = lowest_bit(found);
+                return !((blocked >> i) & 1) && stop(first + i);
+            }
+        }
+    } else {
+        for (auto last = c - 1; ; last -= 64) {
+            auto const first   = last - 63;
+            auto const blocked = ~bits_at(here, words, first);
+            auto const forced  = (~bits_at(above, words, first) & bits_at(above, words, first - 1))
+                               | (~bits_at(below, words, first) & bits_at(below, words, first - 1));
+            auto const goal    = (goal_r == r && goal_c >= first && goal_c <= last)
+              ? uint64_t {1} << (goal_c - first)
+              : uint64_t {0};
+
+            if (auto const found = blocked | forced | goal) {
+                auto const i = highest_bit(found);
+                return !((blocked >> i) & 1) && stop(first + i);
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::path_finder::build_path_(uint32_t const goal, std::vector<bklib::ipoint2>& path) const
+{
+    // walk back from the goal; consecutive nodes are joined by a straight or diagonal line
+    for (auto i = goal; nodes_[i].parent != i; i = nodes_[i].parent) {
+        auto const p = point_at_(i);
+        auto const q = point_at_(nodes_[i].parent);
+
+        auto const dx = sign(x(p) - x(q));
+        auto const dy = sign(y(p) - y(q));
+
+        for (auto cx = x(p), cy = y(p); cx != x(q) || cy != y(q); cx -= dx, cy -= dy) {
+            path.push_back(bklib::ipoint2 {cx, cy});
+        }
+    }
+
+    std::reverse(begin(path), end(path));
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "bklib/math.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace bkrl {
+
+class map;
+class creature;
+
+// fixed point step costs; a diagonal step is about sqrt(2) straight steps
+constexpr uint32_t path_cost_straight = 5;
+constexpr uint32_t path_cost_diagonal = 7;
+
+//--------------------------------------------------------------------------------------------------
+//! A bit per cell of a region of a map's bounds, and of a border of impassable cells around it, of
+//! whether the cell is passable (see map::is_passable); copied from the map's masks a row of a block
+//! at a time. In grid coordinates, which include the border, cell (x, y) is
+//! (x - left + 1, y - top + 1), and each row is stride() words.
+//! Only the blocks overlapping the region are read, so a small region around where a search happens
+//! keeps the cost (and, for paged terrain, the chunks paged in) independent of the size of the map.
+//--------------------------------------------------------------------------------------------------
+class passable_grid {
+public:
+    //! Copy the passability of the cells of @p m within @p r, clipped to the bounds of @p m, unless
+    //! the same region was already copied since the terrain was last written to (see
+    //! map::terrain_revision).
+    //! @return whether it was copied.
+    bool copy(map const& m, bklib::irect r);
+
+    //! As above, but swap the bits of the last copy into @p previous before copying, rather than
+    //! discarding them; for differences. Nothing is swapped if nothing is copied.
+    bool copy(map const& m, bklib::irect r, std::vector<uint64_t>& previous);
+
+    //! Whether the bits are up to date for the cells of @p m within @p r, clipped as for copy.
+    bool is_copy_of(map const& m, bklib::irect r) const noexcept;
+
+    //! Append to @p out the cells whose passability differs from that in @p previous, the bits() of
+    //! an earlier copy of the same region.
+    void differences(std::vector<uint64_t> const& previous, std::vector<bklib::ipoint2>& out) const;
+
+    bklib::irect bounds() const noexcept {
+        return bounds_;
+    }
+
+    size_t stride() const noexcept {
+        return stride_;
+    }
+
+    //! stride() words for each of the bounds().height() + 2 rows.
+    std::vector<uint64_t> const& bits() const noexcept {
+        return bits_;
+    }
+
+    //! Whether the cell at (@p x, @p y) is passable; false outside of bounds().
+    //! @pre (@p x, @p y) is at most one cell outside of bounds().
+    bool is_passable(int const x, int const y) const noexcept {
+        auto const cx = static_cast<size_t>(x - bounds_.left + 1);
+        auto const cy = static_cast<size_t>(y - bounds_.top + 1);
+        return !!(bits_[cy * stride_ + cx / 64] & (uint64_t {1} << (cx % 64)));
+    }
+private:
+    std::vector<uint64_t> bits_;
+    size_t                stride_ = 0;
+    bklib::irect          bounds_;
+    uint64_t              revision_ = 0; //!< the terrain revision bits_ was copied from
+};
+
+//--------------------------------------------------------------------------------------------------
+//! Per query options for path_finder.
+//--------------------------------------------------------------------------------------------------
+struct path_options {
+    //! Closed doors can be walked through, at the cost of an extra step to open them. Otherwise
+    //! they are as good as walls. Steps no longer all cost the same, so this rules out jump point
+    //! search.
+    bool open_doors = false;
+
+    //! Use jump point search where it applies (see open_doors); otherwise use plain A*.
+    bool jump_points = true;
+
+    //! Give up on paths longer than about this many steps; 0 for no limit. Bounding the length keeps
+    //! queries for unreachable goals from searching everything reachable.
+    int max_length = 0;
+};
+
+//--------------------------------------------------------------------------------------------------
+//! Finds shortest paths over the terrain of a map, between cells within map::bounds(). Only the
+//! terrain is considered; creatures are not obstacles.
+//!
+//! A step goes to any of the 8 neighbouring cells that is passable, including diagonally past
+//! corners, as creatures move. Diagonal steps cost 1.4 straight steps. This keeps paths from
+//! zig-zagging, and it is what jump point search needs.
+//!
+//! The search state lives in buffers that are kept between queries. They are sized for a window of
+//! the map searched, about 16 bytes a cell and a few hundred a cell of its longer side, and only
+//! grow. Queries allocate nothing once the buffers are large enough. The window is the whole blocks
+//! around the start and the goal grown by path_options::max_length, or the bounds of the map if the
+//! length isn't limited; a path can't leave it. Passability is read from a passable_grid of the
+//! window, which is only copied again once the terrain has been written to, or for a query outside
+//! of the last window.
+//! A path_finder answers one query at a time; to search from several threads at once, give each
+//! thread a path_finder of its own.
+//--------------------------------------------------------------------------------------------------
+class path_finder {
+public:
+    path_finder();
+    ~path_finder();
+
+    path_finder(path_finder const&) = delete;
+    path_finder& operator=(path_finder const&) = delete;
+
+    //----------------------------------------------------------------------------------------------
+    //! Find a shortest path from @p from to @p to over the passable terrain of @p m (see
+    //! map::is_passable). @p from itself needn't be passable.
+    //! @param path Set to the cells stepped to, from the one after @p from up to and including
+    //!        @p to; empty if there is no path or @p from == @p to.
+    //! @return whether a path was found.
+    //----------------------------------------------------------------------------------------------
+    bool find_path(map const& m, bklib::ipoint2 from, bklib::ipoint2 to
+      , std::vector<bklib::ipoint2>& path, path_options options = path_options {});
+
+    //----------------------------------------------------------------------------------------------
+    //! As above, from the position of @p c and over the terrain it can enter. Passability is read
+    //! from the map's masks; creature::can_enter_terrain is bkrl::is_passable for every creature
+    //! at the moment.
+    //----------------------------------------------------------------------------------------------
+    bool find_path(map const& m, creature const& c, bklib::ipoint2 to
+      , std::vector<bklib::ipoint2>& path, path_options options = path_options {});
+
+    //! The number of cells expanded by the last query.
+    size_t expanded() const noexcept {
+        return expanded_;
+    }
+private:
+    struct node_t {
+        uint32_t query;  //!< the query the rest of the node belongs to
+        uint32_t g;      //!< the cost from the start
+        uint32_t parent; //!< the index of the node this one was reached from
+        bool     closed;
+    };
+
+    struct open_t {
+        uint32_t g;
+        uint32_t index;
+    };
+
+    //! Make the window (bounds_) cover @p needed, copying passability and growing the buffers as
+    //! needed.
+    void prepare_(map const& m, bklib::irect needed);
+
+    //! Transpose passable_ into passable_columns_.
+    void copy_columns_();
+
+    bool is_passable_(int const x, int const y) const noexcept {
+        return passable_.is_passable(x, y);
+    }
+
+    //! Whether the cell at (@p x, @p y) is within bounds_ and a closed door.
+    bool is_closed_door_(int x, int y) const;
+
+    uint32_t index_of_(int const x, int const y) const noexcept {
+        return static_cast<uint32_t>((y - bounds_.top) * bounds_.width() + (x - bounds_.left));
+    }
+
+    bklib::ipoint2 point_at_(uint32_t const i) const noexcept {
+        auto const w = static_cast<uint32_t>(bounds_.width());
+        return {bounds_.left + static_cast<int>(i % w), bounds_.top + static_cast<int>(i / w)};
+    }
+
+    //! Empty open_ of whatever is left from a search.
+    void clear_open_() noexcept;
+
+    std::vector<open_t>& bucket_(uint32_t const f) noexcept {
+        return open_[f & (open_.size() - 1)];
+    }
+
+    //! Open (or reopen) the node for the cell (@p x, @p y), reached from @p parent at a cost of
+    //! @p g, unless it has already been reached as cheaply.
+    void push_(int x, int y, uint32_t parent, uint32_t g);
+
+    //! Expand the node at @p i as plain A*.
+    void expand_a_star_(uint32_t i);
+
+    //! Expand the node at @p i as jump point search.
+    void expand_jump_(uint32_t i);
+
+    //! Step from (@p x, @p y) in the direction (@p dx, @p dy) until reaching the goal, a cell with a
+    //! forced neighbour or (for diagonals) one a straight jump from which gets somewhere.
+    //! @return whether a jump point was found; if so, it is written to @p x and @p y.
+    bool jump_(int& x, int& y, int dx, int dy) const noexcept;
+
+    //! jump_ for straight lines; reads 64 cells of a row (or column) at a time.
+    bool jump_straight_(int& x, int& y, int dx, int dy) const noexcept;
+
+    void build_path_(uint32_t goal, std::vector<bklib::ipoint2>& path) const;
+
+    map const*   map_ = nullptr;
+    bklib::irect bounds_;       //!< the window searched; passable_.bounds()
+
+    std::vector<node_t> nodes_; //!< one per cell of bounds_
+
+    //! The open nodes in buckets by f, modulo the (power of 2) number of buckets. f never decreases
+    //! during a search, and the f of open nodes is never more than twice the longest step (or jump)
+    //! above the lowest, so with enough buckets this is a priority queue with O(1) push and pop.
+    std::vector<std::vector<open_t>> open_;
+    size_t   open_count_ = 0;
+    uint32_t open_f_     = 0; //!< no open node has a lower f
+
+    passable_grid passable_;
+
+    //! passable_, transposed; column_stride_ words a column.
+    std::vector<uint64_t> passable_columns_;
+    size_t                column_stride_ = 0;
+
+    uint32_t       query_ = 0;
+    bklib::ipoint2 goal_;
+    uint32_t       max_cost_ = 0;
+    bool           open_doors_ = false;
+    size_t         expanded_ = 0;
+};
+
+} //namespace bkrl
@@ -0,0 +1,304 @@
+#include "profiler.hpp"
+
+#include "renderer.hpp"
+#include "text.hpp"
+
+#include "bklib/assert.hpp"
+#include "bklib/scope_guard.hpp"
+#include "external/format.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <numeric>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// profiler
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+constexpr size_t bkrl::profiler::history;
+constexpr bool   bkrl::profiler::enabled;
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profiler& bkrl::profiler::get() noexcept
+{
+    static thread_local profiler instance;
+    return instance;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::profiler::add(profile_id const id, sample_t const n) noexcept
+{
+    series_(id).pending += n;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::profiler::commit(profile_id const id) noexcept
+{
+    auto& s = series_(id);
+
+    s.samples[s.next] = s.pending;
+    s.next    = (s.next + 1) % history;
+    s.count   = std::min(s.count + 1, history);
+    s.pending = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t bkrl::profiler::size(profile_id const id) const noexcept
+{
+    return series_(id).count;
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profiler::sample_t bkrl::profiler::sample(profile_id const id, size_t const i) const noexcept
+{
+    auto const& s = series_(id);
+    return (i < s.count)
+      ? s.samples[(s.next + history - 1 - i) % history]
+      : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profiler::sample_t bkrl::profiler::max(profile_id const id) const noexcept
+{
+    auto const& s = series_(id);
+    auto const first = begin(s.samples);
+    return *std::max_element(first, first + s.count);
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profiler::sample_t bkrl::profiler::mean(profile_id const id) const noexcept
+{
+    auto const& s = series_(id);
+    if (s.count == 0) {
+        return 0;
+    }
+
+    auto const first = begin(s.samples);
+    return std::accumulate(first, first + s.count, sample_t {0}) / s.count;
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profiler::series_t const& bkrl::profiler::series_(profile_id const id) const noexcept
+{
+    BK_PRECONDITION(id < profile_id::enum_size);
+    return data_[static_cast<size_t>(id)];
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profiler::series_t& bkrl::profiler::series_(profile_id const id) noexcept
+{
+    return const_cast<series_t&>(static_cast<profiler const*>(this)->series_(id));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// profile_zone
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profile_zone::profile_zone(profile_id const id) noexcept
+  : profiler_ {profiler::get()}
+  , parent_ {profiler_.current_}
+  , id_ {id}
+{
+    profiler_.current_ = this;
+    start_ = clock_t::now();
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profile_zone::~profile_zone()
+{
+    auto const elapsed = clock_t::now() - start_;
+
+    if (parent_) {
+        parent_->nested_ += elapsed;
+    }
+
+    profiler_.current_ = parent_;
+
+    auto const self = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed - nested_);
+    profiler_.add(id_, static_cast<profiler::sample_t>(self.count()));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// profiler_overlay
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace bkrl { class profiler_overlay_impl; }
+
+//--------------------------------------------------------------------------------------------------
+class bkrl::profiler_overlay_impl final : public profiler_overlay {
+public:
+    virtual ~profiler_overlay_impl();
+
+    explicit profiler_overlay_impl(text_renderer& text_render)
+      : text_renderer_ {text_render}
+      , text_ {text_render, ""}
+    {
+    }
+
+    void set_bounds(bklib::irect const bounds) final override {
+        bounds_ = bounds;
+    }
+
+    void draw(renderer& render, profiler const& prof) final override;
+private:
+    //! Draw the samples for @p ids stacked, newest on the right, in @p r scaled so that @p max
+    //! fills it.
+    void draw_histogram_(renderer& render, profiler const& prof, bklib::irect r
+      , std::initializer_list<profile_id> ids, profiler::sample_t max) const;
+
+    text_renderer& text_renderer_;
+    text_layout    text_;
+    bklib::irect   bounds_ = bklib::irect {5, 190, 375, 480};
+};
+
+namespace {
+
+constexpr int bar_w = 3;
+constexpr int margin = 5;
+
+constexpr bkrl::profile_id turn_parts[] {
+    bkrl::profile_id::turn
+  , bkrl::profile_id::creatures
+  , bkrl::profile_id::items
+  , bkrl::profile_id::render_data
+};
+
+bkrl::color4 bar_color(bkrl::profile_id const id) noexcept {
+    using bkrl::make_color;
+    using bkrl::profile_id;
+
+    switch (id) {
+    case profile_id::frame       : return make_color(220, 220, 220);
+    case profile_id::turn        : return make_color(160, 160, 160);
+    case profile_id::creatures   : return make_color(220, 80,  80);
+    case profile_id::items       : return make_color(80,  200, 80);
+    case profile_id::render_data : return make_color(80,  120, 240);
+    case profile_id::text_layout : BK_FALLTHROUGH
+    case profile_id::draw_calls  : BK_FALLTHROUGH
+    case profile_id::enum_size   : BK_FALLTHROUGH
+    default                      : break;
+    }
+
+    return make_color(255, 0, 255);
+}
+
+//! The total of the @p i th newest samples of each of the parts of a turn.
+bkrl::profiler::sample_t turn_total(bkrl::profiler const& prof, size_t const i) noexcept {
+    bkrl::profiler::sample_t result = 0;
+    for (auto const id : turn_parts) {
+        result += prof.sample(id, i);
+    }
+
+    return result;
+}
+
+constexpr double to_us(bkrl::profiler::sample_t const ns) noexcept {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+} //namespace
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profiler_overlay::~profiler_overlay() {
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::profiler_overlay_impl::~profiler_overlay_impl() {
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::profiler_overlay_impl::draw(renderer& render, profiler const& prof)
+{
+    auto const old_clip  = render.get_clip_region();
+    auto const old_scale = render.get_scale();
+    auto const old_trans = render.get_translation();
+
+    BK_SCOPE_EXIT {
+        render.set_clip_region(old_clip);
+        render.set_scale(x(old_scale), y(old_scale));
+        render.set_translation(x(old_trans), y(old_trans));
+    };
+
+    render.set_scale(1.0);
+    render.set_translation(0.0, 0.0);
+    render.set_clip_region(make_renderer_rect(bounds_));
+
+    render.draw_filled_rect(make_renderer_rect(bounds_), make_color(40, 40, 40, 220));
+
+    if (!profiler::enabled) {
+        text_.set_text(text_renderer_, "profiling disabled");
+        text_.draw(render, bounds_.left + margin, bounds_.top + margin);
+        return;
+    }
+
+    using id = profile_id;
+
+    fmt::MemoryWriter out;
+    out.write("frame     {:>6.0f} us\n", to_us(prof.sample(id::frame, 0)));
+    out.write("frame max {:>6.0f} us\n", to_us(prof.max(id::frame)));
+    out.write("draw calls {:>5}\n",     prof.sample(id::draw_calls, 0));
+    out.write("text      {:>6.0f} us\n", to_us(prof.sample(id::text_layout, 0)));
+    out.write("turn      {:>6.0f} us\n", to_us(turn_total(prof, 0)));
+    out.write(" creatures{:>6.0f} us\n", to_us(prof.sample(id::creatures, 0)));
+    out.write(" items    {:>6.0f} us\n", to_us(prof.sample(id::items, 0)));
+    out.write(" render   {:>6.0f} us",   to_us(prof.sample(id::render_data, 0)));
+
+    text_.set_text(text_renderer_, bklib::utf8_string_view {out.data(), out.size()});
+    text_.draw(render, bounds_.left + margin, bounds_.top + margin);
+
+    // the two histograms share what is left below the text
+    auto const top    = bounds_.top + margin + text_.extent().height() + margin;
+    auto const height = std::max(0, (bounds_.bottom - top - 2 * margin) / 2);
+    auto const left   = bounds_.left + margin;
+    auto const right  = bounds_.right - margin;
+
+    draw_histogram_(render, prof, bklib::irect {left, top, right, top + height}
+      , {id::frame}, prof.max(id::frame));
+
+    profiler::sample_t turn_max = 0;
+    for (size_t i = 0; i < prof.size(id::turn); ++i) {
+        turn_max = std::max(turn_max, turn_total(prof, i));
+    }
+
+    auto const turn_top = top + height + margin;
+    draw_histogram_(render, prof, bklib::irect {left, turn_top, right, turn_top + height}
+      , {id::turn, id::creatures, id::items, id::render_data}, turn_max);
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::profiler_overlay_impl::draw_histogram_(
+    renderer& render
+  , profiler const& prof
+  , bklib::irect const r
+  , std::initializer_list<profile_id> const ids
+  , profiler::sample_t const max
+) const {
+    if (max == 0 || r.height() <= 0) {
+        return;
+    }
+
+    auto const h = static_cast<double>(r.height());
+    auto const n = static_cast<size_t>(std::max(0, r.width() / bar_w));
+
+    for (size_t i = 0; i < n && i < prof.size(*ids.begin()); ++i) {
+        auto const bar_x = r.right - static_cast<int>(i + 1) * bar_w;
+        auto bar_y = static_cast<double>(r.bottom);
+
+        for (auto const id : ids) {
+            auto const bar_h = h * static_cast<double>(prof.sample(id, i)) / static_cast<double>(max);
+            bar_y -= bar_h;
+
+            auto const y0 = bklib::floor_to<int>(bar_y);
+            auto const y1 = bklib::floor_to<int>(bar_y + bar_h);
+            if (y1 > y0) {
+                render.draw_filled_rect(renderer::rect_t {bar_x, y0, bar_w, y1 - y0}, bar_color(id));
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+std::unique_ptr<bkrl::profiler_overlay> bkrl::make_profiler_overlay(text_renderer& text_render) {
+    return std::make_unique<profiler_overlay_impl>(text_render);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "bklib/math.hpp"
+#include "bklib/scope_guard.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace bkrl {
+
+class renderer;
+class text_renderer;
+class profile_zone;
+
+//--------------------------------------------------------------------------------------------------
+//! What a profiler sample measures. Other than draw_calls, each is a time in nanoseconds spent in
+//! zones for the id, excluding any zones nested in them.
+//--------------------------------------------------------------------------------------------------
+enum class profile_id : uint8_t {
+    frame        //!< recording a frame
+  , turn         //!< advancing the map a turn; the parts below are excluded
+  , creatures
+  , items
+  , render_data  //!< updating the map's render data
+  , text_layout
+  , draw_calls   //!< the number of calls recorded for a frame
+
+  , enum_size
+};
+
+//--------------------------------------------------------------------------------------------------
+//! A rolling history of samples for each profile_id. Values are accumulated by add (usually by way
+//! of a profile_zone) and become a sample when committed.
+//!
+//! Each thread has its own profiler; see get().
+//--------------------------------------------------------------------------------------------------
+class profiler {
+    friend class profile_zone;
+public:
+    using sample_t = uint64_t;
+
+    static constexpr size_t history = 120;
+
+#if defined(BK_NO_PROFILER)
+    static constexpr bool enabled = false;
+#else
+    static constexpr bool enabled = true;
+#endif
+
+    //! The profiler for the calling thread.
+    static profiler& get() noexcept;
+
+    //! Add @p n to the pending value for @p id.
+    void add(profile_id id, sample_t n) noexcept;
+
+    //! Make the pending value for @p id its newest sample and reset it to zero.
+    void commit(profile_id id) noexcept;
+
+    //! The number of samples for @p id; at most history.
+    size_t size(profile_id id) const noexcept;
+
+    //! The @p i th newest sample for @p id, or zero if there isn't one.
+    sample_t sample(profile_id id, size_t i) const noexcept;
+
+    sample_t max(profile_id id) const noexcept;
+    sample_t mean(profile_id id) const noexcept;
+private:
+    struct series_t {
+        std::array<sample_t, history> samples {};
+        size_t   next    = 0;
+        size_t   count   = 0;
+        sample_t pending = 0;
+    };
+
+    series_t const& series_(profile_id id) const noexcept;
+    series_t&       series_(profile_id id) noexcept;
+
+    std::array<series_t, static_cast<size_t>(profile_id::enum_size)> data_ {};
+    profile_zone* current_ = nullptr; //!< the innermost open zone
+};
+
+//--------------------------------------------------------------------------------------------------
+//! Add the time between construction and destruction, less that of any zones nested in it, to the
+//! calling thread's profiler. Use BK_PROFILE_ZONE rather than this directly.
+//--------------------------------------------------------------------------------------------------
+class profile_zone {
+public:
+    explicit profile_zone(profile_id id) noexcept;
+    ~profile_zone();
+
+    profile_zone(profile_zone const&) = delete;
+    profile_zone& operator=(profile_zone const&) = delete;
+private:
+    using clock_t = std::chrono::high_resolution_clock;
+
+    profiler&           profiler_;
+    profile_zone*       parent_;
+    clock_t::time_point start_;
+    clock_t::duration   nested_ {};
+    profile_id          id_;
+};
+
+#if defined(BK_NO_PROFILER)
+#   define BK_PROFILE_ZONE(id)
+#   define BK_PROFILE_COUNT(id, n)
+#   define BK_PROFILE_COMMIT(id)
+#else
+#   define BK_PROFILE_ZONE(id) \
+        ::bkrl::profile_zone const BK_ANONYMOUS_VARIABLE(profile_zone_) {::bkrl::profile_id::id}
+#   define BK_PROFILE_COUNT(id, n) \
+        ::bkrl::profiler::get().add(::bkrl::profile_id::id, static_cast<::bkrl::profiler::sample_t>(n))
+#   define BK_PROFILE_COMMIT(id) \
+        ::bkrl::profiler::get().commit(::bkrl::profile_id::id)
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//! Histograms of frame and turn time, and the most recent draw call count and text layout time.
+//--------------------------------------------------------------------------------------------------
+class profiler_overlay {
+public:
+    virtual ~profiler_overlay();
+
+    virtual void set_bounds(bklib::irect bounds) = 0;
+    virtual void draw(renderer& render, profiler const& prof) = 0;
+};
+
+std::unique_ptr<profiler_overlay> make_profiler_overlay(text_renderer& text_render);
+
+} //namespace bkrl
@@ -0,0 +1,488 @@
+#include "recording_renderer.hpp"
+
+#include "bklib/assert.hpp"
+#include "bklib/math.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace bkrl { class recording_renderer_impl; }
+
+namespace {
+
+using rect_t    = bkrl::renderer::rect_t;
+using command_t = bkrl::recording_renderer::command_t;
+using bkrl::color4;
+
+//! The same colour the SDL renderer clears to.
+constexpr color4 clear_color {{255, 0, 0, 255}};
+
+constexpr color4 white {{255, 255, 255, 255}};
+
+//! The default tile texture is 16 x 16 tiles, as is the one the SDL renderer loads.
+constexpr int default_tile_cols = 16;
+
+rect_t intersect(rect_t const a, rect_t const b) noexcept {
+    auto const l = std::max(a.x, b.x);
+    auto const t = std::max(a.y, b.y);
+    auto const r = std::min(a.x + a.w, b.x + b.w);
+    auto const u = std::min(a.y + a.h, b.y + b.h);
+
+    return {l, t, std::max(r - l, 0), std::max(u - t, 0)};
+}
+
+void blend(color4& dst, color4 const src) noexcept {
+    auto const a = uint32_t {src[3]};
+    for (auto i = 0u; i < 3u; ++i) {
+        dst[i] = static_cast<uint8_t>((src[i] * a + dst[i] * (255u - a) + 127u) / 255u);
+    }
+}
+
+color4 modulate(color4 const texel, color4 const tint) noexcept {
+    return {{
+        static_cast<uint8_t>(texel[0] * tint[0] / 255)
+      , static_cast<uint8_t>(texel[1] * tint[1] / 255)
+      , static_cast<uint8_t>(texel[2] * tint[2] / 255)
+      , texel[3]
+    }};
+}
+
+uint16_t get_uint16_at(void const* const p, size_t const i, ptrdiff_t const offset
+  , size_t const stride
+) noexcept {
+    uint16_t result;
+    std::memcpy(&result, static_cast<char const*>(p) + stride * i + offset, sizeof(result));
+    return result;
+}
+
+} //namespace
+
+//--------------------------------------------------------------------------------------------------
+//! Recording renderer implementation.
+//--------------------------------------------------------------------------------------------------
+class bkrl::recording_renderer_impl final : public recording_renderer {
+public:
+    virtual ~recording_renderer_impl();
+
+    recording_renderer_impl(int const width, int const height, int const tile_w, int const tile_h)
+      : tilemap_ {tile_w, tile_h, tile_w * default_tile_cols, tile_h * default_tile_cols}
+      , framebuffer_ (static_cast<size_t>(width) * static_cast<size_t>(height), clear_color)
+      , width_ {width}
+      , height_ {height}
+    {
+        BK_PRECONDITION(width > 0 && height > 0 && tile_w > 0 && tile_h > 0);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void clear_clip_region() override final {
+        clip_ = rect_t {};
+        push_(command_t::type_t::clip, white, rect_t {0, 0, width_, height_});
+    }
+
+    //! As with SDL, an empty region turns clipping off.
+    void set_clip_region(rect_t const r) override final {
+        if (r.w <= 0 || r.h <= 0) {
+            clear_clip_region();
+            return;
+        }
+
+        clip_ = r;
+        push_(command_t::type_t::clip, white, r);
+    }
+
+    rect_t get_clip_region() override final {
+        return clip_;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void set_scale(double const sx, double const sy) override final {
+        sx_ = sx;
+        sy_ = sy;
+    }
+
+    void set_scale(double const scale) override final {
+        set_scale(scale, scale);
+    }
+
+    void set_translation(double const dx, double const dy) override final {
+        tx_ = dx;
+        ty_ = dy;
+    }
+
+    bklib::point_t<2, double> get_scale() const override final {
+        return {sx_, sy_};
+    }
+
+    bklib::point_t<2, double> get_translation() const override final {
+        return {tx_, ty_};
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void clear() override final {
+        commands_.clear();
+        draw_calls_ = 0;
+        draw_color_ = clear_color;
+        clip_       = rect_t {};
+    }
+
+    void present() override final {
+    }
+
+    void set_active_texture(texture) override final {
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! As with the SDL renderer, filled rects are neither scaled nor translated.
+    //----------------------------------------------------------------------------------------------
+    void draw_filled_rect(rect_t const r) override final {
+        ++draw_calls_;
+        push_(command_t::type_t::fill, draw_color_, r);
+    }
+
+    void draw_filled_rect(rect_t const r, color4 const c) override final {
+        draw_color_ = c;
+        draw_filled_rect(r);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void draw_cell(int const cell_x, int const cell_y, int const tile_index) override final {
+        draw_cell(cell_x, cell_y, tile_index, white);
+    }
+
+    void draw_cell(int const cell_x, int const cell_y, int const tile_index
+      , color4 const color
+    ) override final {
+        ++draw_calls_;
+
+        auto const r = tilemap_.get_bounds(tile_index);
+        push_sprite_(rect_t {r.left, r.top, r.width(), r.height()}
+          , to_screen_(cell_x * tilemap_.tile_w(), cell_y * tilemap_.tile_h(), r.width(), r.height())
+          , color);
+    }
+
+    void draw_rect(rect_t const src, rect_t const dst) override final {
+        ++draw_calls_;
+        push_sprite_(src, to_screen_(dst.x, dst.y, dst.w, dst.h), white);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void draw_cells(
+        int const xoff, int const yoff
+      , size_t const w, size_t const h
+      , void const* const data
+      , ptrdiff_t const tex_offset, size_t
+      , size_t const stride
+    ) override final {
+        ++draw_calls_;
+
+        auto const tw = tilemap_.tile_w();
+        auto const th = tilemap_.tile_h();
+
+        for (auto yi = 0u; yi < h; ++yi) {
+            for (auto xi = 0u; xi < w; ++xi) {
+                auto const i = get_uint16_at(data, yi * w + xi, tex_offset, stride);
+                if (i == 0) {
+                    continue;
+                }
+
+                auto const r = tilemap_.get_bounds(i);
+                push_sprite_(rect_t {r.left, r.top, tw, th}
+                  , to_screen_((xoff + static_cast<int>(xi)) * tw, (yoff + static_cast<int>(yi)) * th, tw, th)
+                  , white);
+            }
+        }
+    }
+
+    //----------------------------------------------------------------------------------------------
+    //! The cells are copied only when @p version changes; a single command draws the block.
+    //----------------------------------------------------------------------------------------------
+    void draw_cells_cached(
+        uint64_t const key, uint64_t const version
+      , int const xoff, int const yoff
+      , size_t const w, size_t const h
+      , void const* const data
+      , ptrdiff_t const tex_offset, size_t
+      , size_t const stride
+    ) override final {
+        ++draw_calls_;
+
+        auto const i = cached_index_(cached_cells_, key);
+        auto& entry = cached_[i];
+
+        if (entry.version != version || entry.w != w || entry.h != h) {
+            entry.version = version;
+            entry.w = w;
+            entry.h = h;
+            entry.cells.resize(w * h);
+            for (auto j = 0u; j < w * h; ++j) {
+                entry.cells[j] = get_uint16_at(data, j, tex_offset, stride);
+            }
+        }
+
+        auto const tw = tilemap_.tile_w();
+        auto const th = tilemap_.tile_h();
+
+        commands_.push_back(command_t {command_t::type_t::cells, white, i, 0, 0, 0, 0
+          , to_screen_(xoff * tw, yoff * th, static_cast<int>(w) * tw, static_cast<int>(h) * th)});
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void draw_texels_cached(
+        uint64_t const key, uint64_t const version
+      , rect_t const dst
+      , size_t const w, size_t const h
+      , color4 const* const data
+    ) override final {
+        ++draw_calls_;
+
+        auto const i = cached_index_(cached_texels_, key);
+        auto& entry = cached_[i];
+
+        if (entry.version != version || entry.w != w || entry.h != h) {
+            entry.version = version;
+            entry.w = w;
+            entry.h = h;
+            entry.texels.assign(data, data + w * h);
+        }
+
+        commands_.push_back(command_t {command_t::type_t::texels, white, i, 0, 0, 0, 0
+          , to_screen_(dst.x, dst.y, dst.w, dst.h)});
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void draw_rects(
+        int const xoff, int const yoff
+      , size_t const count
+      , void const* const data
+      , ptrdiff_t const src_pos_offset, size_t
+      , ptrdiff_t const dst_pos_offset, size_t
+      , ptrdiff_t const color_offset,   size_t
+      , size_t const stride
+    ) override final {
+        ++draw_calls_;
+
+        auto p = static_cast<char const*>(data);
+
+        for (auto i = 0u; i < count; ++i, p += stride) {
+            int16_t src[4];
+            int16_t dst[2];
+            color4  col;
+
+            std::memcpy(src, p + src_pos_offset, sizeof(src));
+            std::memcpy(dst, p + dst_pos_offset, sizeof(dst));
+            std::memcpy(col.data(), p + color_offset, 3);
+            col[3] = 255;
+
+            push_sprite_(rect_t {src[0], src[1], src[2], src[3]}
+              , to_screen_(xoff + dst[0], yoff + dst[1], src[2], src[3]), col);
+        }
+    }
+
+    //----------------------------------------------------------------------------------------------
+    std::vector<command_t> const& commands() const noexcept override final {
+        return commands_;
+    }
+
+    size_t draw_calls() const noexcept override final {
+        return draw_calls_;
+    }
+
+    void set_tile_texture(int const w, int const h, color4 const* const data) override final {
+        BK_PRECONDITION(w > 0 && h > 0 && data);
+
+        tilemap_ = tilemap {tilemap_.tile_w(), tilemap_.tile_h(), w, h};
+        tile_texture_.assign(data, data + w * h);
+    }
+
+    void rasterize() override final;
+
+    color4 const* framebuffer() const noexcept override final {
+        return framebuffer_.data();
+    }
+
+    int width() const noexcept override final {
+        return width_;
+    }
+
+    int height() const noexcept override final {
+        return height_;
+    }
+private:
+    //! The cells or texels drawn by draw_cells_cached or draw_texels_cached for a key.
+    struct cached_t {
+        uint64_t              version = ~uint64_t {0}; //!< not drawn into yet
+        size_t                w       = 0;
+        size_t                h       = 0;
+        std::vector<uint16_t> cells;
+        std::vector<color4>   texels;
+    };
+
+    using cache_index_t = std::unordered_map<uint64_t, uint32_t>;
+
+    //! Scale and translate as SDL's render copy does.
+    rect_t to_screen_(int const x, int const y, int const w, int const h) const noexcept {
+        return {
+            bklib::floor_to<int>(x * sx_ + tx_)
+          , bklib::floor_to<int>(y * sy_ + ty_)
+          , bklib::ceil_to<int>(w * sx_)
+          , bklib::ceil_to<int>(h * sy_)
+        };
+    }
+
+    void push_(command_t::type_t const type, color4 const color, rect_t const dst) {
+        commands_.push_back(command_t {type, color, 0, 0, 0, 0, 0, dst});
+    }
+
+    void push_sprite_(rect_t const src, rect_t const dst, color4 const color) {
+        commands_.push_back(command_t {command_t::type_t::sprite, color, 0
+          , static_cast<int16_t>(src.x), static_cast<int16_t>(src.y)
+          , static_cast<int16_t>(src.w), static_cast<int16_t>(src.h)
+          , dst});
+    }
+
+    //! The index in cached_ of the entry for @p key.
+    uint32_t cached_index_(cache_index_t& index, uint64_t const key) {
+        auto const result = index.emplace(key, static_cast<uint32_t>(cached_.size()));
+        if (result.second) {
+            cached_.emplace_back();
+        }
+
+        return result.first->second;
+    }
+
+    //! Draw the @p sw x @p sh source, read by sample(u, v), stretched over @p dst.
+    template <typename Sample>
+    void blit_(rect_t const clip, rect_t const dst, int const sw, int const sh, Sample&& sample) {
+        auto const r = intersect(clip, dst);
+
+        for (auto y = r.y; y < r.y + r.h; ++y) {
+            auto const v = (y - dst.y) * sh / dst.h;
+            auto const row = framebuffer_.data() + static_cast<size_t>(y) * static_cast<size_t>(width_);
+
+            for (auto x = r.x; x < r.x + r.w; ++x) {
+                blend(row[x], sample((x - dst.x) * sw / dst.w, v));
+            }
+        }
+    }
+
+    void blit_sprite_(rect_t const clip, rect_t const dst, int const sx, int const sy
+      , int const sw, int const sh, color4 const tint
+    ) {
+        if (tile_texture_.empty()) {
+            blit_(clip, dst, sw, sh, [&](int, int) noexcept {
+                return color4 {{tint[0], tint[1], tint[2], 255}};
+            });
+            return;
+        }
+
+        auto const tex_w = tilemap_.texture_w();
+        auto const tex_h = tilemap_.texture_h();
+
+        blit_(clip, dst, sw, sh, [&](int const u, int const v) noexcept {
+            auto const tx = std::min(sx + u, tex_w - 1);
+            auto const ty = std::min(sy + v, tex_h - 1);
+            return modulate(tile_texture_[static_cast<size_t>(ty * tex_w + tx)], tint);
+        });
+    }
+
+    std::vector<command_t> commands_;
+    size_t                 draw_calls_ = 0;
+
+    std::vector<cached_t> cached_;
+    cache_index_t         cached_cells_;
+    cache_index_t         cached_texels_;
+
+    tilemap             tilemap_;
+    std::vector<color4> tile_texture_;
+
+    std::vector<color4> framebuffer_;
+    int width_;
+    int height_;
+
+    color4 draw_color_ = clear_color;
+    rect_t clip_ {};
+
+    double sx_ = 1.0;
+    double sy_ = 1.0;
+    double tx_ = 0.0;
+    double ty_ = 0.0;
+};
+
+//--------------------------------------------------------------------------------------------------
+bkrl::recording_renderer::~recording_renderer() {
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::recording_renderer_impl::~recording_renderer_impl() {
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::recording_renderer_impl::rasterize()
+{
+    std::fill(std::begin(framebuffer_), std::end(framebuffer_), clear_color);
+
+    auto const screen = rect_t {0, 0, width_, height_};
+    auto clip = screen;
+
+    for (auto const& c : commands_) {
+        switch (c.type) {
+        case command_t::type_t::clip :
+            clip = intersect(screen, c.dst);
+            break;
+        case command_t::type_t::fill :
+            blit_(clip, c.dst, 1, 1, [&](int, int) noexcept { return c.color; });
+            break;
+        case command_t::type_t::sprite :
+            blit_sprite_(clip, c.dst, c.src_x, c.src_y, c.src_w, c.src_h, c.color);
+            break;
+        case command_t::type_t::cells : {
+            auto const& entry = cached_[c.data];
+            auto const w = static_cast<int>(entry.w);
+            auto const h = static_cast<int>(entry.h);
+
+            for (auto yi = 0; yi < h; ++yi) {
+                for (auto xi = 0; xi < w; ++xi) {
+                    auto const i = entry.cells[static_cast<size_t>(yi * w + xi)];
+                    if (i == 0) {
+                        continue;
+                    }
+
+                    // the cell's share of the destination, so that adjacent cells meet exactly
+                    auto const x0 = c.dst.x + xi * c.dst.w / w;
+                    auto const y0 = c.dst.y + yi * c.dst.h / h;
+                    auto const x1 = c.dst.x + (xi + 1) * c.dst.w / w;
+                    auto const y1 = c.dst.y + (yi + 1) * c.dst.h / h;
+
+                    if (x1 == x0 || y1 == y0) {
+                        continue;
+                    }
+
+                    auto const r = tilemap_.get_bounds(i);
+                    blit_sprite_(clip, rect_t {x0, y0, x1 - x0, y1 - y0}
+                      , r.left, r.top, r.width(), r.height(), white);
+                }
+            }
+        } break;
+        case command_t::type_t::texels : {
+            auto const& entry = cached_[c.data];
+            auto const w = static_cast<int>(entry.w);
+
+            blit_(clip, c.dst, w, static_cast<int>(entry.h), [&](int const u, int const v) noexcept {
+                return entry.texels[static_cast<size_t>(v * w + u)];
+            });
+        } break;
+        default :
+            BK_ASSERT(false);
+            break;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+std::unique_ptr<bkrl::recording_renderer> bkrl::make_recording_renderer(
+    int const width, int const height
+  , int const tile_w, int const tile_h
+) {
+    return std::make_unique<recording_renderer_impl>(width, height, tile_w, tile_h);
+}
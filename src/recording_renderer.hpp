@@ -0,0 +1,56 @@
+#pragma once
+
+#include "renderer.hpp"
+
+#include <vector>
+
+namespace bkrl {
+
+//--------------------------------------------------------------------------------------------------
+//! A renderer without a window. Draw calls are recorded as a list of commands, scaled and
+//! translated as the SDL renderer would, and can be rasterized in software into an RGBA
+//! framebuffer. This makes frame composition measurable and testable without SDL.
+//--------------------------------------------------------------------------------------------------
+class recording_renderer : public renderer {
+public:
+    struct command_t {
+        enum class type_t : uint8_t {
+            clip    //!< set the clip region to dst
+          , fill    //!< fill dst with color
+          , sprite  //!< draw src of the tile texture to dst, tinted by color
+          , cells   //!< draw the cached block of cells data to dst
+          , texels  //!< draw the cached texels data to dst
+        };
+
+        type_t   type;
+        color4   color;
+        uint32_t data;  //!< the index of the cached cells or texels
+        int16_t  src_x, src_y, src_w, src_h;
+        rect_t   dst;
+    };
+
+    virtual ~recording_renderer();
+
+    //! The commands recorded since the last clear().
+    virtual std::vector<command_t> const& commands() const noexcept = 0;
+
+    //! The number of draw calls made since the last clear().
+    virtual size_t draw_calls() const noexcept = 0;
+
+    //! Use the @p w x @p h RGBA texels at @p data as the tile texture; without one, cells are
+    //! rasterized as solid blocks of their tint.
+    virtual void set_tile_texture(int w, int h, color4 const* data) = 0;
+
+    //! Draw the commands recorded since the last clear() into the framebuffer.
+    virtual void rasterize() = 0;
+
+    //! width() x height() RGBA pixels, by rows.
+    virtual color4 const* framebuffer() const noexcept = 0;
+    virtual int width()  const noexcept = 0;
+    virtual int height() const noexcept = 0;
+};
+
+std::unique_ptr<recording_renderer> make_recording_renderer(
+    int width, int height, int tile_w = 18, int tile_h = 18);
+
+} //namespace bkrl
@@ -0,0 +1,407 @@
+#include "render_list.hpp"
+
+#include "bklib/assert.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace bkrl { class render_list_impl; }
+
+namespace {
+
+using rect_t = bkrl::renderer::rect_t;
+using bkrl::color4;
+
+//! The layout draw_rects data is copied into.
+struct rect_data_t {
+    int16_t src[4];
+    int16_t dst[2];
+    color4  color;
+};
+
+//! Cached data not used for this many frames is released.
+constexpr uint64_t cache_frames = 120;
+
+} //namespace
+
+//--------------------------------------------------------------------------------------------------
+//! Render list implementation.
+//--------------------------------------------------------------------------------------------------
+class bkrl::render_list_impl final : public render_list {
+public:
+    virtual ~render_list_impl();
+
+    //----------------------------------------------------------------------------------------------
+    void clear_clip_region() override final {
+        clip_ = rect_t {};
+        push_(op_t::clear_clip_region);
+    }
+
+    void set_clip_region(rect_t const r) override final {
+        clip_ = r;
+        push_(op_t::set_clip_region).rect[0] = r;
+    }
+
+    rect_t get_clip_region() override final {
+        return clip_;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void set_scale(double const sx, double const sy) override final {
+        sx_ = sx;
+        sy_ = sy;
+
+        auto& c = push_(op_t::set_scale);
+        c.d[0] = sx;
+        c.d[1] = sy;
+    }
+
+    void set_scale(double const scale) override final {
+        set_scale(scale, scale);
+    }
+
+    void set_translation(double const dx, double const dy) override final {
+        tx_ = dx;
+        ty_ = dy;
+
+        auto& c = push_(op_t::set_translation);
+        c.d[0] = dx;
+        c.d[1] = dy;
+    }
+
+    bklib::point_t<2, double> get_scale() const override final {
+        return {sx_, sy_};
+    }
+
+    bklib::point_t<2, double> get_translation() const override final {
+        return {tx_, ty_};
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void clear() override final {
+        push_(op_t::clear);
+    }
+
+    //! Presenting is up to whoever replays the list.
+    void present() override final {
+    }
+
+    void set_active_texture(texture const tex) override final {
+        push_(op_t::set_active_texture).i[0] = static_cast<int>(tex);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void draw_filled_rect(rect_t const r) override final {
+        push_(op_t::draw_filled_rect).rect[0] = r;
+    }
+
+    void draw_filled_rect(rect_t const r, color4 const color) override final {
+        auto& c = push_(op_t::draw_filled_rect_color);
+        c.rect[0] = r;
+        c.color   = color;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void draw_cell(int const cell_x, int const cell_y, int const tile_index) override final {
+        auto& c = push_(op_t::draw_cell);
+        c.i[0] = cell_x;
+        c.i[1] = cell_y;
+        c.i[2] = tile_index;
+    }
+
+    void draw_cell(int const cell_x, int const cell_y, int const tile_index
+      , color4 const color
+    ) override final {
+        auto& c = push_(op_t::draw_cell_color);
+        c.i[0]  = cell_x;
+        c.i[1]  = cell_y;
+        c.i[2]  = tile_index;
+        c.color = color;
+    }
+
+    void draw_rect(rect_t const src, rect_t const dst) override final {
+        auto& c = push_(op_t::draw_rect);
+        c.rect[0] = src;
+        c.rect[1] = dst;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void draw_cells(
+        int const xoff, int const yoff
+      , size_t const w, size_t const h
+      , void const* const data
+      , ptrdiff_t const tex_offset, size_t
+      , size_t const stride
+    ) override final {
+        auto const offset = cells_.size();
+        copy_cells_(cells_, w * h, data, tex_offset, stride);
+
+        auto& c = push_(op_t::draw_cells);
+        c.i[0]   = xoff;
+        c.i[1]   = yoff;
+        c.w      = w;
+        c.h      = h;
+        c.offset = offset;
+    }
+
+    void draw_cells_cached(
+        uint64_t const key, uint64_t const version
+      , int const xoff, int const yoff
+      , size_t const w, size_t const h
+      , void const* const data
+      , ptrdiff_t const tex_offset, size_t
+      , size_t const stride
+    ) override final {
+        auto& entry = cached_(cached_cells_, key, version, w, h, [&](cached_t& e) {
+            e.cells.clear();
+            copy_cells_(e.cells, w * h, data, tex_offset, stride);
+        });
+
+        auto& c = push_(op_t::draw_cells_cached);
+        c.i[0]   = xoff;
+        c.i[1]   = yoff;
+        c.w      = w;
+        c.h      = h;
+        c.key    = key;
+        c.cached = &entry;
+    }
+
+    void draw_texels_cached(
+        uint64_t const key, uint64_t const version
+      , rect_t const dst
+      , size_t const w, size_t const h
+      , color4 const* const data
+    ) override final {
+        auto& entry = cached_(cached_texels_, key, version, w, h, [&](cached_t& e) {
+            e.texels.assign(data, data + w * h);
+        });
+
+        auto& c = push_(op_t::draw_texels_cached);
+        c.rect[0] = dst;
+        c.w       = w;
+        c.h       = h;
+        c.key     = key;
+        c.cached  = &entry;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void draw_rects(
+        int const xoff, int const yoff
+      , size_t const count
+      , void const* const data
+      , ptrdiff_t const src_pos_offset, size_t
+      , ptrdiff_t const dst_pos_offset, size_t
+      , ptrdiff_t const color_offset,   size_t
+      , size_t const stride
+    ) override final {
+        auto const offset = rects_.size();
+        rects_.resize(offset + count);
+
+        auto p = static_cast<char const*>(data);
+        for (auto i = offset; i < offset + count; ++i, p += stride) {
+            auto& r = rects_[i];
+            std::memcpy(r.src, p + src_pos_offset, sizeof(r.src));
+            std::memcpy(r.dst, p + dst_pos_offset, sizeof(r.dst));
+            std::memcpy(r.color.data(), p + color_offset, 3);
+            r.color[3] = 255;
+        }
+
+        auto& c = push_(op_t::draw_rects);
+        c.i[0]   = xoff;
+        c.i[1]   = yoff;
+        c.w      = count;
+        c.offset = offset;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void reset() override final;
+    void replay(renderer& render) const override final;
+
+    size_t size() const noexcept override final {
+        return commands_.size();
+    }
+private:
+    enum class op_t : uint8_t {
+        clear_clip_region, set_clip_region, set_scale, set_translation, clear
+      , set_active_texture, draw_filled_rect, draw_filled_rect_color, draw_cell, draw_cell_color
+      , draw_rect, draw_cells, draw_cells_cached, draw_texels_cached, draw_rects
+    };
+
+    //! The copy of the data for a key of draw_cells_cached or draw_texels_cached.
+    struct cached_t {
+        uint64_t              version   = 0;
+        uint64_t              last_used = 0;
+        std::vector<uint16_t> cells;
+        std::vector<color4>   texels;
+    };
+
+    using cache_t = std::unordered_map<uint64_t, cached_t>;
+
+    //! A recorded call; which of the members are used depends on op.
+    struct command_t {
+        op_t            op;
+        color4          color;
+        int             i[3];
+        rect_t          rect[2];
+        double          d[2];
+        size_t          w;
+        size_t          h;
+        size_t          offset;  //!< into cells_ or rects_
+        uint64_t        key;
+        cached_t const* cached;
+    };
+
+    command_t& push_(op_t const op) {
+        commands_.push_back(command_t {});
+        commands_.back().op = op;
+        return commands_.back();
+    }
+
+    static void copy_cells_(std::vector<uint16_t>& out, size_t const n, void const* const data
+      , ptrdiff_t const offset, size_t const stride
+    ) {
+        auto const first = out.size();
+        out.resize(first + n);
+
+        auto const p = static_cast<char const*>(data) + offset;
+        for (auto i = 0u; i < n; ++i) {
+            std::memcpy(&out[first + i], p + i * stride, sizeof(uint16_t));
+        }
+    }
+
+    //! The entry for @p key in @p cache, updated by update(entry) if it isn't already at
+    //! @p version with the given size.
+    template <typename Update>
+    cached_t& cached_(cache_t& cache, uint64_t const key, uint64_t const version
+      , size_t const w, size_t const h, Update&& update
+    ) {
+        auto const result = cache.emplace(key, cached_t {});
+        auto& entry = result.first->second;
+
+        auto const size = std::max(entry.cells.size(), entry.texels.size());
+        if (result.second || entry.version != version || size != w * h) {
+            update(entry);
+            entry.version = version;
+        }
+
+        entry.last_used = frame_;
+        return entry;
+    }
+
+    std::vector<command_t>   commands_;
+    std::vector<uint16_t>    cells_;
+    std::vector<rect_data_t> rects_;
+
+    cache_t  cached_cells_;
+    cache_t  cached_texels_;
+    uint64_t frame_ = 0;
+
+    rect_t clip_ {};
+    double sx_ = 1.0;
+    double sy_ = 1.0;
+    double tx_ = 0.0;
+    double ty_ = 0.0;
+};
+
+//--------------------------------------------------------------------------------------------------
+bkrl::render_list::~render_list() {
+}
+
+//--------------------------------------------------------------------------------------------------
+bkrl::render_list_impl::~render_list_impl() {
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::render_list_impl::reset()
+{
+    commands_.clear();
+    cells_.clear();
+    rects_.clear();
+
+    ++frame_;
+
+    for (auto* const cache : {&cached_cells_, &cached_texels_}) {
+        for (auto it = std::begin(*cache); it != std::end(*cache); ) {
+            if (frame_ - it->second.last_used > cache_frames) {
+                it = cache->erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::render_list_impl::replay(renderer& render) const
+{
+    constexpr auto const cell_size = sizeof(uint16_t);
+    constexpr auto const rect_size = sizeof(rect_data_t);
+
+    for (auto const& c : commands_) {
+        switch (c.op) {
+        case op_t::clear_clip_region :
+            render.clear_clip_region();
+            break;
+        case op_t::set_clip_region :
+            render.set_clip_region(c.rect[0]);
+            break;
+        case op_t::set_scale :
+            render.set_scale(c.d[0], c.d[1]);
+            break;
+        case op_t::set_translation :
+            render.set_translation(c.d[0], c.d[1]);
+            break;
+        case op_t::clear :
+            render.clear();
+            break;
+        case op_t::set_active_texture :
+            render.set_active_texture(static_cast<texture>(c.i[0]));
+            break;
+        case op_t::draw_filled_rect :
+            render.draw_filled_rect(c.rect[0]);
+            break;
+        case op_t::draw_filled_rect_color :
+            render.draw_filled_rect(c.rect[0], c.color);
+            break;
+        case op_t::draw_cell :
+            render.draw_cell(c.i[0], c.i[1], c.i[2]);
+            break;
+        case op_t::draw_cell_color :
+            render.draw_cell(c.i[0], c.i[1], c.i[2], c.color);
+            break;
+        case op_t::draw_rect :
+            render.draw_rect(c.rect[0], c.rect[1]);
+            break;
+        case op_t::draw_cells :
+            render.draw_cells(c.i[0], c.i[1], c.w, c.h, cells_.data() + c.offset
+              , 0, cell_size, cell_size);
+            break;
+        case op_t::draw_cells_cached :
+            render.draw_cells_cached(c.key, c.cached->version, c.i[0], c.i[1], c.w, c.h
+              , c.cached->cells.data(), 0, cell_size, cell_size);
+            break;
+        case op_t::draw_texels_cached :
+            render.draw_texels_cached(c.key, c.cached->version, c.rect[0], c.w, c.h
+              , c.cached->texels.data());
+            break;
+        case op_t::draw_rects :
+            render.draw_rects(c.i[0], c.i[1], c.w, rects_.data() + c.offset
+              , offsetof(rect_data_t, src),   sizeof(rect_data_t::src)
+              , offsetof(rect_data_t, dst),   sizeof(rect_data_t::dst)
+              , offsetof(rect_data_t, color), sizeof(rect_data_t::color)
+              , rect_size);
+            break;
+        default :
+            BK_ASSERT(false);
+            break;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+std::unique_ptr<bkrl::render_list> bkrl::make_render_list() {
+    return std::make_unique<render_list_impl>();
+}
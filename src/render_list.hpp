@@ -0,0 +1,31 @@
+#pragma once
+
+#include "renderer.hpp"
+
+namespace bkrl {
+
+//--------------------------------------------------------------------------------------------------
+//! A renderer that records the calls made to it, along with copies of the data they refer to, so
+//! that they can be replayed later against another renderer, possibly on another thread. A list
+//! isn't modified by replaying it.
+//!
+//! The data for draw_cells_cached and draw_texels_cached is copied only when the version for its
+//! key changes, so a list reused from frame to frame copies only what has changed.
+//--------------------------------------------------------------------------------------------------
+class render_list : public renderer {
+public:
+    virtual ~render_list();
+
+    //! Discard the recorded calls.
+    virtual void reset() = 0;
+
+    //! Make each of the recorded calls, in order, on @p render.
+    virtual void replay(renderer& render) const = 0;
+
+    //! The number of calls recorded since the last reset().
+    virtual size_t size() const noexcept = 0;
+};
+
+std::unique_ptr<render_list> make_render_list();
+
+} //namespace bkrl
@@ -33,6 +33,10 @@ public:
 
     void draw_cells(int, int, size_t, size_t, void const*, ptrdiff_t
                   , size_t, size_t) override final { }
+    void draw_cells_cached(uint64_t, uint64_t, int, int, size_t, size_t, void const*
+                         , ptrdiff_t, size_t, size_t) override final { }
+    void draw_texels_cached(uint64_t, uint64_t, rect_t, size_t, size_t
+                          , color4 const*) override final { }
     void draw_rects(int, int, size_t, void const*, ptrdiff_t, size_t
                   , ptrdiff_t, size_t, ptrdiff_t, size_t, size_t) override final { }
 };
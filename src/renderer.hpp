@@ -120,6 +120,26 @@ public:
       , size_t stride
     ) = 0;
 
+    //! As draw_cells, but the result may be kept by the renderer under @p key and reused for as
+    //! long as @p version stays the same; @p data is only read when the version changes.
+    virtual void draw_cells_cached(
+        uint64_t key, uint64_t version
+      , int xoff, int yoff
+      , size_t w, size_t h
+      , void const* data
+      , ptrdiff_t tex_offset, size_t tex_size
+      , size_t stride
+    ) = 0;
+
+    //! Draw the @p w x @p h RGBA texels at @p data stretched over @p dst; as with
+    //! draw_cells_cached they may be kept under @p key for as long as @p version stays the same.
+    virtual void draw_texels_cached(
+        uint64_t key, uint64_t version
+      , rect_t dst
+      , size_t w, size_t h
+      , color4 const* data
+    ) = 0;
+
     virtual void draw_rects(
         int xoff, int yoff
       , size_t count
@@ -148,13 +168,13 @@ struct terrain_render_data_t {
 };
 
 struct creature_render_data_t {
-    int16_t x, y;
+    int32_t x, y;
     uint16_t base_index;
     color4 color;
 };
 
 struct item_render_data_t {
-    int16_t x, y;
+    int32_t x, y;
     uint16_t base_index;
     color4 color;
 };
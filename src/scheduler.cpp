@@ -0,0 +1,40 @@
+#include "scheduler.hpp"
+
+#include "bklib/assert.hpp"
+
+#include <algorithm>
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::turn_scheduler::schedule(creature_handle const h, game_time const when)
+{
+    BK_PRECONDITION(when >= now_);
+
+    heap_.push_back(entry_t {when, order_++, h});
+    std::push_heap(begin(heap_), end(heap_), later_);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::turn_scheduler::next(game_time const until, creature_handle& out)
+{
+    if (heap_.empty() || heap_.front().when > until) {
+        now_ = std::max(now_, until);
+        return false;
+    }
+
+    std::pop_heap(begin(heap_), end(heap_), later_);
+
+    auto const& e = heap_.back();
+    now_ = e.when;
+    out  = e.who;
+
+    heap_.pop_back();
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void bkrl::turn_scheduler::clear() noexcept
+{
+    heap_.clear();
+    order_ = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "creature.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace bkrl {
+
+//--------------------------------------------------------------------------------------------------
+//! A priority queue of creatures keyed on the time of their next action. Only the creatures whose
+//! time has come are ever looked at, so the cost of a turn depends on the actions taken in it and
+//! not on the number of creatures waiting.
+//!
+//! Entries aren't removed along with their creature; they are simply stale (see
+//! map::get_creature) by the time they come up.
+//--------------------------------------------------------------------------------------------------
+class turn_scheduler {
+public:
+    //! The time up to which actions have been taken.
+    game_time now() const noexcept {
+        return now_;
+    }
+
+    //! Schedule @p h to act at @p when; actions scheduled for the same time are taken in the order
+    //! they were scheduled.
+    //! @pre when >= now()
+    void schedule(creature_handle h, game_time when);
+
+    //! Schedule @p h to act @p delay ticks from now().
+    void schedule_in(creature_handle const h, game_time const delay) {
+        schedule(h, now_ + delay);
+    }
+
+    //! Take the earliest entry due no later than @p until and advance now() to its time.
+    //! @return false, with now() advanced to @p until, if there is no such entry; true otherwise.
+    bool next(game_time until, creature_handle& out);
+
+    size_t size()  const noexcept { return heap_.size(); }
+    bool   empty() const noexcept { return heap_.empty(); }
+
+    void clear() noexcept;
+private:
+    struct entry_t {
+        game_time       when;
+        uint64_t        order; //!< breaks ties between entries with the same time
+        creature_handle who;
+    };
+
+    //! Orders the heap so that the earliest entry is at the front.
+    static bool later_(entry_t const& a, entry_t const& b) noexcept {
+        return (a.when != b.when) ? (a.when > b.when) : (a.order > b.order);
+    }
+
+    std::vector<entry_t> heap_;
+    game_time            now_   = 0;
+    uint64_t             order_ = 0;
+};
+
+} //namespace bkrl
@@ -12,6 +12,7 @@ public:
     bool is_running() const noexcept override final { return true; }
     void do_events_nowait() override final { }
     void do_events_wait() override final { }
+    void wake() override final { }
     void delay(std::chrono::nanoseconds) override final { }
     key_mod_state current_key_mods() const noexcept override final { return {}; }
 };
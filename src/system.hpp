@@ -40,6 +40,12 @@ public:
     virtual void do_events_nowait() = 0;
     virtual void do_events_wait() = 0;
 
+    //----------------------------------------------------------------------------------------------
+    //! Make a do_events_wait() in progress, or else the next one, return. Safe to call from any
+    //! thread.
+    //----------------------------------------------------------------------------------------------
+    virtual void wake() = 0;
+
     //----------------------------------------------------------------------------------------------
     //!
     //----------------------------------------------------------------------------------------------
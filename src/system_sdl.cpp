@@ -7,7 +7,17 @@
 #include "bklib/exception.hpp"
 
 #include <SDL2/SDL.h>
+#include <algorithm>
 #include <memory>
+#include <unordered_map>
+#include <vector>
+
+//! SDL_RenderGeometry lets whole blocks of cells be submitted as one draw call.
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#   define BK_SDL_RENDER_GEOMETRY 1
+#else
+#   define BK_SDL_RENDER_GEOMETRY 0
+#endif
 
 namespace bkrl { class sdl_state; }
 namespace bkrl { class sdl_window; }
@@ -135,6 +145,8 @@ public:
         on_mouse_move    = [](mouse_state) { };
         on_mouse_scroll  = [](mouse_state) { };
         on_mouse_button  = [](mouse_button_state) { };
+
+        on_render_reset  = [](bool) { };
     }
 
     //----------------------------------------------------------------------------------------------
@@ -163,6 +175,15 @@ public:
     //----------------------------------------------------------------------------------------------
     void do_events_wait() override final { do_events_(true); }
 
+    //----------------------------------------------------------------------------------------------
+    void wake() override final {
+        SDL_Event event {};
+        event.type = SDL_USEREVENT;
+
+        // SDL_PushEvent is thread safe; the event itself is ignored by do_events_.
+        SDL_PushEvent(&event);
+    }
+
     //----------------------------------------------------------------------------------------------
     void delay(std::chrono::nanoseconds) override final {
     }
@@ -172,6 +193,10 @@ public:
 public:
     sdl_window&       window()       noexcept { return window_; }
     sdl_window const& window() const noexcept { return window_; }
+
+    //! Render target textures have lost their contents; as has every texture if the argument is
+    //! true, as the device was lost. Set by renderer_sdl_impl.
+    std::function<void (bool)> on_render_reset;
 private:
     //----------------------------------------------------------------------------------------------
     bklib::ipoint2 client_size_() const noexcept {
@@ -193,6 +218,7 @@ private:
     void handle_mouse_button_(SDL_MouseButtonEvent const& event);
     void handle_window_(SDL_WindowEvent const& event);
     void handle_text_input_(SDL_TextInputEvent const& event);
+    void handle_render_reset_(bool device_lost);
 private:
     sdl_state   sdl_ {};
     sdl_window  window_ {};
@@ -207,6 +233,8 @@ class bkrl::renderer_sdl_impl final : public renderer {
 public:
     //----------------------------------------------------------------------------------------------
     void clear_clip_region() override final {
+        flush_geometry_();
+
         if (SDL_RenderSetClipRect(handle(), nullptr)) {
             BOOST_THROW_EXCEPTION(bklib::platform_error {}
               << boost::errinfo_api_function {"SDL_RenderSetClipRect"});
@@ -215,6 +243,8 @@ public:
 
     //----------------------------------------------------------------------------------------------
     void set_clip_region(rect_t const r) override final {
+        flush_geometry_();
+
         if (SDL_RenderSetClipRect(handle(), reinterpret_cast<SDL_Rect const*>(&r))) {
             BOOST_THROW_EXCEPTION(bklib::platform_error {}
               << boost::errinfo_api_function {"SDL_RenderSetClipRect"});
@@ -257,6 +287,8 @@ public:
 
     //----------------------------------------------------------------------------------------------
     void clear() override final {
+        discard_geometry_();
+
         if (SDL_SetRenderDrawColor(handle(), 255, 0, 0, 255)) {
             BOOST_THROW_EXCEPTION(bklib::platform_error {}
               << boost::errinfo_api_function {"SDL_SetRenderDrawColor"});
@@ -270,7 +302,11 @@ public:
 
     //----------------------------------------------------------------------------------------------
     void present() override final {
+        flush_geometry_();
         SDL_RenderPresent(handle());
+
+        evict_cached_textures_();
+        ++frame_;
     }
 
     //----------------------------------------------------------------------------------------------
@@ -278,6 +314,8 @@ public:
 
     //----------------------------------------------------------------------------------------------
     void draw_filled_rect(rect_t const r) override final {
+        flush_geometry_();
+
         SDL_Rect const r0 = convert_rect(r);
         if (SDL_RenderFillRect(handle(), &r0)) {
             BOOST_THROW_EXCEPTION(bklib::platform_error {}
@@ -304,39 +342,25 @@ public:
 
     //----------------------------------------------------------------------------------------------
     void draw_cell(int const cell_x, int const cell_y, int const tile_index) override final {
-        auto const r = tile_tilemap_.get_bounds(tile_index);
-        auto const w = tile_tilemap_.tile_w();
-        auto const h = tile_tilemap_.tile_h();
-
-        SDL_Rect const src {r.left,     r.top,      r.width(), r.height()};
-        SDL_Rect const dst {cell_x * w, cell_y * h, r.width(), r.height()};
-
-        render_copy(tile_texture_, src, dst);
+        draw_cell(cell_x, cell_y, tile_index, white_);
     }
 
     //----------------------------------------------------------------------------------------------
     void draw_cell(int const cell_x, int const cell_y
                  , int const tile_index, const color4 color
     ) override final {
-        auto const tex_handle = tile_texture_.handle();
-
-        color4 const old = [tex_handle] {
-            color4 result;
-            SDL_GetTextureColorMod(tex_handle, &result[0], &result[1], &result[2]);
-            return result;
-        }();
-
-        BK_SCOPE_EXIT {
-            SDL_SetTextureColorMod(tex_handle, old[0], old[1], old[2]);
-        };
+        auto const r = tile_tilemap_.get_bounds(tile_index);
+        auto const w = tile_tilemap_.tile_w();
+        auto const h = tile_tilemap_.tile_h();
 
-        SDL_SetTextureColorMod(tex_handle, color[0], color[1], color[2]);
-        draw_cell(cell_x, cell_y, tile_index);
+        queue_cell_(SDL_Rect {r.left, r.top, r.width(), r.height()}
+          , cell_x * w, cell_y * h, r.width(), r.height(), color);
     }
 
     //----------------------------------------------------------------------------------------------
     void draw_rect(rect_t const src, rect_t const dst) override final {
-        render_copy(tile_texture_, convert_rect(src), convert_rect(dst));
+        auto const d = convert_rect(dst);
+        queue_cell_(convert_rect(src), d.x, d.y, d.w, d.h, white_);
     }
 
     //----------------------------------------------------------------------------------------------
@@ -348,6 +372,24 @@ public:
       , size_t stride
     ) override final;
 
+    //----------------------------------------------------------------------------------------------
+    void draw_cells_cached(
+        uint64_t key, uint64_t version
+      , int xoff, int yoff
+      , size_t w, size_t h
+      , void const* data
+      , ptrdiff_t tex_offset, size_t tex_size
+      , size_t stride
+    ) override final;
+
+    //----------------------------------------------------------------------------------------------
+    void draw_texels_cached(
+        uint64_t key, uint64_t version
+      , rect_t dst
+      , size_t w, size_t h
+      , color4 const* data
+    ) override final;
+
     //----------------------------------------------------------------------------------------------
     void draw_rects(
         int xoff, int yoff
@@ -361,10 +403,14 @@ public:
 public:
     //----------------------------------------------------------------------------------------------
     explicit renderer_sdl_impl(system_sdl_impl& sys)
-      : handle_       {create_(sys.window())}
-      , tile_texture_ {*this, "data/tiles.bmp"}
+      : system_       {sys}
+      , handle_       {create_(sys.window())}
+      , tile_texture_ {*this, tile_filename_}
       , tile_tilemap_ {make_tilemap_(tile_texture_)}
     {
+        system_.on_render_reset = [this](bool const device_lost) {
+            on_reset_(device_lost);
+        };
     }
 
     //----------------------------------------------------------------------------------------------
@@ -375,21 +421,49 @@ public:
     SDL_Renderer* handle() const noexcept { return handle_.get(); }
 
     //----------------------------------------------------------------------------------------------
-    void render_copy(sdl_texture const& texture, SDL_Rect const src, SDL_Rect dst) {
+    void render_copy(sdl_texture const& texture, SDL_Rect const src, SDL_Rect const dst) {
+        render_copy(texture.handle(), src, dst);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    void render_copy(SDL_Texture* const texture, SDL_Rect const src, SDL_Rect dst) {
         dst.x = bklib::floor_to<int>(dst.x * sx_ + tx_);
         dst.y = bklib::floor_to<int>(dst.y * sy_ + ty_);
         dst.w = bklib::ceil_to<int>(dst.w * sx_);
         dst.h = bklib::ceil_to<int>(dst.h * sy_);
 
-        if (SDL_RenderCopy(handle(), texture.handle(), &src, &dst)) {
+        flush_geometry_();
+
+        if (SDL_RenderCopy(handle(), texture, &src, &dst)) {
             BOOST_THROW_EXCEPTION(bklib::platform_error {}
               << boost::errinfo_api_function {"SDL_RenderCopy"});
         }
     }
 private:
     using handle_t = std::unique_ptr<SDL_Renderer, decltype(&SDL_DestroyRenderer)>;
+    using texture_handle_t = std::unique_ptr<SDL_Texture, decltype(&SDL_DestroyTexture)>;
+
+    //! A texture kept by draw_cells_cached or draw_texels_cached.
+    struct cached_texture_t {
+        texture_handle_t texture   {nullptr, &SDL_DestroyTexture};
+        uint64_t         version   = 0;
+        uint64_t         last_used = 0; //!< the frame it was last drawn in
+        int              w         = 0;
+        int              h         = 0;
+    };
+
+    using texture_cache_t = std::unordered_map<uint64_t, cached_texture_t>;
+
+    //! The version of a cached texture that hasn't been drawn into yet.
+    static constexpr uint64_t no_version = ~uint64_t {0};
+
+    //! Cached textures not drawn for this many frames are released.
+    static constexpr uint64_t cache_frames = 120;
+
+    static constexpr char const* tile_filename_ = "data/tiles.bmp";
 
     //----------------------------------------------------------------------------------------------
+    //! Presenting waits for vsync if SDL_RENDER_VSYNC=1 is set in the environment.
     static handle_t create_(sdl_window const& w) {
         auto const result = SDL_CreateRenderer(w.handle(), -1, SDL_RENDERER_ACCELERATED);
 
@@ -407,6 +481,51 @@ private:
         return {18, 18, size.first, size.second};
     }
 
+    //----------------------------------------------------------------------------------------------
+    //! Add the (scaled and translated) quad for a cell of tile_texture_, tinted by @p color, to the
+    //! pending geometry. The tint is a vertex colour, so differently coloured cells still share a
+    //! single draw call.
+    //----------------------------------------------------------------------------------------------
+    void queue_cell_(SDL_Rect src, int dx, int dy, int dw, int dh, color4 color = white_);
+
+    //----------------------------------------------------------------------------------------------
+    //! Set the colour mod of tile_texture_, unless it is already @p color.
+    //----------------------------------------------------------------------------------------------
+    void set_tile_color_(color4 color);
+
+    //----------------------------------------------------------------------------------------------
+    //! Submit the pending geometry; everything else that draws does this first to keep the order
+    //! of draw calls.
+    //----------------------------------------------------------------------------------------------
+    void flush_geometry_();
+    void discard_geometry_() noexcept;
+
+    //----------------------------------------------------------------------------------------------
+    //! (Re)draw cells into the render target texture of @p entry.
+    //----------------------------------------------------------------------------------------------
+    void render_cached_cells_(
+        cached_texture_t& entry
+      , size_t w, size_t h
+      , void const* data
+      , ptrdiff_t tex_offset, size_t tex_size
+      , size_t stride
+    );
+
+    //----------------------------------------------------------------------------------------------
+    //! The entry for @p key in @p cache, with a texture of the given size; a new texture has a
+    //! version of no_version.
+    //----------------------------------------------------------------------------------------------
+    cached_texture_t& cached_texture_(texture_cache_t& cache, uint64_t key
+      , Uint32 format, int access, int w, int h);
+
+    void evict_cached_textures_() noexcept;
+
+    //----------------------------------------------------------------------------------------------
+    //! Forget the cached textures, whose contents are gone, so that they are drawn again; if
+    //! @p device_lost, load tile_texture_ again too.
+    //----------------------------------------------------------------------------------------------
+    void on_reset_(bool device_lost);
+
     //----------------------------------------------------------------------------------------------
     inline static SDL_Rect convert_rect(rect_t const r) noexcept {
         static_assert(sizeof(rect_t) == sizeof(SDL_Rect), "");
@@ -417,6 +536,8 @@ private:
         return *reinterpret_cast<SDL_Rect const*>(&r);
     }
 private:
+    system_sdl_impl& system_;
+
     handle_t handle_;
 
     double sx_ = 1.0;
@@ -426,6 +547,21 @@ private:
 
     sdl_texture tile_texture_; //TODO move in the future
     tilemap     tile_tilemap_;  //TODO move in the future
+
+    static constexpr color4 white_ {{255, 255, 255, 255}};
+
+    color4 tile_color_ = white_; //!< the colour mod of tile_texture_; see set_tile_color_
+
+    texture_cache_t cached_cells_;
+    texture_cache_t cached_texels_;
+    uint64_t        frame_ = 0;
+
+#if BK_SDL_RENDER_GEOMETRY
+    std::vector<SDL_Vertex> vertices_; //!< pending cells for tile_texture_
+    std::vector<int>        indices_;
+#else
+    std::vector<uint32_t>   order_;    //!< scratch space for draw_rects
+#endif
 };
 
 //=====----------------------------------------------------------------------------------------=====
@@ -493,13 +629,17 @@ void bkrl::system_sdl_impl::do_events_(bool const wait)
         case SDL_TEXTINPUT :
             handle_text_input_(event.text);
             break;
+        case SDL_RENDER_TARGETS_RESET :
+        case SDL_RENDER_DEVICE_RESET :
+            handle_render_reset_(event.type == SDL_RENDER_DEVICE_RESET);
+            break;
         default :
             break;
         }
     };
 
     SDL_ClearError();
-    if (!is_running_ || !wait || SDL_WaitEventTimeout(nullptr, 100)) {
+    if (!is_running_ || !wait || SDL_WaitEvent(nullptr)) {
         while (SDL_PollEvent(&event)) {
             process_event();
         }
@@ -609,9 +749,12 @@ void bkrl::system_sdl_impl::handle_window_(SDL_WindowEvent const& event)
     case SDL_WINDOWEVENT_NONE :
     case SDL_WINDOWEVENT_SHOWN :
     case SDL_WINDOWEVENT_HIDDEN :
-    case SDL_WINDOWEVENT_EXPOSED :
     case SDL_WINDOWEVENT_MOVED :
         break;
+    case SDL_WINDOWEVENT_EXPOSED :
+        // frames are only presented when they change; treat this like a resize to get a new one
+        on_window_resize(client_width(), client_height());
+        break;
     case SDL_WINDOWEVENT_RESIZED :
         on_window_resize(event.data1, event.data2);
         break;
@@ -635,6 +778,15 @@ void bkrl::system_sdl_impl::handle_text_input_(SDL_TextInputEvent const& event)
     on_text_input(event.text);
 }
 
+//----------------------------------------------------------------------------------------------
+void bkrl::system_sdl_impl::handle_render_reset_(bool const device_lost)
+{
+    on_render_reset(device_lost);
+
+    // as for SDL_WINDOWEVENT_EXPOSED; the last frame presented is gone
+    on_window_resize(client_width(), client_height());
+}
+
 //=====----------------------------------------------------------------------------------------=====
 //                                          bkrl::renderer_sdl_impl
 //=====----------------------------------------------------------------------------------------=====
@@ -659,8 +811,12 @@ inline T get_integer_at(
 
 //----------------------------------------------------------------------------------------------
 bkrl::renderer_sdl_impl::~renderer_sdl_impl() {
+    system_.on_render_reset = [](bool) { };
 }
 
+constexpr bkrl::color4 bkrl::renderer_sdl_impl::white_;
+constexpr char const*  bkrl::renderer_sdl_impl::tile_filename_;
+
 //----------------------------------------------------------------------------------------------
 void bkrl::renderer_sdl_impl::draw_cells(
     int const xoff, int const yoff
@@ -682,13 +838,246 @@ void bkrl::renderer_sdl_impl::draw_cells(
             auto const dx = tw * (xoff + static_cast<int>(xi));
             auto const dy = th * (yoff + static_cast<int>(yi));
 
-            render_copy(tile_texture_
-              , SDL_Rect {r.left, r.top, tw, th}
-              , SDL_Rect {dx, dy, tw, th});
+            queue_cell_(SDL_Rect {r.left, r.top, tw, th}, dx, dy, tw, th);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::draw_cells_cached(
+    uint64_t const key, uint64_t const version
+  , int const xoff, int const yoff
+  , size_t const w, size_t const h
+  , void const* const data
+  , ptrdiff_t const tex_offset, size_t const tex_size
+  , size_t const stride
+) {
+    if (!SDL_RenderTargetSupported(handle())) {
+        draw_cells(xoff, yoff, w, h, data, tex_offset, tex_size, stride);
+        return;
+    }
+
+    auto const tw = tile_tilemap_.tile_w();
+    auto const th = tile_tilemap_.tile_h();
+    auto const pw = tw * static_cast<int>(w);
+    auto const ph = th * static_cast<int>(h);
+
+    auto& entry = cached_texture_(cached_cells_, key
+      , SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, pw, ph);
+
+    if (entry.version != version) {
+        render_cached_cells_(entry, w, h, data, tex_offset, tex_size, stride);
+    }
+
+    entry.version   = version;
+    entry.last_used = frame_;
+
+    render_copy(entry.texture.get(), SDL_Rect {0, 0, pw, ph}, SDL_Rect {xoff * tw, yoff * th, pw, ph});
+}
+
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::render_cached_cells_(
+    cached_texture_t& entry
+  , size_t const w, size_t const h
+  , void const* const data
+  , ptrdiff_t const tex_offset, size_t const tex_size
+  , size_t const stride
+) {
+    flush_geometry_();
+
+    auto const target = SDL_GetRenderTarget(handle());
+    if (SDL_SetRenderTarget(handle(), entry.texture.get())) {
+        BOOST_THROW_EXCEPTION(bklib::platform_error {}
+          << boost::errinfo_api_function {"SDL_SetRenderTarget"});
+    }
+
+    auto const scale = get_scale();
+    auto const trans = get_translation();
+
+    BK_SCOPE_EXIT {
+        discard_geometry_();
+        SDL_SetRenderTarget(handle(), target);
+        set_scale(x(scale), y(scale));
+        set_translation(x(trans), y(trans));
+    };
+
+    // cells are drawn unscaled at the origin of the texture
+    set_scale(1.0);
+    set_translation(0.0, 0.0);
+
+    if (SDL_SetRenderDrawColor(handle(), 0, 0, 0, 0) || SDL_RenderClear(handle())) {
+        BOOST_THROW_EXCEPTION(bklib::platform_error {}
+          << boost::errinfo_api_function {"SDL_RenderClear"});
+    }
+
+    draw_cells(0, 0, w, h, data, tex_offset, tex_size, stride);
+    flush_geometry_();
+}
+
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::draw_texels_cached(
+    uint64_t const key, uint64_t const version
+  , rect_t const dst
+  , size_t const w, size_t const h
+  , color4 const* const data
+) {
+    auto const tw = static_cast<int>(w);
+    auto const th = static_cast<int>(h);
+
+    auto& entry = cached_texture_(cached_texels_, key
+      , SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, tw, th);
+
+    if (entry.version != version) {
+        if (SDL_UpdateTexture(entry.texture.get(), nullptr, data, tw * static_cast<int>(sizeof(color4)))) {
+            BOOST_THROW_EXCEPTION(bklib::platform_error {}
+              << boost::errinfo_api_function {"SDL_UpdateTexture"});
         }
     }
+
+    entry.version   = version;
+    entry.last_used = frame_;
+
+    render_copy(entry.texture.get(), SDL_Rect {0, 0, tw, th}, convert_rect(dst));
+}
+
+//----------------------------------------------------------------------------------------------
+bkrl::renderer_sdl_impl::cached_texture_t&
+bkrl::renderer_sdl_impl::cached_texture_(
+    texture_cache_t& cache
+  , uint64_t const key
+  , Uint32 const format
+  , int const access
+  , int const w, int const h
+) {
+    auto& entry = cache[key];
+
+    if (entry.texture && entry.w == w && entry.h == h) {
+        return entry;
+    }
+
+    entry.texture.reset(SDL_CreateTexture(handle(), format, access, w, h));
+
+    if (!entry.texture) {
+        cache.erase(key);
+        BOOST_THROW_EXCEPTION(bklib::platform_error {}
+          << boost::errinfo_api_function {"SDL_CreateTexture"});
+    }
+
+    SDL_SetTextureBlendMode(entry.texture.get(), SDL_BLENDMODE_BLEND);
+
+    entry.version = no_version;
+    entry.w       = w;
+    entry.h       = h;
+
+    return entry;
+}
+
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::evict_cached_textures_() noexcept {
+    for (auto* const cache : {&cached_cells_, &cached_texels_}) {
+        for (auto it = std::begin(*cache); it != std::end(*cache); ) {
+            if (frame_ - it->second.last_used > cache_frames) {
+                it = cache->erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::on_reset_(bool const device_lost) {
+    discard_geometry_();
+
+    cached_cells_.clear();
+    cached_texels_.clear();
+
+    if (device_lost) {
+        tile_texture_ = sdl_texture {*this, tile_filename_};
+        tile_color_   = white_;
+    }
+}
+
+#if BK_SDL_RENDER_GEOMETRY
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::queue_cell_(
+    SDL_Rect const src
+  , int const dx, int const dy
+  , int const dw, int const dh
+  , color4 const color
+) {
+    auto const u_scale = 1.0f / static_cast<float>(tile_tilemap_.texture_w());
+    auto const v_scale = 1.0f / static_cast<float>(tile_tilemap_.texture_h());
+
+    auto const u0 = static_cast<float>(src.x) * u_scale;
+    auto const v0 = static_cast<float>(src.y) * v_scale;
+    auto const u1 = static_cast<float>(src.x + src.w) * u_scale;
+    auto const v1 = static_cast<float>(src.y + src.h) * v_scale;
+
+    auto const x0 = static_cast<float>(dx * sx_ + tx_);
+    auto const y0 = static_cast<float>(dy * sy_ + ty_);
+    auto const x1 = static_cast<float>((dx + dw) * sx_ + tx_);
+    auto const y1 = static_cast<float>((dy + dh) * sy_ + ty_);
+
+    // as with a colour mod, the alpha of the tint is ignored
+    SDL_Color const c {color[0], color[1], color[2], 255};
+
+    auto const base = static_cast<int>(vertices_.size());
+
+    vertices_.push_back(SDL_Vertex {SDL_FPoint {x0, y0}, c, SDL_FPoint {u0, v0}});
+    vertices_.push_back(SDL_Vertex {SDL_FPoint {x1, y0}, c, SDL_FPoint {u1, v0}});
+    vertices_.push_back(SDL_Vertex {SDL_FPoint {x0, y1}, c, SDL_FPoint {u0, v1}});
+    vertices_.push_back(SDL_Vertex {SDL_FPoint {x1, y1}, c, SDL_FPoint {u1, v1}});
+
+    indices_.insert(std::end(indices_), {
+        base + 0, base + 1, base + 2
+      , base + 2, base + 1, base + 3
+    });
+}
+
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::flush_geometry_() {
+    if (indices_.empty()) {
+        return;
+    }
+
+    BK_SCOPE_EXIT {
+        discard_geometry_();
+    };
+
+    auto const result = SDL_RenderGeometry(handle(), tile_texture_.handle()
+      , vertices_.data(), static_cast<int>(vertices_.size())
+      , indices_.data(),  static_cast<int>(indices_.size()));
+
+    if (result) {
+        BOOST_THROW_EXCEPTION(bklib::platform_error {}
+          << boost::errinfo_api_function {"SDL_RenderGeometry"});
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::discard_geometry_() noexcept {
+    vertices_.clear();
+    indices_.clear();
+}
+#else
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::queue_cell_(SDL_Rect const src, int const dx, int const dy
+  , int const dw, int const dh, color4 const color
+) {
+    set_tile_color_(color);
+    render_copy(tile_texture_, src, SDL_Rect {dx, dy, dw, dh});
 }
 
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::flush_geometry_() {
+}
+
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::discard_geometry_() noexcept {
+}
+#endif // BK_SDL_RENDER_GEOMETRY
+
 //----------------------------------------------------------------------------------------------
 void bkrl::renderer_sdl_impl::draw_rects(
     int const xoff, int const yoff
@@ -699,29 +1088,60 @@ void bkrl::renderer_sdl_impl::draw_rects(
   , ptrdiff_t const color_offset,   size_t const color_size
   , size_t const stride
 ) {
-    auto const tex_handle = tile_texture_.handle();
+    auto const base = static_cast<char const*>(data);
 
-    color4 old;
-    SDL_GetTextureColorMod(tex_handle, &old[0], &old[1], &old[2]);
-    BK_SCOPE_EXIT {
-        SDL_SetTextureColorMod(tex_handle, old[0], old[1], old[2]);
+    auto const draw = [&](size_t const i) {
+        auto const p   = base + i * stride;
+        auto const src = reinterpret_cast<int16_t const*>(p + src_pos_offset);
+        auto const dst = reinterpret_cast<int16_t const*>(p + dst_pos_offset);
+        auto const col = reinterpret_cast<uint8_t const*>(p + color_offset);
+
+        queue_cell_(SDL_Rect {src[0], src[1], src[2], src[3]}
+          , xoff + dst[0], yoff + dst[1], src[2], src[3]
+          , color4 {{col[0], col[1], col[2], 255}});
     };
 
-    auto p = static_cast<char const*>(data);
+#if BK_SDL_RENDER_GEOMETRY
+    for (auto i = 0u; i < count; ++i) {
+        draw(i);
+    }
+#else
+    // Without vertex colours each change of colour is a change of the texture's colour mod, so
+    // draw the rects grouped by colour; the rects of a single call don't overlap, so the order
+    // they are drawn in doesn't matter.
+    auto const color_at = [&](uint32_t const i) noexcept {
+        auto const col = reinterpret_cast<uint8_t const*>(base + i * stride + color_offset);
+        return (uint32_t {col[0]} << 16) | (uint32_t {col[1]} << 8) | uint32_t {col[2]};
+    };
 
+    order_.resize(count);
     for (auto i = 0u; i < count; ++i) {
-        auto const src = reinterpret_cast<int16_t const*>(p + src_pos_offset);
-        auto const dst = reinterpret_cast<int16_t const*>(p + dst_pos_offset);
-        auto const col = reinterpret_cast<uint8_t const*>(p + color_offset);
+        order_[i] = i;
+    }
 
-        SDL_SetTextureColorMod(tex_handle, col[0], col[1], col[2]);
+    std::stable_sort(std::begin(order_), std::end(order_)
+      , [&](uint32_t const a, uint32_t const b) noexcept {
+            return color_at(a) < color_at(b);
+        });
 
-        render_copy(tile_texture_
-            , SDL_Rect {       src[0],        src[1], src[2], src[3]}
-            , SDL_Rect {xoff + dst[0], yoff + dst[1], src[2], src[3]});
+    for (auto const i : order_) {
+        draw(i);
+    }
+#endif
+}
 
-        p += stride;
+//----------------------------------------------------------------------------------------------
+void bkrl::renderer_sdl_impl::set_tile_color_(color4 const color) {
+    if (std::equal(std::begin(color), std::begin(color) + 3, std::begin(tile_color_))) {
+        return;
+    }
+
+    if (SDL_SetTextureColorMod(tile_texture_.handle(), color[0], color[1], color[2])) {
+        BOOST_THROW_EXCEPTION(bklib::platform_error {}
+          << boost::errinfo_api_function {"SDL_SetTextureColorMod"});
     }
+
+    tile_color_ = color;
 }
 
 //=====----------------------------------------------------------------------------------------=====
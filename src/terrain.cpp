@@ -1,5 +1,6 @@
 #include "terrain.hpp"
 
+#include "bklib/assert.hpp"
 #include "bklib/utility.hpp"
 #include <unordered_map>
 #include <functional>
@@ -133,3 +134,41 @@ bool bkrl::is_door(terrain_entry const& ter, door::state const state) noexcept
 
     return false;
 }
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::is_passable(terrain_entry const& ter) noexcept
+{
+    switch (ter.type) {
+    case terrain_type::stair: BK_FALLTHROUGH
+    case terrain_type::empty: BK_FALLTHROUGH
+    case terrain_type::floor:
+        break;
+    case terrain_type::door:
+        return door {ter}.is_open();
+    case terrain_type::wall: BK_FALLTHROUGH
+    case terrain_type::rock: BK_FALLTHROUGH
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool bkrl::is_opaque(terrain_entry const& ter) noexcept
+{
+    switch (ter.type) {
+    case terrain_type::stair: BK_FALLTHROUGH
+    case terrain_type::empty: BK_FALLTHROUGH
+    case terrain_type::floor:
+        break;
+    case terrain_type::door:
+        return door {ter}.is_closed();
+    case terrain_type::wall: BK_FALLTHROUGH
+    case terrain_type::rock: BK_FALLTHROUGH
+    default:
+        return true;
+    }
+
+    return false;
+}
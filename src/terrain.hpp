@@ -109,6 +109,17 @@ struct door : terrain_data_base {
 //--------------------------------------------------------------------------------------------------
 bool is_door(terrain_entry const& ter, door::state state) noexcept;
 
+//--------------------------------------------------------------------------------------------------
+//! Check whether creatures can generally move through @p ter: empty space, floors, stairs and open
+//! doors.
+//--------------------------------------------------------------------------------------------------
+bool is_passable(terrain_entry const& ter) noexcept;
+
+//--------------------------------------------------------------------------------------------------
+//! Check whether @p ter blocks sight: rock, walls and closed doors.
+//--------------------------------------------------------------------------------------------------
+bool is_opaque(terrain_entry const& ter) noexcept;
+
 //--------------------------------------------------------------------------------------------------
 //! Return a predicate which tests for doors matching state
 //--------------------------------------------------------------------------------------------------
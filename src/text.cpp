@@ -1,6 +1,7 @@
 #include "text.hpp"
 #include "renderer.hpp"
 #include "color.hpp"
+#include "profiler.hpp"
 
 #include "bklib/assert.hpp"
 #include "bklib/scope_guard.hpp"
@@ -232,6 +233,8 @@ void bkrl::text_layout::set_text(
     text_renderer& render
   , bklib::utf8_string_view const text
 ) {
+    BK_PROFILE_ZONE(text_layout);
+
     auto const line_h = render.line_spacing();
     auto const max_x  = (w_ == unlimited) ? std::numeric_limits<size_type>::max() : w_;
     auto const max_y  = (h_ == unlimited) ? std::numeric_limits<size_type>::max() : h_;
@@ -136,6 +136,13 @@ public:
     bklib::point_t<2, double> get_scroll() const noexcept {
         return {scroll_x_, scroll_y_};
     }
+
+    //----------------------------------------------------------------------------------------------
+    int tile_w() const noexcept { return tile_w_; }
+    int tile_h() const noexcept { return tile_h_; }
+
+    int window_w() const noexcept { return window_w_; }
+    int window_h() const noexcept { return window_h_; }
 private:
     int window_w_;
     int window_h_;
@@ -0,0 +1,158 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "activity.hpp"
+#include "map.hpp"
+#include "context.hpp"
+#include "output.hpp"
+#include "bklib/dictionary.hpp"
+
+#include <vector>
+
+TEST_CASE("activity regions", "[activity][bkrl]") {
+    constexpr int size = static_cast<int>(bkrl::size_block);
+
+    bkrl::activity_regions activity;
+
+    using h_t = bkrl::creature_handle;
+
+    std::vector<h_t> woken;
+    auto const wake = [&] {
+        woken.clear();
+        activity.wake([&](h_t const h, bkrl::game_time) { woken.push_back(h); });
+    };
+
+    SECTION("unlimited") {
+        REQUIRE(!activity.is_limited());
+        activity.begin_turn();
+        REQUIRE(activity.is_active(bklib::ipoint2 {-100000, 100000}));
+    }
+
+    SECTION("blocks within the radius of a source are active") {
+        activity.set_radius(1);
+        activity.begin_turn(bklib::ipoint2 {0, 0});
+
+        REQUIRE(activity.is_active(bklib::ipoint2 {0, 0}));
+        REQUIRE(activity.is_active(bklib::ipoint2 {2 * size - 1, -size}));
+        REQUIRE(!activity.is_active(bklib::ipoint2 {2 * size, 0}));
+        REQUIRE(!activity.is_active(bklib::ipoint2 {0, -size - 1}));
+    }
+
+    SECTION("noises are sources for the next turn only") {
+        activity.set_radius(1);
+        bklib::ipoint2 const far {10 * size, 10 * size};
+
+        activity.make_noise(far, 1);
+        REQUIRE(!activity.is_active(far));
+
+        activity.begin_turn(bklib::ipoint2 {0, 0});
+        REQUIRE(activity.is_active(far));
+        REQUIRE(activity.is_active(bklib::ipoint2 {0, 0}));
+
+        activity.begin_turn(bklib::ipoint2 {0, 0});
+        REQUIRE(!activity.is_active(far));
+    }
+
+    SECTION("sleepers wake when their block becomes active") {
+        activity.set_radius(1);
+        activity.begin_turn(bklib::ipoint2 {0, 0});
+
+        activity.sleep(h_t {1}, bklib::ipoint2 {10 * size, 0}, 5);
+        activity.sleep(h_t {2}, bklib::ipoint2 {20 * size, 0}, 5);
+        REQUIRE(activity.dormant_count() == 2);
+
+        wake();
+        REQUIRE(woken.empty());
+
+        activity.begin_turn(bklib::ipoint2 {9 * size, 0});
+        wake();
+        REQUIRE(woken == std::vector<h_t> {h_t {1}});
+        REQUIRE(activity.dormant_count() == 1);
+
+        // everything is active without a limit
+        activity.set_radius(0);
+        wake();
+        REQUIRE(woken == std::vector<h_t> {h_t {2}});
+        REQUIRE(activity.dormant_count() == 0);
+    }
+}
+
+TEST_CASE("map activity", "[activity][map][creature][bkrl]") {
+    bkrl::random_state        random;
+    bkrl::creature_dictionary dic;
+    bkrl::definitions         defs {&dic, nullptr, nullptr};
+    bkrl::creature_factory    cfactory;
+    bkrl::item_factory        ifactory;
+    bkrl::output              out;
+
+    bkrl::creature_def const cdef {"test"};
+    REQUIRE(dic.insert_or_discard(cdef).second);
+
+    bkrl::context ctx {random, defs, out, ifactory, cfactory};
+
+    bkrl::map map;
+    map.set_activity_radius(1);
+
+    bklib::ipoint2 const player_p {10, 10};
+    bklib::ipoint2 const p {200, 200};
+
+    bklib::irect const room {x(p) - 5, y(p) - 5, x(p) + 5, y(p) + 5};
+    map.fill(room, bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+    map.at(player_p).type = bkrl::terrain_type::floor;
+
+    bkrl::creature_def pdef {"player"};
+    pdef.flags.set(bkrl::creature_flag::is_player);
+    map.place_creature_at(cfactory.create(random[bkrl::random_stream::substantive], pdef, player_p)
+      , pdef, player_p);
+
+    auto const placed = generate_creature(ctx, map, cdef, p);
+    REQUIRE(placed);
+
+    auto const h = map.creature_handle_at(placed.where);
+    REQUIRE(map.get_creature(h));
+
+    auto const advance = [&](int const turns) {
+        for (int i = 0; i < turns; ++i) {
+            map.advance(ctx);
+        }
+    };
+
+    // goes to sleep when it first comes up to act, and stays put
+    advance(1);
+    REQUIRE(map.dormant_count() == 1);
+
+    advance(50);
+    REQUIRE(map.get_creature(h)->position() == placed.where);
+
+    SECTION("a noise wakes it for a while") {
+        map.make_noise(p + bklib::ivec2 {static_cast<int>(bkrl::size_block), 0}, 1);
+        advance(1);
+        REQUIRE(map.dormant_count() == 0);
+
+        // having caught up it is somewhere in the room
+        REQUIRE(intersects(map.get_creature(h)->position(), room));
+
+        advance(100);
+        REQUIRE(map.dormant_count() == 1);
+    }
+
+    SECTION("removing the limit wakes it") {
+        map.set_activity_radius(0);
+        advance(1);
+        REQUIRE(map.dormant_count() == 0);
+    }
+
+    SECTION("a removed sleeper is skipped") {
+        map.remove_creature(h);
+        map.set_activity_radius(0);
+        advance(1);
+        REQUIRE(map.dormant_count() == 0);
+    }
+}
+
+#endif // BK_NO_UNIT_TESTS
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <boost/predef.h>
+
+#include <chrono>
+#include <cstdio>
+
+//--------------------------------------------------------------------------------------------------
+//! Helpers for the (hidden) benchmark test cases; run them with --benchmarks.
+//--------------------------------------------------------------------------------------------------
+namespace bench {
+
+//--------------------------------------------------------------------------------------------------
+//! Call @p f @p n times and report the mean time per call in nanoseconds.
+//! @return the mean time per call in nanoseconds.
+//--------------------------------------------------------------------------------------------------
+template <typename Function>
+double run(char const* const name, int const n, Function&& f) {
+    using clock_t = std::chrono::high_resolution_clock;
+
+    auto const start = clock_t::now();
+    for (int i = 0; i < n; ++i) {
+        f(i);
+    }
+    auto const elapsed = clock_t::now() - start;
+
+    auto const ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    auto const result = n > 0 ? ns / n : 0.0;
+    std::printf("%-48s %12.1f ns/op  (%d ops)\n", name, result, n);
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+//! Keep the optimizer from discarding a computed value.
+//--------------------------------------------------------------------------------------------------
+template <typename T>
+inline void do_not_optimize(T const& value) {
+#if BOOST_COMP_GNUC || BOOST_COMP_CLANG
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static char const volatile* sink;
+    sink = reinterpret_cast<char const volatile*>(&value);
+    static_cast<void>(*sink);
+#endif
+}
+
+} //namespace bench
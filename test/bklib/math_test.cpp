@@ -48,6 +48,26 @@ TEST_CASE("clamp", "[bklib][math]") {
     static_assert(bklib::clamp_to<int8_t>(-129) == -128, "");
 }
 
+TEST_CASE("floor_div and grid_key", "[bklib][math]") {
+    static_assert(bklib::floor_div( 0, 16) ==  0, "");
+    static_assert(bklib::floor_div(15, 16) ==  0, "");
+    static_assert(bklib::floor_div(16, 16) ==  1, "");
+    static_assert(bklib::floor_div(-1, 16) == -1, "");
+    static_assert(bklib::floor_div(-16, 16) == -1, "");
+    static_assert(bklib::floor_div(-17, 16) == -2, "");
+
+    for (auto const x : {0, 1, -1, 123456, -123456}) {
+        for (auto const y : {0, 7, -7}) {
+            auto const key = bklib::grid_key(x, y);
+            REQUIRE(bklib::grid_key_x(key) == x);
+            REQUIRE(bklib::grid_key_y(key) == y);
+        }
+    }
+
+    REQUIRE(bklib::grid_key(1, 0) != bklib::grid_key(0, 1));
+    REQUIRE(bklib::grid_key(-1, 0) != bklib::grid_key(0, -1));
+}
+
 TEST_CASE("distance", "[bklib][math]") {
     bklib::ipoint3 const p {0, 0, 0};
     bklib::ipoint3 const q {1, 1, 1};
@@ -0,0 +1,276 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "../benchmark.hpp"
+
+#include "bklib/spatial_map.hpp"
+#include "bklib/math.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+//--------------------------------------------------------------------------------------------------
+//! The previous sorted-vector spatial_map_2d lookup; kept only as a baseline for comparison.
+//--------------------------------------------------------------------------------------------------
+template <typename T>
+class sorted_spatial_map_2d {
+public:
+    using point_t = bklib::ipoint2;
+
+    void insert_unsorted(point_t const p, T&& data) {
+        auto const i = static_cast<int>(data_.size());
+        data_.push_back(std::move(data));
+        sorted_.emplace_back(p, i);
+    }
+
+    void sort() {
+        std::sort(begin(sorted_), end(sorted_), [](auto const& lhs, auto const& rhs) {
+            return lhs.first < rhs.first;
+        });
+    }
+
+    //! As the old spatial_map_2d::relocate: a linear search followed by a full sort unless the
+    //! moved entry happens to still be between its neighbours.
+    bool relocate(point_t const from, point_t const to, T const& data) {
+        auto const last  = end(sorted_);
+        auto const first = begin(sorted_);
+        auto const it = std::find_if(first, last, [&](std::pair<point_t, int> const& pair) {
+            return (pair.first == from) && (&data_[static_cast<size_t>(pair.second)] == &data);
+        });
+
+        if (it == last) {
+            return false;
+        }
+
+        it->first = to;
+
+        if (it != first && std::next(it, -1)->first < to) {
+            auto const next = std::next(it, 1);
+            if (next != last && to < next->first) {
+                return true;
+            }
+        }
+
+        sort();
+
+        return true;
+    }
+
+    T const* at(point_t const& p) const {
+        auto const i = bklib::find_maybe(sorted_, [&](auto const& pair) {
+            return pair.first == p;
+        });
+
+        return i ? &data_[static_cast<size_t>(i->second)] : nullptr;
+    }
+private:
+    std::vector<T>                       data_;
+    std::vector<std::pair<point_t, int>> sorted_;
+};
+
+//--------------------------------------------------------------------------------------------------
+//! @p n distinct points scattered over a square level big enough to hold them at ~25% density.
+//--------------------------------------------------------------------------------------------------
+std::vector<bklib::ipoint2> make_points(int const n, int side);
+
+std::vector<bklib::ipoint2> make_points(int const n) {
+    return make_points(n, static_cast<int>(std::sqrt(n * 4.0)) + 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+//! @p n distinct points scattered over a square level @p side x @p side.
+//--------------------------------------------------------------------------------------------------
+std::vector<bklib::ipoint2> make_points(int const n, int const side) {
+    std::vector<bklib::ipoint2> result;
+    result.reserve(static_cast<size_t>(side * side));
+
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            result.push_back(bklib::ipoint2 {x, y});
+        }
+    }
+
+    std::mt19937 gen {12345};
+    std::shuffle(begin(result), end(result), gen);
+    result.resize(static_cast<size_t>(n));
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+//! One step in a random direction for each of @p points; mirrors a turn of wandering creatures.
+//--------------------------------------------------------------------------------------------------
+std::vector<bklib::ipoint2> make_steps(std::vector<bklib::ipoint2> const& points) {
+    std::mt19937 gen {54321};
+    std::uniform_int_distribution<int> dist {-1, 1};
+
+    std::vector<bklib::ipoint2> result;
+    result.reserve(points.size());
+
+    for (auto const& p : points) {
+        result.push_back(p + bklib::ivec2 {dist(gen), dist(gen)});
+    }
+
+    return result;
+}
+
+} //namespace
+
+TEST_CASE("spatial map point lookup", "[.][benchmark][spatial_map]") {
+    for (auto const n : {100, 10000, 100000}) {
+        auto const points = make_points(n);
+        auto const count  = static_cast<int>(points.size());
+
+        std::printf("--- %d entries\n", n);
+
+        bklib::spatial_map_2d<int> bucketed;
+        bench::run("bucketed insert", count, [&](int const i) {
+            bucketed.insert(points[static_cast<size_t>(i)], int {i});
+        });
+
+        {
+            std::vector<std::pair<bklib::ipoint2, int>> values;
+            values.reserve(points.size());
+            for (int i = 0; i < count; ++i) {
+                values.emplace_back(points[static_cast<size_t>(i)], i);
+            }
+
+            bklib::spatial_map_2d<int> bulk;
+            bench::run("bucketed bulk insert (whole batch)", 1, [&](int) {
+                bulk.bulk_insert(begin(values), end(values));
+            });
+
+            REQUIRE(bulk.size() == points.size());
+        }
+
+        bench::run("bucketed at", count, [&](int const i) {
+            bench::do_not_optimize(bucketed.at(points[static_cast<size_t>(i)]));
+        });
+
+        sorted_spatial_map_2d<int> sorted;
+        for (int i = 0; i < count; ++i) {
+            sorted.insert_unsorted(points[static_cast<size_t>(i)], int {i});
+        }
+        sorted.sort();
+
+        // the linear lookup is far too slow to query every entry at the larger sizes
+        auto const samples = std::min(count, 1000);
+        bench::run("sorted vector at", samples, [&](int const i) {
+            bench::do_not_optimize(sorted.at(points[static_cast<size_t>(i)]));
+        });
+
+        REQUIRE(bucketed.size() == points.size());
+
+        bench::run("bucketed remove", count, [&](int const i) {
+            bench::do_not_optimize(bucketed.remove(points[static_cast<size_t>(i)]));
+        });
+
+        REQUIRE(bucketed.empty());
+    }
+}
+
+TEST_CASE("spatial map relocate", "[.][benchmark][spatial_map]") {
+    constexpr int n = 10000;
+
+    auto const from  = make_points(n);
+    auto const to    = make_steps(from);
+    auto const count = static_cast<int>(from.size());
+
+    std::printf("--- %d entries moved one step each\n", n);
+
+    bklib::spatial_map_2d<int> bucketed;
+    std::vector<int const*> values;
+    values.reserve(from.size());
+
+    for (int i = 0; i < count; ++i) {
+        values.push_back(&bucketed.insert(from[static_cast<size_t>(i)], int {i}));
+    }
+
+    bench::run("bucketed relocate", count, [&](int const i) {
+        auto const j = static_cast<size_t>(i);
+        bench::do_not_optimize(bucketed.relocate(from[j], to[j], *values[j]));
+    });
+
+    for (int i = 0; i < count; ++i) {
+        auto const j = static_cast<size_t>(i);
+        REQUIRE(bucketed.at(to[j]));
+    }
+
+    sorted_spatial_map_2d<int> sorted;
+    for (int i = 0; i < count; ++i) {
+        sorted.insert_unsorted(from[static_cast<size_t>(i)], int {i});
+    }
+    sorted.sort();
+
+    // each sorted relocate is O(n log n) in the worst case; a fraction is enough to compare
+    auto const samples = std::min(count, 1000);
+    bench::run("sorted vector relocate", samples, [&](int const i) {
+        auto const j = static_cast<size_t>(i);
+        bench::do_not_optimize(sorted.relocate(from[j], to[j], *sorted.at(from[j])));
+    });
+}
+
+TEST_CASE("spatial map k-nearest", "[.][benchmark][spatial_map]") {
+    constexpr int queries = 1000;
+    constexpr int side    = 512;
+
+    // ~40% and ~0.4% of the level occupied
+    for (auto const n : {100000, 1000}) {
+        auto const points  = make_points(n, side);
+        auto const targets = make_points(queries, side);
+
+        std::printf("--- %d entries on a %dx%d level\n", n, side, side);
+
+        bklib::spatial_map_2d<int> map;
+        for (int i = 0; i < n; ++i) {
+            map.insert(points[static_cast<size_t>(i)], int {i});
+        }
+
+        auto const& cmap = map;
+
+        for (auto const k : {1u, 8u}) {
+            std::printf("k = %u\n", k);
+
+            bench::run("nearest", queries, [&](int const i) {
+                bench::do_not_optimize(cmap.nearest(targets[static_cast<size_t>(i)], k, side));
+            });
+
+            bench::run("nearest (odd values)", queries, [&](int const i) {
+                bench::do_not_optimize(cmap.nearest(targets[static_cast<size_t>(i)], k, side
+                  , [](bklib::ipoint2, int const v) { return v % 2 != 0; }));
+            });
+
+            bench::run("nearest within 8", queries, [&](int const i) {
+                bench::do_not_optimize(cmap.nearest(targets[static_cast<size_t>(i)], k, 8));
+            });
+        }
+
+        // what map::find_creature style searches cost: every value is visited
+        bench::run("linear scan for nearest", std::min(queries, 100), [&](int const i) {
+            auto const p = targets[static_cast<size_t>(i)];
+            auto best  = std::numeric_limits<int>::max();
+            auto found = static_cast<int const*>(nullptr);
+
+            cmap.for_each_at(bklib::irect {0, 0, side, side}, [&](bklib::ipoint2 const q, int const& v) {
+                auto const d = distance2(p, q);
+                if (d < best) {
+                    best  = d;
+                    found = &v;
+                }
+            });
+
+            bench::do_not_optimize(found);
+        });
+    }
+}
+
+#endif // BK_NO_UNIT_TESTS
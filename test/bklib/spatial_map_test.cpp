@@ -10,6 +10,11 @@
 #include "bklib/math.hpp"
 #include "bklib/utility.hpp"
 
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
 TEST_CASE("simple spatial map test", "[spatial_map]") {
     constexpr int iterations = 10;
 
@@ -143,4 +148,306 @@ TEST_CASE("simple spatial map test", "[spatial_map]") {
     }
 }
 
+TEST_CASE("spatial map block boundaries", "[spatial_map]") {
+    using point_t = bklib::ipoint2;
+
+    bklib::spatial_map_2d<int> map;
+
+    constexpr int n = bklib::spatial_map_2d<int>::block_size;
+
+    // points on either side of the block boundaries, including negative coordinates
+    point_t const points[] {
+        {-1, -1}, {0, 0}, {n - 1, n - 1}, {n, n}, {-n, 0}, {-n - 1, 0}, {0, -n}, {0, -n - 1}
+    };
+
+    int i = 0;
+    for (auto const p : points) {
+        map.insert(p, int {i++});
+    }
+
+    REQUIRE(map.size() == static_cast<size_t>(i));
+
+    i = 0;
+    for (auto const p : points) {
+        auto const ptr = map.at(p);
+        REQUIRE(ptr);
+        REQUIRE(*ptr == i++);
+    }
+
+    SECTION("relocate across blocks") {
+        auto const from = point_t {n - 1, n - 1};
+        auto const to   = point_t {n + 1, n - 1};
+
+        REQUIRE(map.relocate(from, to, *map.at(from)));
+        REQUIRE(!map.at(from));
+        REQUIRE(map.at(to));
+        REQUIRE(*map.at(to) == 2);
+    }
+
+    SECTION("relocate into empty blocks") {
+        auto const a = point_t {-1, -1};       // alone in its block
+        auto const b = point_t {0, 0};         // shares its block with {n - 1, n - 1}
+        auto const c = point_t {-5 * n, 5 * n};
+        auto const d = point_t {5 * n, -5 * n};
+
+        REQUIRE(map.relocate(a, c, *map.at(a)));
+        REQUIRE(map.relocate(b, d, *map.at(b)));
+
+        REQUIRE(!map.at(a));
+        REQUIRE(!map.at(b));
+        REQUIRE(*map.at(c) == 0);
+        REQUIRE(*map.at(d) == 1);
+        REQUIRE(*map.at(point_t {n - 1, n - 1}) == 2);
+        REQUIRE(map.size() == static_cast<size_t>(i));
+    }
+
+    SECTION("remove") {
+        REQUIRE(map.remove(point_t {-1, -1}) == 0);
+        REQUIRE(!map.at(point_t {-1, -1}));
+        REQUIRE(*map.at(point_t {0, -n - 1}) == 7);
+    }
+}
+
+TEST_CASE("spatial map handles", "[spatial_map]") {
+    using point_t = bklib::ipoint2;
+
+    bklib::spatial_map_2d<int> map;
+
+    constexpr int iterations = 100;
+
+    for (int i = 0; i < iterations; ++i) {
+        map.insert(point_t {i, i}, int {i});
+    }
+
+    auto const p0 = point_t {0, 0};
+    auto const p1 = point_t {1, 1};
+
+    auto const h0 = map.handle_at(p0);
+    auto const h1 = map.handle_at(p1);
+
+    REQUIRE(h0);
+    REQUIRE(h1);
+    REQUIRE(h0 != h1);
+    REQUIRE(!map.handle_at(point_t {0, 1}));
+
+    REQUIRE(map.get(h0) == map.at(p0));
+    REQUIRE(map.get(h1) == map.at(p1));
+
+    SECTION("removal leaves other values in place") {
+        auto const before = map.get(h1);
+        REQUIRE(map.remove(h0) == 0);
+
+        REQUIRE(!map.get(h0));
+        REQUIRE(!map.at(p0));
+        REQUIRE(map.get(h1) == before);
+        REQUIRE(map.size() == static_cast<size_t>(iterations - 1));
+    }
+
+    SECTION("reused slots get a new generation") {
+        map.remove(p0);
+        map.insert(p0, int {-1});
+
+        auto const h = map.handle_at(p0);
+        REQUIRE(h);
+        REQUIRE(h != h0);
+        REQUIRE(!map.get(h0));
+        REQUIRE(*map.get(h) == -1);
+    }
+
+    SECTION("relocate by handle") {
+        auto const to = point_t {-100, 50};
+        REQUIRE(map.relocate(h1, to));
+        REQUIRE(!map.at(p1));
+        REQUIRE(map.at(to) == map.get(h1));
+        REQUIRE(map.handle_at(to) == h1);
+    }
+
+    SECTION("remove_if keeps references valid") {
+        std::vector<int const*> before;
+        map.for_each_data([&](int const& i) { before.push_back(&i); });
+
+        map.remove_if(
+            [](point_t, int const i) { return i % 2 == 0; }
+          , [&](point_t const p, int const&) { map.remove(p); }
+        );
+
+        REQUIRE(map.size() == static_cast<size_t>(iterations / 2));
+
+        for (int i = 1; i < iterations; i += 2) {
+            REQUIRE(map.at(point_t {i, i}) == before[static_cast<size_t>(i)]);
+        }
+    }
+}
+
+TEST_CASE("spatial map bulk insert", "[spatial_map]") {
+    using point_t = bklib::ipoint2;
+
+    bklib::spatial_map_2d<int> map;
+
+    constexpr int n = bklib::spatial_map_2d<int>::block_size;
+
+    map.insert(point_t {1, 1}, int {-1});
+
+    std::vector<std::pair<point_t, int>> values;
+    for (int i = 0; i < 200; ++i) {
+        values.emplace_back(point_t {(i * 7) % (5 * n) - 2 * n, i - n}, i);
+    }
+
+    map.bulk_insert(begin(values), end(values));
+
+    REQUIRE(map.size() == values.size() + 1u);
+    REQUIRE(*map.at(point_t {1, 1}) == -1);
+
+    for (auto const& v : values) {
+        auto const ptr = map.at(v.first);
+        REQUIRE(ptr);
+        REQUIRE(*ptr == v.second);
+    }
+
+    auto const p = values[10].first;
+    REQUIRE(map.relocate(p, point_t {100 * n, 0}, *map.at(p)));
+    REQUIRE(map.remove(point_t {100 * n, 0}) == 10);
+    REQUIRE(!map.at(p));
+}
+
+TEST_CASE("spatial map range queries", "[spatial_map]") {
+    using point_t = bklib::ipoint2;
+
+    bklib::spatial_map_2d<point_t> map;
+
+    constexpr int n = bklib::spatial_map_2d<point_t>::block_size;
+
+    std::vector<point_t> points;
+    for (int y = -3 * n; y < 3 * n; y += 3) {
+        for (int x = -3 * n; x < 3 * n; x += 5) {
+            points.push_back(point_t {x, y});
+            map.insert(points.back(), point_t {points.back()});
+        }
+    }
+
+    // the query results compared against a brute force test of every point
+    auto const check = [&](auto&& query, auto&& expected) {
+        std::vector<point_t> result;
+        query([&](point_t const p, point_t const& value) {
+            REQUIRE(p == value);
+            result.push_back(p);
+        });
+
+        std::vector<point_t> brute;
+        std::copy_if(begin(points), end(points), back_inserter(brute), expected);
+
+        auto const less = [](point_t const a, point_t const b) {
+            return x(a) < x(b) || (x(a) == x(b) && y(a) < y(b));
+        };
+
+        std::sort(begin(result), end(result), less);
+        std::sort(begin(brute), end(brute), less);
+
+        REQUIRE(result == brute);
+    };
+
+    auto const& cmap = map;
+
+    SECTION("rect") {
+        for (auto const r : {bklib::irect {-n - 3, -2, n + 7, 5}
+                           , bklib::irect {0, 0, 1, 1}
+                           , bklib::irect {5, 5, 5, 10}
+                           , bklib::irect {-100 * n, -100 * n, 100 * n, 100 * n}}
+        ) {
+            check([&](auto&& f) { cmap.for_each_at(r, f); }
+                , [&](point_t const p) { return intersects(p, r); });
+        }
+    }
+
+    SECTION("chebyshev radius") {
+        for (auto const r : {0, 1, 4, n, 2 * n + 3}) {
+            auto const c = point_t {-5, 7};
+            check([&](auto&& f) { cmap.for_each_in_radius(c, r, f); }
+                , [&](point_t const p) { return abs_max(p - c) <= r; });
+        }
+    }
+
+    SECTION("euclidean radius") {
+        for (auto const r : {0, 1, 4, n, 2 * n + 3}) {
+            auto const c = point_t {3, -6};
+            check([&](auto&& f) { map.for_each_in_circle(c, r, f); }
+                , [&](point_t const p) { return distance2(p, c) <= r * r; });
+        }
+    }
+}
+
+TEST_CASE("spatial map nearest", "[spatial_map]") {
+    using point_t = bklib::ipoint2;
+
+    bklib::spatial_map_2d<point_t> map;
+
+    constexpr int n = bklib::spatial_map_2d<point_t>::block_size;
+
+    // a dense cluster near the origin and a few far away outliers
+    std::vector<point_t> points;
+    for (int y = -2 * n; y < 2 * n; y += 3) {
+        for (int x = -2 * n; x < 2 * n; x += 7) {
+            points.push_back(point_t {x, y});
+        }
+    }
+
+    points.push_back(point_t {40 * n, 3});
+    points.push_back(point_t {-3, -60 * n});
+
+    for (auto const p : points) {
+        map.insert(p, point_t {p});
+    }
+
+    auto const brute_force = [&](point_t const p, size_t const k, int const max_distance, auto&& pred) {
+        std::vector<int> result;
+        for (auto const q : points) {
+            if (distance2(p, q) <= max_distance * max_distance && pred(q)) {
+                result.push_back(distance2(p, q));
+            }
+        }
+
+        std::sort(begin(result), end(result));
+        result.resize(std::min(result.size(), k));
+        return result;
+    };
+
+    auto const distances = [](point_t const p, auto const& values) {
+        std::vector<int> result;
+        for (auto const v : values) {
+            result.push_back(distance2(p, *v));
+        }
+        return result;
+    };
+
+    auto const& cmap = map;
+    auto const any = [](point_t) { return true; };
+    auto const odd = [](point_t const q) { return (x(q) + y(q)) % 2 != 0; };
+
+    for (auto const p : {point_t {0, 0}, point_t {n + 5, -n - 3}, point_t {10 * n, 10 * n}}) {
+        for (auto const k : {1u, 5u, 50u, 1000u}) {
+            for (auto const d : {0, 3, n, 100 * n}) {
+                REQUIRE(distances(p, map.nearest(p, k, d)) == brute_force(p, k, d, any));
+                REQUIRE(distances(p, cmap.nearest(p, k, d, [&](point_t const q, point_t const&) {
+                    return odd(q);
+                })) == brute_force(p, k, d, odd));
+            }
+        }
+    }
+
+    SECTION("far outliers") {
+        auto const p = point_t {39 * n, 0};
+        auto const result = map.nearest(p, 1, std::numeric_limits<int>::max());
+        REQUIRE(result.size() == 1u);
+        REQUIRE(*result[0] == point_t {40 * n, 3});
+
+        REQUIRE(map.nearest(p, points.size() + 1, std::numeric_limits<int>::max()).size() == points.size());
+    }
+
+    SECTION("empty") {
+        bklib::spatial_map_2d<int> empty;
+        REQUIRE(empty.nearest(point_t {0, 0}, 10, 100).empty());
+        REQUIRE(map.nearest(point_t {0, 0}, 0, 100).empty());
+    }
+}
+
 #endif // BK_NO_UNIT_TESTS
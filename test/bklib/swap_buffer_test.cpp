@@ -0,0 +1,77 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "bklib/swap_buffer.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+TEST_CASE("swap_buffer", "[swap_buffer][bklib]") {
+    using namespace std::chrono_literals;
+
+    bklib::swap_buffer<std::vector<int>> buffer;
+
+    SECTION("nothing published") {
+        REQUIRE_FALSE(buffer.acquire());
+        REQUIRE_FALSE(buffer.acquire_for(1ms));
+    }
+
+    SECTION("latest published wins") {
+        buffer.back().assign({1});
+        buffer.publish();
+
+        buffer.back().assign({2});
+        buffer.publish();
+
+        REQUIRE(buffer.acquire());
+        REQUIRE(buffer.front() == std::vector<int> {2});
+        REQUIRE_FALSE(buffer.acquire());
+        REQUIRE(buffer.front() == std::vector<int> {2});
+    }
+
+    SECTION("writer and reader buffers are distinct") {
+        buffer.back().assign({1});
+        buffer.publish();
+        REQUIRE(buffer.acquire());
+
+        buffer.back().assign({2});
+        REQUIRE(buffer.front() == std::vector<int> {1});
+        REQUIRE(&buffer.back() != &buffer.front());
+    }
+
+    SECTION("threads") {
+        constexpr int n = 1000;
+
+        std::thread writer {[&] {
+            for (int i = 1; i <= n; ++i) {
+                buffer.back().assign(16, i);
+                buffer.publish();
+            }
+        }};
+
+        // each acquired buffer was written by a single publish, and they only ever get newer
+        int last = 0;
+        while (last != n) {
+            if (!buffer.acquire_for(10ms)) {
+                continue;
+            }
+
+            auto const& v = buffer.front();
+            REQUIRE(v.size() == 16);
+            REQUIRE(std::count(begin(v), end(v), v.front()) == 16);
+            REQUIRE(v.front() > last);
+
+            last = v.front();
+        }
+
+        writer.join();
+    }
+}
+
+#endif // BK_NO_UNIT_TESTS
@@ -49,6 +49,15 @@ TEST_CASE("timer basic", "[timer][bklib]") {
         REQUIRE(t.size() == 0);
     }
 
+    SECTION("next deadline") {
+        auto const deadline = t.next_deadline();
+        REQUIRE(deadline >= start_time + 0.09s);
+        REQUIRE(deadline <= start_time + 0.1s);
+
+        REQUIRE(t.remove(id0));
+        REQUIRE(t.next_deadline() > deadline);
+    }
+
     SECTION("relative counts") {
         bool do_reset = false;
         t.add(0.6s, [&](auto&) { do_reset = true; });
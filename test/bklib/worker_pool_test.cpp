@@ -0,0 +1,72 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "bklib/worker_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("worker_pool", "[worker_pool][bklib]") {
+    for (size_t const workers : {0u, 1u, 3u}) {
+        bklib::worker_pool pool {workers};
+        REQUIRE(pool.size() == workers);
+
+        // every index is visited once; Catch isn't thread safe, so check afterwards
+        for (size_t const n : {0u, 1u, 7u, 1000u}) {
+            std::vector<int> visits(n);
+            std::atomic<bool> too_big {false};
+
+            pool.for_each_range(n, 7, [&](size_t const first, size_t const last) {
+                if (last - first > 7u) {
+                    too_big = true;
+                }
+
+                for (auto i = first; i < last; ++i) {
+                    ++visits[i];
+                }
+            });
+
+            REQUIRE_FALSE(too_big);
+            REQUIRE(std::all_of(begin(visits), end(visits), [](int const v) { return v == 1; }));
+        }
+
+        // loops run one after another
+        {
+            std::vector<int> values(100);
+            for (int pass = 0; pass < 10; ++pass) {
+                pool.for_each_range(values.size(), 3, [&](size_t const first, size_t const last) {
+                    for (auto i = first; i < last; ++i) {
+                        values[i] += 1;
+                    }
+                });
+            }
+
+            REQUIRE(std::all_of(begin(values), end(values), [](int const v) { return v == 10; }));
+        }
+
+        // exceptions are passed on
+        {
+            auto const f = [&](size_t const first, size_t) {
+                if (first == 50) {
+                    throw std::runtime_error {"test"};
+                }
+            };
+
+            REQUIRE_THROWS_AS(pool.for_each_range(100, 10, f), std::runtime_error);
+
+            // and the pool is still usable
+            int count = 0;
+            pool.for_each_range(1, 1, [&](size_t, size_t) { ++count; });
+            REQUIRE(count == 1);
+        }
+    }
+}
+
+#endif // BK_NO_UNIT_TESTS
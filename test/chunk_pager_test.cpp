@@ -0,0 +1,143 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "chunk_pager.hpp"
+
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+TEST_CASE("chunk pager", "[chunk_pager][bkrl]") {
+    constexpr size_t size  = 64 * 1024;
+    constexpr size_t pages = 4;
+
+    bkrl::chunk_pager pager {"bkxp_chunk_pager_test.tmp", size, size * pages};
+
+    REQUIRE(pager.page_size() >= size);
+    REQUIRE(pager.max_resident() == pages);
+    REQUIRE(pager.resident() == 0u);
+    REQUIRE(!pager.has_page(0));
+
+    auto const fill = [&](uint64_t const key) {
+        auto const data = static_cast<unsigned char*>(pager.map(key));
+
+        // new pages are zero filled
+        REQUIRE(data[0] == 0);
+        REQUIRE(data[size - 1] == 0);
+
+        std::memset(data, static_cast<int>(key + 1), size);
+    };
+
+    SECTION("least recently used pages are reported first") {
+        for (uint64_t key = 0; key < pages + 1; ++key) {
+            fill(key);
+        }
+
+        REQUIRE(pager.over_budget());
+        REQUIRE(pager.lru() == 0u);
+
+        pager.touch(0);
+        REQUIRE(pager.lru() == 1u);
+
+        pager.unmap(1);
+        REQUIRE(!pager.over_budget());
+        REQUIRE(pager.has_page(1));
+        REQUIRE(pager.resident() == pages);
+    }
+
+    SECTION("pinned pages aren't reported") {
+        for (uint64_t key = 0; key < pages + 1; ++key) {
+            fill(key);
+        }
+
+        pager.pin(0);
+        pager.pin(0);
+        REQUIRE(pager.is_pinned(0));
+        REQUIRE(pager.lru() == 1u);
+
+        pager.touch(0);
+        pager.unmap(1);
+        REQUIRE(!pager.over_budget());
+
+        // the last pin makes it the most recently used
+        pager.unpin(0);
+        REQUIRE(pager.lru() == 2u);
+        pager.unpin(0);
+        REQUIRE(!pager.is_pinned(0));
+        REQUIRE(pager.lru() == 2u);
+        REQUIRE(pager.resident() == pages);
+    }
+
+    SECTION("contents survive being unmapped") {
+        constexpr uint64_t count = 3 * pages;
+
+        for (uint64_t key = 0; key < count; ++key) {
+            fill(key);
+            while (pager.over_budget()) {
+                pager.unmap(pager.lru());
+            }
+        }
+
+        REQUIRE(pager.resident() == pages);
+
+        pager.unmap(count - 1);
+
+        for (uint64_t key = 0; key < pages; ++key) {
+            auto const data = static_cast<unsigned char const*>(pager.map(key));
+            REQUIRE(data[0] == key + 1);
+            REQUIRE(data[size - 1] == key + 1);
+
+            while (pager.over_budget()) {
+                pager.unmap(pager.lru());
+            }
+        }
+    }
+}
+
+TEST_CASE("payload pager", "[chunk_pager][bkrl]") {
+    bkrl::payload_pager pager {"bkxp_payload_pager_test.tmp", 1};
+
+    // spans a few pages, whatever their size
+    std::vector<char> big(3 * 64 * 1024 + 5);
+    std::iota(std::begin(big), std::end(big), char {0});
+
+    char const small[] = "small";
+
+    REQUIRE(!pager.has(0));
+
+    pager.append(0, small, sizeof(small));
+    pager.append(1, big.data(), big.size());
+    pager.append(0, big.data(), big.size());
+
+    REQUIRE(pager.has(0));
+    REQUIRE(pager.size() == 2u);
+
+    std::vector<char> out;
+    REQUIRE(!pager.take(2, out));
+    REQUIRE(out.empty());
+
+    REQUIRE(pager.take(1, out));
+    REQUIRE(out == big);
+    REQUIRE(!pager.has(1));
+
+    // reuses the pages of the blob just taken
+    pager.append(2, big.data(), big.size());
+
+    out.clear();
+    REQUIRE(pager.take(0, out));
+    REQUIRE(out.size() == sizeof(small) + big.size());
+    REQUIRE(std::equal(std::begin(small), std::end(small), std::begin(out)));
+    REQUIRE(std::equal(std::begin(big), std::end(big), std::begin(out) + sizeof(small)));
+
+    out.clear();
+    REQUIRE(pager.take(2, out));
+    REQUIRE(out == big);
+    REQUIRE(pager.size() == 0u);
+}
+
+#endif // BK_NO_UNIT_TESTS
@@ -49,6 +49,7 @@ TEST_CASE("command values", "[bkrl][command]") {
         case ct::show_inventory   : BK_CHECK_VAL(show_inventory); break;
         case ct::show_equipment   : BK_CHECK_VAL(show_equipment); break;
         case ct::get              : BK_CHECK_VAL(get); break;
+        case ct::toggle_profiler  : BK_CHECK_VAL(toggle_profiler); break;
         default:
             break;
     }
@@ -0,0 +1,279 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "distance_map.hpp"
+#include "map.hpp"
+#include "random.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+//! The cell stepped to from @p p, following @p field.
+bklib::ipoint2 step_from(bkrl::distance_map const& field, bklib::ipoint2 const p) {
+    return p + field.downhill(p);
+}
+
+//! Whether @p a and @p b have the same distances, and whether the steps of @p a lead downhill.
+bool is_same_field(bkrl::map const& m, bkrl::distance_map const& a, bkrl::distance_map const& b) {
+    auto const r = m.bounds();
+
+    for (int y = r.top; y < r.bottom; ++y) {
+        for (int x = r.left; x < r.right; ++x) {
+            bklib::ipoint2 const p {x, y};
+
+            auto const d = a.distance(p);
+            if (d != b.distance(p)) {
+                return false;
+            }
+
+            auto const v = a.downhill(p);
+            if (abs_max(v) == 0) {
+                if (d != 0 && d != bkrl::distance_map::unreachable) {
+                    return false;
+                }
+
+                continue;
+            }
+
+            auto const cost = (bklib::x(v) && bklib::y(v)) ? bkrl::path_cost_diagonal : bkrl::path_cost_straight;
+            if (!m.is_passable(p + v) || a.distance(p + v) + cost != d) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+} //namespace
+
+TEST_CASE("distance_map", "[distance_map][map][bkrl]") {
+    using bkrl::distance_map;
+
+    bkrl::map m {bklib::irect {0, 0, 20, 20}};
+    m.fill(m.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+    bklib::ipoint2 const goal {10, 10};
+
+    distance_map field;
+    field.add_goal(goal);
+    field.update(m);
+
+    SECTION("distances") {
+        REQUIRE(field.distance(goal) == 0u);
+        REQUIRE(field.distance(bklib::ipoint2 {12, 10}) == 10u);
+        REQUIRE(field.distance(bklib::ipoint2 {12, 12}) == 14u);
+        REQUIRE(field.distance(bklib::ipoint2 {15, 11}) == 27u);
+
+        REQUIRE(field.distance(bklib::ipoint2 {0, 0}) == distance_map::unreachable);
+        REQUIRE(field.distance(bklib::ipoint2 {-5, 3}) == distance_map::unreachable);
+
+        REQUIRE((step_from(field, goal) == goal));
+        REQUIRE((step_from(field, bklib::ipoint2 {12, 12}) == bklib::ipoint2 {11, 11}));
+        REQUIRE((step_from(field, bklib::ipoint2 {0, 0}) == bklib::ipoint2 {0, 0}));
+    }
+
+    SECTION("following the steps") {
+        m.fill(bklib::irect {5, 1, 6, 15}, bkrl::terrain_type::wall);
+        field.update(m);
+
+        bklib::ipoint2 p {2, 2};
+        auto d = field.distance(p);
+        REQUIRE(d != distance_map::unreachable);
+
+        int steps = 0;
+        while (p != goal) {
+            p = step_from(field, p);
+            REQUIRE(m.is_passable(p));
+            REQUIRE(field.distance(p) < d);
+            d = field.distance(p);
+            ++steps;
+        }
+
+        // down past the wall and back up
+        REQUIRE(steps >= 13);
+    }
+
+    SECTION("range") {
+        distance_map near {3};
+        near.add_goal(goal);
+        near.update(m);
+
+        REQUIRE(near.distance(bklib::ipoint2 {13, 10}) == 15u);
+        REQUIRE(near.distance(bklib::ipoint2 {14, 10}) == distance_map::unreachable);
+        REQUIRE((step_from(near, bklib::ipoint2 {14, 10}) == bklib::ipoint2 {14, 10}));
+    }
+
+    SECTION("several goals") {
+        field.add_goal(bklib::ipoint2 {2, 2});
+        field.update(m);
+
+        REQUIRE(field.distance(bklib::ipoint2 {3, 3}) == 7u);
+        REQUIRE(field.distance(bklib::ipoint2 {9, 9}) == 7u);
+        REQUIRE(field.goals().size() == 2u);
+
+        field.remove_goal(goal);
+        field.update(m);
+
+        REQUIRE(field.distance(bklib::ipoint2 {9, 9}) == 49u);
+        REQUIRE((step_from(field, bklib::ipoint2 {9, 9}) == bklib::ipoint2 {8, 8}));
+    }
+
+    SECTION("doors") {
+        m.fill(bklib::irect {15, 0, 16, 20}, bkrl::terrain_type::wall);
+        bklib::ipoint2 const door {15, 5};
+        m.at(door).type = bkrl::terrain_type::door;
+
+        bklib::ipoint2 const beyond {17, 10};
+
+        field.update(m);
+        REQUIRE(field.distance(beyond) == distance_map::unreachable);
+
+        REQUIRE(bkrl::set_door_state(m, door, bkrl::door::state::open));
+        field.update(m);
+        REQUIRE(field.distance(beyond) != distance_map::unreachable);
+
+        // only the cells beyond the door were given a distance
+        REQUIRE(field.changed() <= 4u * 18u + 1u);
+
+        REQUIRE(bkrl::set_door_state(m, door, bkrl::door::state::closed));
+        field.update(m);
+        REQUIRE(field.distance(beyond) == distance_map::unreachable);
+        REQUIRE(field.distance(door) == distance_map::unreachable);
+    }
+
+    SECTION("nothing changed") {
+        field.update(m);
+        REQUIRE(field.changed() == 0u);
+    }
+}
+
+TEST_CASE("distance_map incremental updates", "[distance_map][map][bkrl]") {
+    bkrl::random_t random;
+
+    for (auto const range : {0, 12}) {
+        bklib::irect const r {-21, -7, 43, 50};
+
+        bkrl::map m {r};
+        m.fill(r, bkrl::terrain_type::floor);
+
+        for (int y = r.top; y < r.bottom; ++y) {
+            for (int x = r.left; x < r.right; ++x) {
+                if (bkrl::x_in_y_chance(random, 1, 5)) {
+                    m.at(x, y).type = bkrl::terrain_type::wall;
+                }
+            }
+        }
+
+        auto const random_cell = [&] {
+            for (;;) {
+                auto const p = bkrl::random_point(random, r);
+                if (m.is_passable(p)) {
+                    return p;
+                }
+            }
+        };
+
+        auto player = random_cell();
+
+        bkrl::distance_map field {range};
+        field.add_goal(player);
+        field.update(m);
+
+        std::vector<bklib::ipoint2> items;
+
+        for (int i = 0; i < 200; ++i) {
+            // the player steps to a neighbouring cell
+            bklib::ipoint2 const to {
+                x(player) + bkrl::random_range(random, -1, 1)
+              , y(player) + bkrl::random_range(random, -1, 1)
+            };
+
+            if (intersects(r, to) && m.is_passable(to)) {
+                field.move_goal(player, to);
+                player = to;
+            }
+
+            // walls come and go
+            if (bkrl::x_in_y_chance(random, 1, 2)) {
+                auto const p = bkrl::random_point(random, r);
+                if (p != player) {
+                    auto cell = m.at(p);
+                    cell.type = (cell.type == bkrl::terrain_type::wall)
+                      ? bkrl::terrain_type::floor
+                      : bkrl::terrain_type::wall;
+                }
+            }
+
+            // items are dropped and picked up; not where the player is, as goals are a set
+            if (bkrl::x_in_y_chance(random, 1, 8)) {
+                auto const p = random_cell();
+                if (p != player) {
+                    items.push_back(p);
+                    field.add_goal(p);
+                }
+            } else if (!items.empty() && bkrl::x_in_y_chance(random, 1, 8)) {
+                if (items.back() != player) {
+                    field.remove_goal(items.back());
+                }
+                items.pop_back();
+            }
+
+            field.update(m);
+
+            REQUIRE(std::find(begin(field.goals()), end(field.goals()), player) != end(field.goals()));
+
+            bkrl::distance_map fresh {range};
+            for (auto const p : field.goals()) {
+                fresh.add_goal(p);
+            }
+            fresh.update(m);
+
+            REQUIRE(is_same_field(m, field, fresh));
+        }
+    }
+}
+
+TEST_CASE("distance_map window", "[distance_map][map][bkrl]") {
+    using bkrl::distance_map;
+
+    // far too large for anything a cell of the bounds; untouched terrain is passable
+    constexpr int world = 1 << 20;
+    bkrl::map m {bklib::irect {-world / 2, -world / 2, world / 2, world / 2}};
+
+    bklib::ipoint2 const goal {1000, -1000};
+    auto const east = [](int const n) { return bklib::ivec2 {n, 0}; };
+
+    distance_map field {8};
+    field.add_goal(goal);
+    field.update(m);
+
+    REQUIRE(field.distance(goal + east(8)) == 40u);
+    REQUIRE(field.distance(goal + east(9)) == distance_map::unreachable);
+
+    // a step stays within the window
+    field.move_goal(goal, goal + east(1));
+    field.update(m);
+    REQUIRE(field.distance(goal + east(9)) == 40u);
+
+    // a jump moves it
+    auto const far = goal + east(5000);
+    field.move_goal(goal + east(1), far);
+    field.update(m);
+    REQUIRE(field.distance(far + east(8)) == 40u);
+    REQUIRE(field.distance(goal) == distance_map::unreachable);
+
+    // terrain changes within the window
+    m.at(far + east(3)).type = bkrl::terrain_type::wall;
+    field.update(m);
+    REQUIRE(field.distance(far + east(4)) == 2 * bkrl::path_cost_straight + 2 * bkrl::path_cost_diagonal);
+}
+
+#endif // BK_NO_UNIT_TESTS
@@ -269,7 +269,7 @@ TEST_CASE("get and drop items", "[bkrl][game]") {
 
     SECTION("open / close") {
         auto const make_door_at = [&](bklib::ipoint2 const where, bkrl::door::state const state) {
-            auto& ter =  m.at(where);
+            auto ter =  m.at(where);
             bkrl::door d {};
             d.set_open_close(state);
 
@@ -14,6 +14,9 @@
 
 #include "bklib/algorithm.hpp"
 
+#include <string>
+#include <vector>
+
 //
 // TODO need more tests for edge cases
 //
@@ -101,6 +104,67 @@ TEST_CASE("valid creature_def parser", "[json][bkrl][creature]") {
     REQUIRE(n == 1);
 }
 
+TEST_CASE("creature_def parser speed", "[json][bkrl][creature]") {
+    using bkrl::creature_def;
+
+    bklib::utf8_string_view const json {R"({
+      "file_type": "creatures"
+    , "definitions": [
+        { "id": "fast_id"
+        , "name": "fast_name"
+        , "description": "fast_desc"
+        , "symbol": "f"
+        , "symbol_color": "test_color"
+        , "tags": []
+        , "speed": 150
+        }
+      , { "id": "normal_id"
+        , "name": "normal_name"
+        , "description": "normal_desc"
+        , "symbol": "n"
+        , "symbol_color": "test_color"
+        , "tags": []
+        }
+      ]
+    })"};
+
+    std::vector<int> speeds;
+
+    auto const n = bkrl::load_definitions<creature_def>(json, [&](creature_def const& def) {
+        speeds.push_back(def.speed);
+        return true;
+    });
+
+    REQUIRE(n == 2);
+    REQUIRE(speeds.size() == 2u);
+    REQUIRE(speeds[0] == 150);
+    REQUIRE(speeds[1] == bkrl::speed_normal);
+
+    auto const load_with_speed = [](char const* const speed) {
+        auto const text = std::string {R"({
+          "file_type": "creatures"
+        , "definitions": [
+            { "id": "test_id"
+            , "name": "test_name"
+            , "description": "test_desc"
+            , "symbol": "test_symbol"
+            , "symbol_color": "test_color"
+            , "tags": []
+            , "speed": )"} + speed + R"(
+            }
+          ]
+        })";
+
+        return bkrl::load_definitions<creature_def>(
+            bklib::utf8_string_view {text.data(), text.size()}
+          , [](creature_def const&) { return true; });
+    };
+
+    REQUIRE(load_with_speed("32767") == 1);
+    REQUIRE_THROWS_AS(load_with_speed("0"),     bkrl::json_error);
+    REQUIRE_THROWS_AS(load_with_speed("32768"), bkrl::json_error);
+}
+
 TEST_CASE("valid color_def parser", "[json][bkrl][color]") {
     bklib::utf8_string_view const json {R"({
       "file_type": "colors"
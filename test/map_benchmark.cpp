@@ -0,0 +1,327 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "benchmark.hpp"
+
+#include "context.hpp"
+#include "map.hpp"
+#include "output.hpp"
+#include "renderer.hpp"
+#include "system.hpp"
+#include "view.hpp"
+
+#include "bklib/dictionary.hpp"
+
+#include <cstdio>
+
+namespace {
+
+constexpr int scan_chunks = 4;
+constexpr int scan_size   = scan_chunks * static_cast<int>(bkrl::size_chunk);
+
+//! Walls on every 7th cell of a scan_size x scan_size region.
+template <typename Table>
+void fill_scan_table(Table& table) {
+    for (int y = 0; y < scan_size; ++y) {
+        for (int x = 0; x < scan_size; ++x) {
+            auto&& ter = table.cell_at(x, y);
+            ter.type    = ((x + y * scan_size) % 7) ? bkrl::terrain_type::floor : bkrl::terrain_type::wall;
+            ter.variant = static_cast<uint16_t>(x % 3);
+        }
+    }
+}
+
+int count_walls(bkrl::block_t<bkrl::terrain_entry> const& block) noexcept {
+    int n = 0;
+    for (auto const& ter : block.data) {
+        n += (ter.type == bkrl::terrain_type::wall) ? 1 : 0;
+    }
+    return n;
+}
+
+int count_walls(bkrl::terrain_block_t const& block) noexcept {
+    int n = 0;
+    for (auto const type : block.type) {
+        n += (type == bkrl::terrain_type::wall) ? 1 : 0;
+    }
+    return n;
+}
+
+//! Where to put the @p i th of @p count creatures to spread them evenly over the inside of a
+//! @p size x @p size map walled around its edge.
+bklib::ipoint2 spread_position(int const i, int const count, int const size) noexcept {
+    auto const inside = size - 2;
+    auto const j = static_cast<int>(int64_t {i} * inside * inside / count);
+    return bklib::ipoint2 {1 + j % inside, 1 + j / inside};
+}
+
+//! Look at only the type of every cell, a block at a time.
+template <typename Table>
+int scan_types(Table const& table) {
+    int n = 0;
+    table.for_each_chunk([&](auto const& chunk, int, int) {
+        for (auto i = 0u; i < chunk.block_count; ++i) {
+            n += count_walls(chunk.data[i]);
+        }
+    });
+    return n;
+}
+
+//! Look at whole entries via for_each_cell.
+template <typename Table>
+int scan_entries(Table const& table) {
+    int n = 0;
+    table.for_each_chunk([&](auto const& chunk, int const x0, int const y0) {
+        bkrl::for_each_cell(chunk, x0, y0, [&](int, int, bkrl::terrain_entry const& ter) {
+            n += (ter.type == bkrl::terrain_type::wall) ? ter.variant + 1 : 0;
+        });
+    });
+    return n;
+}
+
+//! Look at the type of every cell one lookup at a time, as map::at does.
+template <typename Table>
+int scan_cells(Table const& table) {
+    int n = 0;
+    for (int y = 0; y < scan_size; ++y) {
+        for (int x = 0; x < scan_size; ++x) {
+            n += (table.cell_at(x, y).type == bkrl::terrain_type::wall) ? 1 : 0;
+        }
+    }
+    return n;
+}
+
+} // namespace
+
+TEST_CASE("terrain whole map scan", "[.][benchmark][map][terrain]") {
+    using aos_table = bkrl::chunk_table_t<bkrl::terrain_entry>;
+    using soa_table = bkrl::chunk_table_t<bkrl::terrain_entry, bkrl::terrain_block_t>;
+
+    aos_table aos;
+    soa_table soa;
+
+    fill_scan_table(aos);
+    fill_scan_table(soa);
+
+    REQUIRE(scan_types(aos) == scan_types(soa));
+    REQUIRE(scan_entries(aos) == scan_entries(soa));
+    REQUIRE(scan_cells(aos) == scan_cells(soa));
+
+    constexpr int n = 50;
+
+    bench::run("terrain type scan (AoS)", n, [&](int) {
+        bench::do_not_optimize(scan_types(aos));
+    });
+
+    bench::run("terrain type scan (SoA)", n, [&](int) {
+        bench::do_not_optimize(scan_types(soa));
+    });
+
+    bench::run("terrain entry scan (AoS)", n, [&](int) {
+        bench::do_not_optimize(scan_entries(aos));
+    });
+
+    bench::run("terrain entry scan (SoA)", n, [&](int) {
+        bench::do_not_optimize(scan_entries(soa));
+    });
+
+    bench::run("terrain cell_at scan (AoS)", n, [&](int) {
+        bench::do_not_optimize(scan_cells(aos));
+    });
+
+    bench::run("terrain cell_at scan (SoA)", n, [&](int) {
+        bench::do_not_optimize(scan_cells(soa));
+    });
+}
+
+//! Time whole frames of terrain at the min, default and max zoom; uses whatever renderer
+//! make_renderer gives, so a real window unless built with BK_NO_SDL.
+TEST_CASE("map draw frame", "[.][benchmark][map][render]") {
+    constexpr int window_w = 1024;
+    constexpr int window_h = 768;
+    constexpr int tile_size = 18;
+    constexpr int size = 4 * static_cast<int>(bkrl::size_chunk);
+
+    auto const sys    = bkrl::make_system();
+    auto const render = bkrl::make_renderer(*sys);
+
+    bkrl::map map {bklib::irect {0, 0, size, size}};
+    map.fill(map.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+    map.update_render_data();
+
+    auto const frame = [&](bkrl::view const& v) {
+        auto const scale = v.get_zoom();
+        auto const trans = v.get_scroll();
+
+        render->clear();
+        render->clear_clip_region();
+        render->set_scale(x(scale), y(scale));
+        render->set_translation(x(trans), y(trans));
+
+        map.draw(*render, v);
+
+        render->present();
+    };
+
+    constexpr int n = 100;
+
+    for (auto const zoom : {bkrl::view::zoom_min, 1.0, bkrl::view::zoom_max}) {
+        bkrl::view v {window_w, window_h, tile_size, tile_size};
+        v.zoom_to(zoom);
+        v.center_on_world(size / 2, size / 2);
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "map draw frame (zoom %.2f)", zoom);
+
+        bench::run(name, n, [&](int) { frame(v); });
+    }
+}
+
+//! Time turns of a map crowded with wandering creatures; with the scheduler the cost of a turn
+//! follows the number of creatures acting in it, so slower creatures make for cheaper turns.
+TEST_CASE("map turn", "[.][benchmark][map][creature]") {
+    constexpr int size  = 2 * static_cast<int>(bkrl::size_chunk);
+    constexpr int count = 10000;
+
+    for (auto const speed : {int16_t {200}, bkrl::speed_normal, int16_t {25}}) {
+        bkrl::random_state        random;
+        bkrl::creature_dictionary dic;
+        bkrl::definitions         defs {&dic, nullptr, nullptr};
+        bkrl::creature_factory    cfactory;
+        bkrl::item_factory        ifactory;
+        bkrl::output              out;
+        bkrl::context             ctx {random, defs, out, ifactory, cfactory};
+
+        bkrl::creature_def cdef {"test"};
+        cdef.speed = speed;
+        cdef.stat_hp = bkrl::make_random_integer("30000"); // crowded; don't die of the fighting
+        dic.insert_or_discard(cdef);
+
+        bkrl::map map {bklib::irect {0, 0, size, size}};
+        map.fill(map.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+        for (int i = 0; i < count; ++i) {
+            bkrl::generate_creature(ctx, map, cdef, spread_position(i, count, size));
+        }
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "map turn (%d creatures, speed %d)", count, speed);
+
+        bench::run(name, 100, [&](int) { map.advance(ctx); });
+    }
+}
+
+//! As above at normal speed, with deciding on actions split between a number of worker threads.
+TEST_CASE("map turn in parallel", "[.][benchmark][map][creature]") {
+    constexpr int size  = 2 * static_cast<int>(bkrl::size_chunk);
+    constexpr int count = 10000;
+
+    for (auto const workers : {size_t {0}, size_t {1}, size_t {3}}) {
+        bkrl::random_state        random;
+        bkrl::creature_dictionary dic;
+        bkrl::definitions         defs {&dic, nullptr, nullptr};
+        bkrl::creature_factory    cfactory;
+        bkrl::item_factory        ifactory;
+        bkrl::output              out;
+        bkrl::context             ctx {random, defs, out, ifactory, cfactory};
+
+        bkrl::creature_def cdef {"test"};
+        cdef.stat_hp = bkrl::make_random_integer("30000"); // crowded; don't die of the fighting
+        dic.insert_or_discard(cdef);
+
+        bkrl::map map {bklib::irect {0, 0, size, size}};
+        map.fill(map.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+        map.set_worker_count(workers);
+
+        for (int i = 0; i < count; ++i) {
+            bkrl::generate_creature(ctx, map, cdef, spread_position(i, count, size));
+        }
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "map turn (%d creatures, %zu workers)", count, workers);
+
+        bench::run(name, 100, [&](int) { map.advance(ctx); });
+    }
+}
+
+//! Time turns of a large map with a great many creatures, all active and with only those near the
+//! player active; with the player moving a block a turn, each turn also wakes a strip of blocks.
+TEST_CASE("map turn with activity regions", "[.][benchmark][map][creature]") {
+    constexpr int size   = 8 * static_cast<int>(bkrl::size_chunk);
+    constexpr int count  = 50000;
+    constexpr int radius = 4;
+
+    struct config_t {
+        char const* name;
+        int         radius;
+        bool        moving;
+    };
+
+    config_t const configs[] {
+        {"all active",              0,      false}
+      , {"near the player active",  radius, false}
+      , {"near the player, moving", radius, true}
+    };
+
+    for (auto const& config : configs) {
+        bkrl::random_state        random;
+        bkrl::creature_dictionary dic;
+        bkrl::definitions         defs {&dic, nullptr, nullptr};
+        bkrl::creature_factory    cfactory;
+        bkrl::item_factory        ifactory;
+        bkrl::output              out;
+        bkrl::context             ctx {random, defs, out, ifactory, cfactory};
+
+        bkrl::creature_def cdef {"test"};
+        cdef.stat_hp = bkrl::make_random_integer("30000"); // don't die of the fighting
+        dic.insert_or_discard(cdef);
+
+        bkrl::map map {bklib::irect {0, 0, size, size}};
+        map.fill(map.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+        map.set_activity_radius(config.radius);
+
+        bkrl::creature_def pdef {"player"};
+        pdef.flags.set(bkrl::creature_flag::is_player);
+        pdef.stat_hp = cdef.stat_hp;
+
+        bklib::ipoint2 const start {size / 2, size / 2};
+        map.place_creature_at(cfactory.create(random[bkrl::random_stream::substantive], pdef, start)
+          , pdef, start);
+        auto const player = map.creature_handle_at(start);
+
+        map.begin_batch();
+        for (int i = 0; i < count; ++i) {
+            bkrl::generate_creature(ctx, map, cdef, spread_position(i, count, size));
+        }
+        map.end_batch();
+
+        // let everything far away fall asleep first
+        for (int i = 0; i < 10; ++i) {
+            map.advance(ctx);
+        }
+
+        char name[96];
+        std::snprintf(name, sizeof(name), "map turn (%d creatures, %s)", count, config.name);
+
+        bench::run(name, 100, [&](int const i) {
+            if (config.moving) {
+                auto const x = 1 + (i * static_cast<int>(bkrl::size_block)) % (size - 2);
+                auto const to = bklib::ipoint2 {x, size / 2};
+                if (!map.creature_at(to)) {
+                    map.move_creature_to(player, to);
+                }
+            }
+
+            map.advance(ctx);
+        });
+
+        std::printf("  %zu creatures dormant\n", map.dormant_count());
+    }
+}
+
+#endif // BK_NO_UNIT_TESTS
@@ -51,6 +51,216 @@ TEST_CASE("map terrain", "[map][terrain][bkrl]") {
     }
 }
 
+TEST_CASE("terrain_block_t", "[map][terrain][bkrl]") {
+    bkrl::terrain_block_t block {};
+
+    auto ref = block.cell_at(3, 5);
+    ref.type    = bkrl::terrain_type::wall;
+    ref.variant = 2;
+
+    SECTION("fields are written to their planes") {
+        auto const i = 5 * bkrl::size_block + 3;
+        REQUIRE(block.type[i] == bkrl::terrain_type::wall);
+        REQUIRE(block.variant[i] == 2);
+        REQUIRE(block.data[i] == 0);
+
+        auto const& cblock = block;
+        auto const ter = cblock.cell_at(3, 5);
+        REQUIRE(ter.type == bkrl::terrain_type::wall);
+        REQUIRE(ter.variant == 2);
+    }
+
+    SECTION("assigning an entry assigns every field") {
+        block.cell_at(0, 0) = bkrl::terrain_entry {7, bkrl::terrain_flags::none, bkrl::terrain_type::door, 1};
+        block.cell_at(1, 0) = block.cell_at(0, 0);
+
+        bkrl::terrain_entry const ter = block.cell_at(1, 0);
+        REQUIRE(ter.data == 7);
+        REQUIRE(ter.type == bkrl::terrain_type::door);
+        REQUIRE(ter.variant == 1);
+
+        REQUIRE(block.cell_at(3, 5).type == bkrl::terrain_type::wall);
+    }
+
+    SECTION("assigning terrain data assigns only the data") {
+        bkrl::door d;
+        d.open();
+        ref = d;
+
+        REQUIRE(ref.type == bkrl::terrain_type::wall);
+        REQUIRE(bkrl::door {ref}.is_open());
+    }
+}
+
+TEST_CASE("map passability and opacity", "[map][terrain][bkrl]") {
+    bkrl::map map;
+
+    auto const r = bklib::irect {2, 2, bkrl::size_block + 4, 8};
+    map.fill(r, bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+    auto const inside = bklib::ipoint2 {4, 4};
+    auto const border = bklib::ipoint2 {2, 4};
+    auto const far    = bklib::ipoint2 {-100, 1000};
+
+    REQUIRE(map.is_passable(inside));
+    REQUIRE(!map.is_opaque(inside));
+    REQUIRE(!map.is_passable(border));
+    REQUIRE(map.is_opaque(border));
+    REQUIRE(map.is_passable(far));
+    REQUIRE(!map.is_opaque(far));
+
+    SECTION("doors") {
+        map.at(border).type = bkrl::terrain_type::door;
+        REQUIRE(!map.is_passable(border));
+        REQUIRE(map.is_opaque(border));
+
+        REQUIRE(bkrl::set_door_state(map, border, bkrl::door::state::open));
+        REQUIRE(map.is_passable(border));
+        REQUIRE(!map.is_opaque(border));
+
+        REQUIRE(bkrl::set_door_state(map, border, bkrl::door::state::closed));
+        REQUIRE(!map.is_passable(border));
+    }
+
+    SECTION("masks agree with the terrain") {
+        for (int y = r.top - 1; y <= r.bottom; ++y) {
+            for (int x = r.left - 1; x <= r.right; ++x) {
+                auto const p = bklib::ipoint2 {x, y};
+                auto const ter = static_cast<bkrl::map const&>(map).at(p);
+                REQUIRE(map.is_passable(p) == bkrl::is_passable(ter));
+                REQUIRE(map.is_opaque(p) == bkrl::is_opaque(ter));
+            }
+        }
+    }
+}
+
+TEST_CASE("map terrain revision", "[map][terrain][bkrl]") {
+    bkrl::map map;
+    map.fill(map.bounds(), bkrl::terrain_type::floor);
+
+    auto const door = bklib::ipoint2 {3, 3};
+    map.at(door).type = bkrl::terrain_type::door;
+
+    auto const revision = map.terrain_revision();
+
+    // reads through a mutable map aren't writes
+    REQUIRE(bkrl::find_around(map, door, [](bkrl::terrain_entry const& ter) {
+        return ter.type == bkrl::terrain_type::door;
+    }));
+
+    bkrl::terrain_entry const ter = map.at(door);
+    REQUIRE(ter.type == bkrl::terrain_type::door);
+
+    // nor are writes that fail
+    REQUIRE(!bkrl::set_door_state(map, door, bkrl::door::state::closed));
+    REQUIRE(map.terrain_revision() == revision);
+
+    REQUIRE(bkrl::set_door_state(map, door, bkrl::door::state::open));
+    REQUIRE(map.terrain_revision() != revision);
+}
+
+TEST_CASE("map chunks", "[map][terrain][bkrl]") {
+    constexpr int size  = static_cast<int>(bkrl::size_chunk);
+    constexpr int world = 1000000;
+
+    bkrl::map map {bklib::irect {-world / 2, -world / 2, world / 2, world / 2}};
+    auto const& cmap = map;
+
+    REQUIRE(map.chunk_count() == 0u);
+
+    // reading untouched terrain doesn't allocate anything
+    REQUIRE(cmap.at(world / 3, -world / 3).type == bkrl::terrain_type::empty);
+    REQUIRE(map.chunk_count() == 0u);
+
+    SECTION("fill across chunk boundaries") {
+        auto const r = bklib::irect {-3, -size - 3, 5, -size + 4};
+        map.fill(r, bkrl::terrain_type::floor);
+
+        REQUIRE(map.chunk_count() == 4u);
+
+        for (int y = r.top - 1; y < r.bottom + 1; ++y) {
+            for (int x = r.left - 1; x < r.right + 1; ++x) {
+                auto const p = bklib::ipoint2 {x, y};
+                auto const expected = intersects(r, p)
+                  ? bkrl::terrain_type::floor : bkrl::terrain_type::empty;
+
+                REQUIRE(cmap.at(p).type == expected);
+            }
+        }
+    }
+
+    SECTION("far apart cells") {
+        bklib::ipoint2 const points[] {
+            {0, 0}, {world / 2 - 1, world / 2 - 1}, {-world / 2, -world / 2}, {-world / 2, 12345}
+        };
+
+        for (auto const p : points) {
+            map.at(p).type = bkrl::terrain_type::wall;
+        }
+
+        REQUIRE(map.chunk_count() == 4u);
+
+        for (auto const p : points) {
+            REQUIRE(cmap.at(p).type == bkrl::terrain_type::wall);
+            REQUIRE(cmap.at(p + bklib::ivec2 {1, 0}).type == bkrl::terrain_type::empty);
+        }
+
+        map.update_render_data();
+    }
+
+    SECTION("paging") {
+        constexpr size_t chunk_bytes = sizeof(bkrl::block_t<bkrl::terrain_entry>) * size;
+        map.enable_paging("bkxp_map_test.tmp", 3 * chunk_bytes * 3 / 2);
+
+        constexpr int count = 20;
+
+        for (int i = 0; i < count; ++i) {
+            auto ter = map.at(i * size, -i * size);
+            ter.type    = bkrl::terrain_type::floor;
+            ter.variant = static_cast<uint16_t>(i);
+
+            REQUIRE(map.chunk_count() <= 3u);
+        }
+
+        map.update_render_data();
+
+        for (int i = count; i-- > 0; ) {
+            auto const& ter = cmap.at(i * size, -i * size);
+            REQUIRE(ter.type == bkrl::terrain_type::floor);
+            REQUIRE(ter.variant == i);
+            REQUIRE(map.chunk_count() <= 3u);
+        }
+
+        // never written
+        REQUIRE(cmap.at(-size, size).type == bkrl::terrain_type::empty);
+    }
+
+    SECTION("references keep their chunk in memory") {
+        // a single chunk of each
+        map.enable_paging("bkxp_map_test.tmp", 1);
+
+        map.at(0, 0).type = bkrl::terrain_type::wall;
+        map.at(size, 0) = map.at(0, 0);
+        REQUIRE(cmap.at(size, 0).type == bkrl::terrain_type::wall);
+
+        {
+            auto ter = map.at(0, 0);
+            map.at(2 * size, 0).type = bkrl::terrain_type::floor;
+            REQUIRE(map.chunk_count() == 2u);
+
+            ter.type = bkrl::terrain_type::door;
+        }
+
+        // back within budget once nothing is pinned
+        map.at(3 * size, 0).type = bkrl::terrain_type::floor;
+        REQUIRE(map.chunk_count() == 1u);
+
+        REQUIRE(cmap.at(0, 0).type == bkrl::terrain_type::door);
+        REQUIRE(!map.is_passable(bklib::ipoint2 {0, 0}));
+        REQUIRE(cmap.at(2 * size, 0).type == bkrl::terrain_type::floor);
+    }
+}
+
 TEST_CASE("map creatures", "[map][creature][bkrl]") {
     bkrl::random_state        random;
     bkrl::creature_dictionary dic;
@@ -93,6 +303,238 @@ TEST_CASE("map creatures", "[map][creature][bkrl]") {
         REQUIRE(!map.creature_at(p));
     }
 
+    SECTION("creature handles") {
+        auto const q = p + bklib::ivec2 {3, 0};
+        map.at(p).type = bkrl::terrain_type::floor;
+        map.at(q).type = bkrl::terrain_type::floor;
+
+        REQUIRE(!map.creature_handle_at(p));
+        REQUIRE(generate_creature(ctx, map, cdef, p));
+
+        auto const h = map.creature_handle_at(p);
+        REQUIRE(h);
+        REQUIRE(map.get_creature(h) == map.creature_at(p));
+
+        map.move_creature_to(h, q);
+        REQUIRE(!map.creature_at(p));
+        REQUIRE(map.get_creature(h) == map.creature_at(q));
+        REQUIRE(map.get_creature(h)->position() == q);
+
+        auto const c = map.remove_creature(h);
+        REQUIRE(c.position() == q);
+        REQUIRE(!map.get_creature(h));
+        REQUIRE(!map.creature_at(q));
+    }
+
+    SECTION("range queries") {
+        bklib::ipoint2 const points[] {p, p + bklib::ivec2 {3, 0}, p + bklib::ivec2 {3, 3}};
+        for (auto const q : points) {
+            map.at(q).type = bkrl::terrain_type::floor;
+            REQUIRE(generate_creature(ctx, map, cdef, q));
+        }
+
+        auto const count = [](auto&& query) {
+            int n = 0;
+            query([&](bkrl::creature const&) { ++n; });
+            return n;
+        };
+
+        auto const& cmap = map;
+
+        REQUIRE(count([&](auto&& f) { cmap.for_each_creature_in(bklib::irect {x(p), y(p), x(p) + 4, y(p) + 1}, f); }) == 2);
+        REQUIRE(count([&](auto&& f) { cmap.for_each_creature_in_radius(p, 2, f); }) == 1);
+        REQUIRE(count([&](auto&& f) { cmap.for_each_creature_in_radius(p, 3, f); }) == 3);
+        REQUIRE(count([&](auto&& f) { cmap.for_each_creature_in_circle(p, 3, f); }) == 2);
+        REQUIRE(count([&](auto&& f) { cmap.for_each_creature_in_circle(p, 5, f); }) == 3);
+    }
+
+    SECTION("turns") {
+        bklib::irect const room {x(p) - 5, y(p) - 5, x(p) + 5, y(p) + 5};
+        map.fill(room, bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+        REQUIRE(generate_creature(ctx, map, cdef, p));
+
+        auto const removed = generate_creature(ctx, map, cdef, p);
+        REQUIRE(removed);
+
+        // a removed creature's stale entry is skipped
+        map.remove_creature_at(removed.where);
+
+        constexpr int turns = 30;
+        for (int i = 0; i < turns; ++i) {
+            map.advance(ctx);
+        }
+
+        REQUIRE(map.now() == turns * bkrl::ticks_per_turn);
+
+        auto const c = map.find_creature([](bkrl::creature const&) { return true; });
+        REQUIRE(c);
+        REQUIRE(intersects(c->position(), room));
+    }
+
+    SECTION("chasing the player") {
+        // a wall between the player and the creature, but for a gap at the bottom
+        bklib::irect const room {0, 0, 30, 20};
+        map.fill(room, bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+        map.fill(bklib::irect {15, 1, 16, 10}, bkrl::terrain_type::wall);
+
+        bkrl::creature_def player_def {"player"};
+        player_def.flags.set(bkrl::creature_flag::is_player);
+        player_def.stat_hp = bkrl::make_random_integer("100");
+        dic.insert_or_discard(player_def);
+
+        bkrl::creature_def chaser {"chaser"};
+        chaser.flags.set(bkrl::creature_flag::is_aggressive);
+        dic.insert_or_discard(chaser);
+
+        auto& gen = random[bkrl::random_stream::creature];
+
+        bklib::ipoint2 const target {5, 3};
+        bklib::ipoint2 const start  {20, 3};
+        map.place_creature_at(cfactory.create(gen, player_def, target), player_def, target);
+        map.place_creature_at(cfactory.create(gen, chaser, start), chaser, start);
+
+        auto const& player = *map.creature_at(target);
+        auto const  hp     = player.current(bkrl::stat_type::health);
+
+        // down through the gap and back up, then attack
+        int turns = 0;
+        while (player.current(bkrl::stat_type::health) == hp && turns < 40) {
+            map.advance(ctx);
+            ++turns;
+        }
+
+        REQUIRE(player.current(bkrl::stat_type::health) < hp);
+        REQUIRE(turns >= 14);
+        REQUIRE(map.player_distances().distance(start) != bkrl::distance_map::unreachable);
+    }
+
+    SECTION("killing the player") {
+        map.fill(bklib::irect {0, 0, 10, 10}, bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+        bkrl::creature_def player_def {"player"};
+        player_def.flags.set(bkrl::creature_flag::is_player);
+        player_def.stat_hp = bkrl::make_random_integer("1");
+        dic.insert_or_discard(player_def);
+
+        bkrl::creature_def chaser {"chaser"};
+        chaser.flags.set(bkrl::creature_flag::is_aggressive);
+        dic.insert_or_discard(chaser);
+
+        auto& gen = random[bkrl::random_stream::creature];
+
+        bklib::ipoint2 const target {3, 3};
+        bklib::ipoint2 const start  {6, 3};
+        map.place_creature_at(cfactory.create(gen, player_def, target), player_def, target);
+        map.place_creature_at(cfactory.create(gen, chaser, start), chaser, start);
+
+        auto const find_player = [&] {
+            return map.find_creature([](bkrl::creature const& c) { return c.is_player(); });
+        };
+
+        int turns = 0;
+        while (!find_player()->is_dead() && turns < 20) {
+            map.advance(ctx);
+            ++turns;
+        }
+
+        // the dead player stays put, and isn't attacked again
+        auto const player = find_player();
+        REQUIRE(player);
+        REQUIRE(player->is_dead());
+        REQUIRE(player->position() == target);
+
+        auto const hp = player->current(bkrl::stat_type::health);
+        for (int i = 0; i < 5; ++i) {
+            map.advance(ctx);
+        }
+
+        REQUIRE(find_player() == player);
+        REQUIRE(player->current(bkrl::stat_type::health) == hp);
+    }
+
+    SECTION("applying actions") {
+        using type = bkrl::creature_action::type;
+
+        bkrl::creature_def def {"sturdy"};
+        def.stat_hp = bkrl::make_random_integer("100");
+        dic.insert_or_discard(def);
+
+        // a corridor p, p + 1, q; the creatures are placed at either end
+        auto const q = p + bklib::ivec2 {2, 0};
+
+        map.at(p).type = bkrl::terrain_type::floor;
+        REQUIRE(generate_creature(ctx, map, def, p) == p);
+
+        map.at(q).type = bkrl::terrain_type::floor;
+        REQUIRE(generate_creature(ctx, map, def, q) == q);
+
+        map.at(p + bklib::ivec2 {1, 0}).type = bkrl::terrain_type::floor;
+
+        auto& a = *map.creature_at(p);
+        auto& b = *map.creature_at(q);
+
+        // both decided to move into the spot between them; the first applied gets it
+        bkrl::creature_action const move_right {type::move, bklib::ivec2 {1, 0}, 10};
+        bkrl::creature_action const move_left  {type::move, bklib::ivec2 {-1, 0}, 20};
+
+        REQUIRE(bkrl::apply(ctx, map, a, move_right) == 10);
+        REQUIRE(bkrl::apply(ctx, map, b, move_left) == 20);
+
+        REQUIRE(a.position() == p + bklib::ivec2 {1, 0});
+        REQUIRE(b.position() == q);
+
+        // an attack on a spot that has since been vacated misses
+        auto const hp = a.current(bkrl::stat_type::health);
+
+        bkrl::creature_action const attack_left {type::attack, bklib::ivec2 {-1, 0}, 10};
+        bkrl::apply(ctx, map, b, attack_left);
+        REQUIRE(a.current(bkrl::stat_type::health) == hp - 1);
+
+        bkrl::apply(ctx, map, a, bkrl::creature_action {type::move, bklib::ivec2 {0, 1}, 10});
+        bkrl::apply(ctx, map, b, attack_left);
+        REQUIRE(a.current(bkrl::stat_type::health) == hp - 1);
+
+        // a step into a free spot moves; into a taken one, attacks
+        bkrl::apply(ctx, map, b, bkrl::creature_action {type::step, bklib::ivec2 {-1, 0}, 10});
+        REQUIRE(b.position() == p + bklib::ivec2 {1, 0});
+
+        bkrl::creature_action const step_down {type::step, bklib::ivec2 {0, 1}, 10};
+        bkrl::apply(ctx, map, b, step_down);
+        REQUIRE(b.position() == p + bklib::ivec2 {1, 0});
+        REQUIRE(a.current(bkrl::stat_type::health) == hp - 2);
+
+        // a chase waits for anyone in the way other than the player
+        bkrl::apply(ctx, map, b, bkrl::creature_action {type::chase, bklib::ivec2 {0, 1}, 10});
+        REQUIRE(b.position() == p + bklib::ivec2 {1, 0});
+        REQUIRE(a.current(bkrl::stat_type::health) == hp - 2);
+    }
+
+    SECTION("nearest creatures") {
+        bklib::ipoint2 const points[] {p + bklib::ivec2 {4, 4}, p + bklib::ivec2 {-3, 0}, p};
+        for (auto const q : points) {
+            map.at(q).type = bkrl::terrain_type::floor;
+            REQUIRE(generate_creature(ctx, map, cdef, q));
+        }
+
+        auto const& cmap = map;
+
+        auto const all = cmap.nearest_creatures(p, 10, 100);
+        REQUIRE(all.size() == 3u);
+        REQUIRE(all[0]->position() == points[2]);
+        REQUIRE(all[1]->position() == points[1]);
+        REQUIRE(all[2]->position() == points[0]);
+
+        REQUIRE(map.nearest_creatures(p, 10, 3).size() == 2u);
+
+        auto const others = map.nearest_creatures(p, 1, 100, [&](bkrl::creature const& c) {
+            return c.position() != p;
+        });
+
+        REQUIRE(others.size() == 1u);
+        REQUIRE(others[0]->position() == points[1]);
+    }
+
     SECTION("generate at same location") {
         map.at(p).type = bkrl::terrain_type::floor;
 
@@ -122,6 +564,77 @@ TEST_CASE("map creatures", "[map][creature][bkrl]") {
     }
 }
 
+TEST_CASE("map turns in parallel", "[map][creature][bkrl]") {
+    struct result_t {
+        uint32_t       id;
+        bklib::ipoint2 p;
+        int            hp;
+
+        bool operator==(result_t const& other) const noexcept {
+            return id == other.id && p == other.p && hp == other.hp;
+        }
+    };
+
+    // a crowded room of creatures of two speeds, so that they bump into each other and act at
+    // several different times in a turn
+    auto const run = [](size_t const workers, size_t const min_round) {
+        bkrl::random_state        random;
+        bkrl::creature_dictionary dic;
+        bkrl::definitions         defs {&dic, nullptr, nullptr};
+        bkrl::creature_factory    cfactory;
+        bkrl::item_factory        ifactory;
+        bkrl::output              out;
+        bkrl::context             ctx {random, defs, out, ifactory, cfactory};
+
+        bkrl::creature_def fast {"fast"};
+        fast.speed   = 150;
+        fast.stat_hp = bkrl::make_random_integer("1000"); // keep fighting without dying
+
+        bkrl::creature_def slow {"slow"};
+        slow.stat_hp = fast.stat_hp;
+
+        dic.insert_or_discard(fast);
+        dic.insert_or_discard(slow);
+
+        bkrl::map map;
+        map.set_worker_count(workers, min_round);
+
+        bklib::irect const room {10, 10, 40, 40};
+        map.fill(room, bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+        for (int i = 0; i < 400; ++i) {
+            generate_creature(ctx, map, (i % 2) ? fast : slow
+              , bklib::ipoint2 {room.left + 1 + i % 20, room.top + 1 + i / 20});
+        }
+
+        for (int i = 0; i < 20; ++i) {
+            map.advance(ctx);
+        }
+
+        std::vector<result_t> result;
+        map.for_each_creature_in(room, [&](bkrl::creature const& c) {
+            result.push_back(result_t {static_cast<uint32_t>(c.id()), c.position()
+              , c.current(bkrl::stat_type::health)});
+        });
+
+        std::sort(begin(result), end(result), [](result_t const& a, result_t const& b) {
+            return a.id < b.id;
+        });
+
+        return result;
+    };
+
+    auto const serial = run(0, bkrl::min_split_round);
+    REQUIRE(serial.size() == 400u);
+
+    // every round split up, however small
+    REQUIRE(run(1, 1) == serial);
+    REQUIRE(run(3, 1) == serial);
+
+    // some rounds split up, and some not
+    REQUIRE(run(3, 150) == serial);
+}
+
 TEST_CASE("map items", "[map][item][bkrl]") {
     bkrl::random_state     random;
     bkrl::creature_factory cfactory;
@@ -158,6 +671,107 @@ TEST_CASE("map items", "[map][item][bkrl]") {
         REQUIRE(it->def() == get_id(idef1));
         REQUIRE((++it)->def() == get_id(idef0));
     }
+
+    SECTION("batched placement") {
+        bklib::ipoint2 const points[] {{10, 10}, {12, 10}, {10, 10}, {14, 3}};
+        for (auto const p : points) {
+            map.at(p).type = bkrl::terrain_type::floor;
+        }
+
+        map.begin_batch();
+
+        for (auto const p : points) {
+            REQUIRE(generate_item(ctx, map, idef0, p));
+            REQUIRE(map.items_at(p));
+        }
+
+        // removal part way through a batch merges the pending updates first
+        map.remove_items_at(points[1]);
+        REQUIRE(!map.items_at(points[1]));
+
+        REQUIRE(generate_item(ctx, map, idef1, points[1]));
+
+        map.end_batch();
+
+        REQUIRE(std::distance(map.items_at(points[0])->begin(), map.items_at(points[0])->end()) == 2);
+        require_at(map, points[1], idef1);
+        require_at(map, points[3], idef0);
+    }
+}
+
+TEST_CASE("map paging creatures and items", "[map][creature][item][bkrl]") {
+    bkrl::random_state        random;
+    bkrl::creature_dictionary cdefs;
+    bkrl::item_dictionary     idefs;
+    bkrl::definitions         defs {&cdefs, &idefs, nullptr};
+    bkrl::creature_factory    cfactory;
+    bkrl::item_factory        ifactory;
+    bkrl::output              out;
+    bkrl::context             ctx {random, defs, out, ifactory, cfactory};
+
+    bkrl::creature_def const cdef {"test"};
+    cdefs.insert_or_discard(cdef);
+
+    bkrl::item_def idef {"helmet"};
+    idef.tags.push_back(bkrl::make_tag("EQS_HEAD"));
+    idef.tags.push_back(bkrl::make_tag("CAT_ARMOR"));
+    bkrl::process_tags(idef);
+    idefs.insert_or_discard(idef);
+
+    constexpr int size = static_cast<int>(bkrl::size_chunk);
+
+    bkrl::map map {bklib::irect {0, 0, 4 * size, size}};
+    auto const& cmap = map;
+
+    // a single chunk of each
+    map.enable_paging("bkxp_map_test.tmp", 1);
+
+    // walled in, so that it stays put
+    bklib::ipoint2 const p {5, 5};
+    map.fill(bklib::irect {4, 4, 7, 7}, bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+    bklib::ipoint2 const q {10, 5};
+    map.at(q).type = bkrl::terrain_type::floor;
+
+    auto const count_items = [](bkrl::creature const& c) {
+        return std::distance(c.item_list().begin(), c.item_list().end());
+    };
+
+    REQUIRE(generate_creature(ctx, map, cdef, p));
+    auto const id = map.creature_at(p)->id();
+    {
+        auto& c = *map.creature_at(p);
+        c.get_item(ifactory.create(random[bkrl::random_stream::substantive], idefs, idef));
+        REQUIRE(!!c.equip_item(0));
+    }
+
+    auto const held = count_items(*map.creature_at(p));
+
+    REQUIRE(generate_item(ctx, map, idef, q));
+    REQUIRE(generate_item(ctx, map, idef, q));
+
+    // page the chunk out; its creatures and items follow at the start of the next turn
+    map.at(2 * size, 0).type = bkrl::terrain_type::floor;
+    REQUIRE(map.creature_at(p));
+
+    map.advance(ctx);
+    REQUIRE(!map.creature_at(p));
+    REQUIRE(!map.items_at(q));
+
+    // and back in
+    REQUIRE(cmap.at(p).type == bkrl::terrain_type::floor);
+    map.advance(ctx);
+
+    auto const c = map.creature_at(p);
+    REQUIRE(c);
+    REQUIRE(c->id() == id);
+    REQUIRE(count_items(*c) == held);
+    REQUIRE(c->equip_list().is_equipped(*c->item_list().begin()));
+
+    auto const pile = map.items_at(q);
+    REQUIRE(pile);
+    REQUIRE(std::distance(pile->begin(), pile->end()) == 2);
+    require_at(map, q, idef);
 }
 
 #endif // BK_NO_UNIT_TESTS
@@ -0,0 +1,261 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "benchmark.hpp"
+
+#include "color.hpp"
+#include "context.hpp"
+#include "distance_map.hpp"
+#include "map.hpp"
+#include "output.hpp"
+#include "path.hpp"
+
+#include "bklib/dictionary.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct level_t {
+    std::unique_ptr<bkrl::map> closed; //!< as generated
+    std::unique_ptr<bkrl::map> open;   //!< with every door open
+};
+
+//! Generate (BSP) levels, and a copy of each with every door open.
+std::vector<level_t> generate_levels(bkrl::context& ctx, int const n) {
+    std::vector<level_t> result;
+
+    for (int i = 0; i < n; ++i) {
+        level_t level;
+        level.closed = std::make_unique<bkrl::map>(ctx);
+
+        // a copy of the terrain, doors open
+        auto const& closed = *level.closed;
+        auto const  r      = closed.bounds();
+
+        level.open = std::make_unique<bkrl::map>(r);
+        for (int y = r.top; y < r.bottom; ++y) {
+            for (int x = r.left; x < r.right; ++x) {
+                auto const ter = closed.at(x, y);
+                level.open->at(x, y) = ter;
+
+                if (ter.type == bkrl::terrain_type::door) {
+                    bkrl::set_door_state(*level.open, bklib::ipoint2 {x, y}, bkrl::door::state::open);
+                }
+            }
+        }
+
+        result.push_back(std::move(level));
+    }
+
+    return result;
+}
+
+} //namespace
+
+//! Time paths between random passable cells of generated (BSP) levels, with plain A* and with jump
+//! point search over levels with every door open, and with A* opening the doors on the way.
+TEST_CASE("path finding on generated levels", "[.][benchmark][path][map]") {
+    constexpr int levels = 4;
+    constexpr int paths  = 500;
+
+    bkrl::random_state     random;
+    bkrl::color_dictionary colors;
+    bkrl::definitions      defs {nullptr, nullptr, &colors};
+    bkrl::creature_factory cfactory;
+    bkrl::item_factory     ifactory;
+    bkrl::output           out;
+    bkrl::context          ctx {random, defs, out, ifactory, cfactory};
+
+    using query_t = std::pair<bklib::ipoint2, bklib::ipoint2>;
+
+    auto const generated = generate_levels(ctx, levels);
+    std::vector<std::vector<query_t>> queries (levels);
+
+    auto& gen = random[bkrl::random_stream::substantive];
+    for (size_t i = 0; i < generated.size(); ++i) {
+        auto const& m = *generated[i].open;
+        while (queries[i].size() < static_cast<size_t>(paths)) {
+            auto const from = bkrl::random_point(gen, m.bounds());
+            auto const to   = bkrl::random_point(gen, m.bounds());
+            if (m.is_passable(from) && m.is_passable(to)) {
+                queries[i].push_back(query_t {from, to});
+            }
+        }
+    }
+
+    struct config_t {
+        char const* name;
+        bool        jump_points;
+        bool        open_doors;
+    };
+
+    config_t const configs[] {
+        {"A*, doors open",              false, false}
+      , {"jump points, doors open",     true,  false}
+      , {"A*, opening doors on the way", false, true}
+    };
+
+    bkrl::path_finder finder;
+    std::vector<bklib::ipoint2> path;
+
+    for (auto const& config : configs) {
+        bkrl::path_options options;
+        options.jump_points = config.jump_points;
+        options.open_doors  = config.open_doors;
+
+        size_t found    = 0;
+        size_t expanded = 0;
+
+        char name[96];
+        std::snprintf(name, sizeof(name), "path (%s)", config.name);
+
+        auto const ns = bench::run(name, levels * paths, [&](int const i) {
+            auto const  l     = static_cast<size_t>(i / paths);
+            auto const& level = generated[l];
+            auto const& q     = queries[l][static_cast<size_t>(i % paths)];
+            auto const& m     = config.open_doors ? *level.closed : *level.open;
+
+            found    += finder.find_path(m, q.first, q.second, path, options) ? 1u : 0u;
+            expanded += finder.expanded();
+        });
+
+        std::printf("  %.0f paths/s, %zu of %d found, %.1f cells expanded a path\n"
+          , ns > 0.0 ? 1.0e9 / ns : 0.0, found, levels * paths
+          , static_cast<double>(expanded) / (levels * paths));
+    }
+}
+
+//! Time keeping a distance map toward a player walking about generated (BSP) levels up to date:
+//! computed anew each step, and updated incrementally; then with doors being opened and closed
+//! instead.
+TEST_CASE("distance maps on generated levels", "[.][benchmark][path][map]") {
+    constexpr int levels = 4;
+    constexpr int steps  = 250;
+
+    bkrl::random_state     random;
+    bkrl::color_dictionary colors;
+    bkrl::definitions      defs {nullptr, nullptr, &colors};
+    bkrl::creature_factory cfactory;
+    bkrl::item_factory     ifactory;
+    bkrl::output           out;
+    bkrl::context          ctx {random, defs, out, ifactory, cfactory};
+
+    auto const generated = generate_levels(ctx, levels);
+
+    // a walk over each level, with every door open: keep going one way, turning now and then
+    auto& gen = random[bkrl::random_stream::substantive];
+    std::vector<std::vector<bklib::ipoint2>> walks (levels);
+    std::vector<std::vector<bklib::ipoint2>> doors (levels);
+
+    for (size_t i = 0; i < generated.size(); ++i) {
+        auto const& m = *generated[i].open;
+        auto const  r = m.bounds();
+
+        auto p = bkrl::random_point(gen, r);
+        while (!m.is_passable(p)) {
+            p = bkrl::random_point(gen, r);
+        }
+
+        bklib::ivec2 v {1, 0};
+        while (walks[i].size() < static_cast<size_t>(steps)) {
+            auto const to = p + v;
+            if (abs_max(v) == 0 || !intersects(r, to) || !m.is_passable(to)
+             || bkrl::x_in_y_chance(gen, 1, 8)
+            ) {
+                v = bklib::ivec2 {bkrl::random_range(gen, -1, 1), bkrl::random_range(gen, -1, 1)};
+                continue;
+            }
+
+            p = to;
+            walks[i].push_back(p);
+        }
+
+        for (int y = r.top; y < r.bottom; ++y) {
+            for (int x = r.left; x < r.right; ++x) {
+                if (m.at(x, y).type == bkrl::terrain_type::door) {
+                    doors[i].push_back(bklib::ipoint2 {x, y});
+                }
+            }
+        }
+    }
+
+    auto const report = [](double const ns, size_t const changed, int const n) {
+        std::printf("  %.0f updates/s, %.1f distances changed an update\n"
+          , ns > 0.0 ? 1.0e9 / ns : 0.0, static_cast<double>(changed) / n);
+    };
+
+    for (auto const range : {0, 32}) {
+        char name[96];
+
+        size_t changed = 0;
+        std::snprintf(name, sizeof(name), "distance map (range %d, anew each step)", range);
+        auto ns = bench::run(name, levels * steps, [&](int const i) {
+            auto const l = static_cast<size_t>(i / steps);
+
+            bkrl::distance_map field {range};
+            field.add_goal(walks[l][static_cast<size_t>(i % steps)]);
+            field.update(*generated[l].open);
+            changed += field.changed();
+        });
+        report(ns, changed, levels * steps);
+
+        changed = 0;
+        std::unique_ptr<bkrl::distance_map> field;
+        std::snprintf(name, sizeof(name), "distance map (range %d, incremental)", range);
+        ns = bench::run(name, levels * steps, [&](int const i) {
+            auto const  l    = static_cast<size_t>(i / steps);
+            auto const& walk = walks[l];
+            auto const  n    = static_cast<size_t>(i % steps);
+
+            if (n == 0) {
+                field = std::make_unique<bkrl::distance_map>(range);
+                field->add_goal(walk[n]);
+            } else {
+                field->move_goal(walk[n - 1], walk[n]);
+            }
+
+            field->update(*generated[l].open);
+            changed += field->changed();
+        });
+        report(ns, changed, levels * steps);
+    }
+
+    // doors on the closed levels, the player standing still
+    for (size_t l = 0; l < generated.size(); ++l) {
+        auto& m = *generated[l].closed;
+
+        bkrl::distance_map field;
+        field.add_goal(walks[l].front());
+        field.update(m);
+
+        auto const& ds = doors[l];
+        if (ds.empty()) {
+            continue;
+        }
+
+        size_t changed = 0;
+        char name[96];
+        std::snprintf(name, sizeof(name), "distance map (level %zu, a door opened or closed)", l);
+        auto const ns = bench::run(name, steps, [&](int const i) {
+            auto const p    = ds[static_cast<size_t>(i) % ds.size()];
+            auto const open = bkrl::door::state::open;
+            auto const shut = bkrl::door::state::closed;
+
+            bkrl::set_door_state(m, p, is_door(m.at(p), open) ? shut : open);
+            field.update(m);
+            changed += field.changed();
+        });
+        report(ns, changed, steps);
+    }
+}
+
+#endif // BK_NO_UNIT_TESTS
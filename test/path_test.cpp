@@ -0,0 +1,269 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "path.hpp"
+#include "map.hpp"
+#include "random.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+//! Whether @p path steps from @p from to @p to a neighbouring cell at a time, over cells that can
+//! be entered.
+bool is_valid_path(
+    bkrl::map const& m
+  , bklib::ipoint2 const from
+  , bklib::ipoint2 const to
+  , std::vector<bklib::ipoint2> const& path
+  , bool const open_doors = false
+) {
+    if (path.empty() || path.back() != to) {
+        return false;
+    }
+
+    auto p = from;
+    for (auto const q : path) {
+        auto const v = q - p;
+        if (abs_max(v) != 1) {
+            return false;
+        }
+
+        if (!m.is_passable(q) && !(open_doors && is_door(m.at(q), bkrl::door::state::closed))) {
+            return false;
+        }
+
+        p = q;
+    }
+
+    return true;
+}
+
+//! The cost of @p path in steps, with diagonal steps costing 1.4.
+double path_cost(bklib::ipoint2 const from, std::vector<bklib::ipoint2> const& path) {
+    double result = 0.0;
+
+    auto p = from;
+    for (auto const q : path) {
+        result += (x(q) != x(p) && y(q) != y(p)) ? 1.4 : 1.0;
+        p = q;
+    }
+
+    return result;
+}
+
+} //namespace
+
+TEST_CASE("path_finder", "[path][map][bkrl]") {
+    bkrl::map m {bklib::irect {0, 0, 20, 20}};
+    m.fill(m.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+    bkrl::path_finder finder;
+    std::vector<bklib::ipoint2> path;
+
+    bkrl::path_options a_star;
+    a_star.jump_points = false;
+
+    SECTION("straight and diagonal lines") {
+        for (auto const& options : {bkrl::path_options {}, a_star}) {
+            bklib::ipoint2 const from {2, 2};
+
+            REQUIRE(finder.find_path(m, from, bklib::ipoint2 {12, 2}, path, options));
+            REQUIRE(path.size() == 10u);
+            REQUIRE(is_valid_path(m, from, bklib::ipoint2 {12, 2}, path));
+
+            REQUIRE(finder.find_path(m, from, bklib::ipoint2 {10, 10}, path, options));
+            REQUIRE(path.size() == 8u);
+            REQUIRE(is_valid_path(m, from, bklib::ipoint2 {10, 10}, path));
+        }
+    }
+
+    SECTION("to the same cell") {
+        bklib::ipoint2 const p {5, 5};
+        REQUIRE(finder.find_path(m, p, p, path));
+        REQUIRE(path.empty());
+    }
+
+    SECTION("around a wall") {
+        m.fill(bklib::irect {10, 1, 11, 16}, bkrl::terrain_type::wall);
+
+        bklib::ipoint2 const from {5, 5};
+        bklib::ipoint2 const to   {15, 5};
+
+        REQUIRE(finder.find_path(m, from, to, path));
+        REQUIRE(is_valid_path(m, from, to, path));
+        auto const jump_cost = path_cost(from, path);
+
+        REQUIRE(finder.find_path(m, from, to, path, a_star));
+        REQUIRE(is_valid_path(m, from, to, path));
+        REQUIRE(path_cost(from, path) == Approx(jump_cost));
+
+        // down through the gap at the bottom and back up
+        REQUIRE(path.size() >= 2u * 11u);
+    }
+
+    SECTION("no path") {
+        m.fill(bklib::irect {10, 0, 11, 20}, bkrl::terrain_type::wall);
+
+        path.push_back(bklib::ipoint2 {1, 1});
+        REQUIRE(!finder.find_path(m, bklib::ipoint2 {5, 5}, bklib::ipoint2 {15, 5}, path));
+        REQUIRE(path.empty());
+
+        REQUIRE(!finder.find_path(m, bklib::ipoint2 {5, 5}, bklib::ipoint2 {15, 5}, path, a_star));
+        REQUIRE(!finder.find_path(m, bklib::ipoint2 {5, 5}, bklib::ipoint2 {0, 0}, path));
+        REQUIRE(!finder.find_path(m, bklib::ipoint2 {5, 5}, bklib::ipoint2 {30, 5}, path));
+    }
+
+    SECTION("too long") {
+        bkrl::path_options options;
+        options.max_length = 5;
+
+        REQUIRE(!finder.find_path(m, bklib::ipoint2 {2, 2}, bklib::ipoint2 {12, 2}, path, options));
+        REQUIRE(finder.find_path(m, bklib::ipoint2 {2, 2}, bklib::ipoint2 {7, 2}, path, options));
+    }
+
+    SECTION("doors") {
+        m.fill(bklib::irect {10, 0, 11, 20}, bkrl::terrain_type::wall);
+        bklib::ipoint2 const door {10, 10};
+        m.at(door).type = bkrl::terrain_type::door;
+
+        bklib::ipoint2 const from {5, 10};
+        bklib::ipoint2 const to   {15, 10};
+
+        // closed doors are walls unless they may be opened
+        REQUIRE(!finder.find_path(m, from, to, path));
+
+        bkrl::path_options options;
+        options.open_doors = true;
+        REQUIRE(finder.find_path(m, from, to, path, options));
+        REQUIRE(is_valid_path(m, from, to, path, true));
+        REQUIRE(std::find(begin(path), end(path), door) != end(path));
+
+        REQUIRE(bkrl::set_door_state(m, door, bkrl::door::state::open));
+        REQUIRE(finder.find_path(m, from, to, path));
+        REQUIRE(is_valid_path(m, from, to, path));
+    }
+
+    SECTION("maps of different sizes") {
+        bkrl::map big {bklib::irect {-40, -40, 40, 40}};
+        big.fill(big.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+        bklib::ipoint2 const from {-30, -30};
+        bklib::ipoint2 const to   {30, 20};
+
+        REQUIRE(finder.find_path(big, from, to, path));
+        REQUIRE(is_valid_path(big, from, to, path));
+        REQUIRE(path.size() == 60u);
+
+        REQUIRE(finder.find_path(m, bklib::ipoint2 {2, 2}, bklib::ipoint2 {12, 2}, path));
+        REQUIRE(path.size() == 10u);
+    }
+}
+
+TEST_CASE("path_finder window", "[path][map][bkrl]") {
+    // far too large for anything a cell of the bounds; untouched terrain is passable
+    constexpr int world = 1 << 20;
+    bkrl::map m {bklib::irect {-world / 2, -world / 2, world / 2, world / 2}};
+
+    bkrl::path_finder finder;
+    std::vector<bklib::ipoint2> path;
+
+    bkrl::path_options options;
+    options.max_length = 32;
+
+    bklib::ipoint2 const from {1000, -1000};
+    bklib::ipoint2 const to   {1020, -1000};
+
+    // a wall in the way, with a way around it within the limit
+    m.fill(bklib::irect {1010, -1010, 1011, -990}, bkrl::terrain_type::wall);
+
+    for (auto const jump : {true, false}) {
+        options.jump_points = jump;
+        REQUIRE(finder.find_path(m, from, to, path, options));
+        REQUIRE(is_valid_path(m, from, to, path));
+    }
+
+    // the way around is now too long
+    m.fill(bklib::irect {1010, -1040, 1011, -960}, bkrl::terrain_type::wall);
+    REQUIRE(!finder.find_path(m, from, to, path, options));
+
+    // and the goal too far away
+    REQUIRE(!finder.find_path(m, from, from + bklib::ivec2 {100, 0}, path, options));
+    REQUIRE(finder.expanded() == 0u);
+}
+
+TEST_CASE("path_finder jump point search", "[path][map][bkrl]") {
+    bkrl::random_t random;
+
+    bkrl::path_finder finder;
+    std::vector<bklib::ipoint2> path;
+
+    bkrl::path_options a_star;
+    a_star.jump_points = false;
+
+    // scattered walls and a few longer ones; the second map isn't aligned to blocks or to the 64
+    // cells read at a time, and has no walls around its edge
+    struct config_t {
+        bklib::irect bounds;
+        int          walls; //!< in 10
+    };
+
+    config_t const configs[] {
+        {bklib::irect {0, 0, 64, 64},      2}
+      , {bklib::irect {-37, -21, 93, 50},  3}
+    };
+
+    for (auto const& config : configs) {
+        auto const r = config.bounds;
+
+        bkrl::map m {r};
+        m.fill(r, bkrl::terrain_type::floor);
+
+        for (int y = r.top; y < r.bottom; ++y) {
+            for (int x = r.left; x < r.right; ++x) {
+                if (bkrl::x_in_y_chance(random, config.walls, 10)) {
+                    m.at(x, y).type = bkrl::terrain_type::wall;
+                }
+            }
+        }
+
+        for (int x = r.left + 8; x < r.right - 8; x += 12) {
+            m.fill(bklib::irect {x, r.top + 4, x + 1, r.bottom - 4}, bkrl::terrain_type::wall);
+        }
+
+        size_t expanded_jump   = 0;
+        size_t expanded_a_star = 0;
+        int    found           = 0;
+
+        for (int i = 0; i < 200; ++i) {
+            auto const from = bkrl::random_point(random, r);
+            auto const to   = bkrl::random_point(random, r);
+
+            auto const ok = finder.find_path(m, from, to, path, a_star);
+            auto const a_star_cost = path_cost(from, path);
+            expanded_a_star += finder.expanded();
+
+            // the same cost as A*, though not necessarily the same path
+            REQUIRE(finder.find_path(m, from, to, path) == ok);
+            REQUIRE(path_cost(from, path) == Approx(a_star_cost));
+            expanded_jump += finder.expanded();
+
+            if (ok && from != to) {
+                REQUIRE(is_valid_path(m, from, to, path));
+                ++found;
+            }
+        }
+
+        REQUIRE(found > 50);
+        REQUIRE(expanded_jump < expanded_a_star);
+    }
+}
+
+#endif // BK_NO_UNIT_TESTS
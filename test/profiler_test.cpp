@@ -0,0 +1,111 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "profiler.hpp"
+#include "recording_renderer.hpp"
+#include "text.hpp"
+
+#include <thread>
+
+TEST_CASE("profiler samples", "[profiler]") {
+    using bkrl::profile_id;
+
+    bkrl::profiler prof;
+
+    REQUIRE(prof.size(profile_id::draw_calls) == 0);
+    REQUIRE(prof.sample(profile_id::draw_calls, 0) == 0);
+    REQUIRE(prof.max(profile_id::draw_calls) == 0);
+    REQUIRE(prof.mean(profile_id::draw_calls) == 0);
+
+    SECTION("values accumulate until committed") {
+        prof.add(profile_id::draw_calls, 2);
+        prof.add(profile_id::draw_calls, 3);
+        REQUIRE(prof.size(profile_id::draw_calls) == 0);
+
+        prof.commit(profile_id::draw_calls);
+        REQUIRE(prof.size(profile_id::draw_calls) == 1);
+        REQUIRE(prof.sample(profile_id::draw_calls, 0) == 5);
+
+        prof.commit(profile_id::draw_calls);
+        REQUIRE(prof.sample(profile_id::draw_calls, 0) == 0);
+        REQUIRE(prof.sample(profile_id::draw_calls, 1) == 5);
+        REQUIRE(prof.max(profile_id::draw_calls) == 5);
+    }
+
+    SECTION("history is limited") {
+        auto const n = bkrl::profiler::history + 10;
+        for (size_t i = 1; i <= n; ++i) {
+            prof.add(profile_id::draw_calls, i);
+            prof.commit(profile_id::draw_calls);
+        }
+
+        REQUIRE(prof.size(profile_id::draw_calls) == bkrl::profiler::history);
+        REQUIRE(prof.sample(profile_id::draw_calls, 0) == n);
+        REQUIRE(prof.sample(profile_id::draw_calls, bkrl::profiler::history - 1) == 11);
+        REQUIRE(prof.sample(profile_id::draw_calls, bkrl::profiler::history) == 0);
+        REQUIRE(prof.max(profile_id::draw_calls) == n);
+        REQUIRE(prof.mean(profile_id::draw_calls) == (11 + n) / 2);
+    }
+}
+
+#if !defined(BK_NO_PROFILER)
+TEST_CASE("profile zones", "[profiler]") {
+    using namespace std::chrono_literals;
+    using bkrl::profile_id;
+
+    auto& prof = bkrl::profiler::get();
+    prof.commit(profile_id::turn);
+    prof.commit(profile_id::creatures);
+
+    {
+        BK_PROFILE_ZONE(turn);
+        BK_PROFILE_ZONE(creatures);
+        std::this_thread::sleep_for(5ms);
+    }
+
+    prof.commit(profile_id::turn);
+    prof.commit(profile_id::creatures);
+
+    // time in a nested zone isn't counted towards the outer one
+    auto const turn      = prof.sample(profile_id::turn, 0);
+    auto const creatures = prof.sample(profile_id::creatures, 0);
+
+    REQUIRE(creatures >= 5'000'000);
+    REQUIRE(turn < creatures);
+}
+#endif // BK_NO_PROFILER
+
+TEST_CASE("profiler overlay", "[profiler][render]") {
+    using bkrl::profile_id;
+
+    auto const text_render = bkrl::make_text_renderer();
+    auto const overlay     = bkrl::make_profiler_overlay(*text_render);
+    auto const render      = bkrl::make_recording_renderer(640, 480);
+
+    bkrl::profiler prof;
+    for (int i = 0; i < 10; ++i) {
+        prof.add(profile_id::frame, 1000);
+        prof.add(profile_id::turn, 1000);
+        prof.add(profile_id::creatures, 1000);
+        prof.commit(profile_id::frame);
+        prof.commit(profile_id::turn);
+        prof.commit(profile_id::creatures);
+    }
+
+    render->set_scale(2.0);
+    render->set_translation(3.0, 4.0);
+
+    overlay->draw(*render, prof);
+    REQUIRE(render->draw_calls() > 0);
+
+    // leaves the renderer's state as it found it
+    REQUIRE(render->get_scale() == (bklib::point_t<2, double> {2.0, 2.0}));
+    REQUIRE(render->get_translation() == (bklib::point_t<2, double> {3.0, 4.0}));
+}
+
+#endif // BK_NO_UNIT_TESTS
@@ -0,0 +1,183 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "recording_renderer.hpp"
+#include "map.hpp"
+#include "view.hpp"
+
+#include <algorithm>
+#include <vector>
+
+TEST_CASE("recording_renderer", "[render]") {
+    using type_t = bkrl::recording_renderer::command_t::type_t;
+    using rect_t = bkrl::renderer::rect_t;
+
+    constexpr int size = 32;
+    constexpr int tile_size = 4;
+
+    auto const render = bkrl::make_recording_renderer(size, size, tile_size, tile_size);
+    auto const pixel = [&](int const x, int const y) {
+        return render->framebuffer()[y * size + x];
+    };
+
+    auto const blue   = bkrl::make_color(0, 0, 255);
+    auto const green  = bkrl::make_color(0, 255, 0);
+    auto const yellow = bkrl::make_color(255, 255, 0);
+
+    render->clear();
+    render->draw_filled_rect(rect_t {0, 0, size, size}, blue);
+    render->set_clip_region(rect_t {0, 0, 8, 8});
+    render->draw_filled_rect(rect_t {0, 0, size, size}, green);
+    render->clear_clip_region();
+
+    SECTION("commands") {
+        render->draw_cell(2, 0, 1, yellow);
+
+        auto const& cmds = render->commands();
+        REQUIRE(cmds.size() == 5);
+        REQUIRE(render->draw_calls() == 3);
+
+        REQUIRE(cmds[1].type == type_t::clip);
+        REQUIRE(cmds[4].type == type_t::sprite);
+        REQUIRE(cmds[4].dst.x == 2 * tile_size);
+        REQUIRE(cmds[4].dst.w == tile_size);
+
+        render->clear();
+        REQUIRE(render->commands().empty());
+        REQUIRE(render->draw_calls() == 0);
+    }
+
+    SECTION("rasterize") {
+        render->draw_cell(2, 0, 1, yellow);
+        render->rasterize();
+
+        REQUIRE(pixel(0, 0)   == green);
+        REQUIRE(pixel(7, 7)   == green);
+        REQUIRE(pixel(8, 8)   == blue);
+        REQUIRE(pixel(8, 0)   == yellow);
+        REQUIRE(pixel(11, 3)  == yellow);
+        REQUIRE(pixel(12, 0)  == blue);
+    }
+
+    SECTION("scale and translation") {
+        render->set_scale(2.0);
+        render->set_translation(1.0, 1.0);
+        render->draw_cell(0, 0, 1, yellow);
+        render->rasterize();
+
+        REQUIRE(pixel(1, 1)   == yellow);
+        REQUIRE(pixel(8, 8)   == yellow);
+        REQUIRE(pixel(9, 9)   == blue);
+    }
+
+    SECTION("tile texture") {
+        // two tiles side by side; the second is grey
+        constexpr int tex_w = 2 * tile_size;
+        std::vector<bkrl::color4> texture (tex_w * tile_size, bkrl::make_color(255, 255, 255));
+        for (auto y = 0; y < tile_size; ++y) {
+            for (auto x = tile_size; x < tex_w; ++x) {
+                texture[y * tex_w + x] = bkrl::make_color(128, 128, 128);
+            }
+        }
+
+        render->set_tile_texture(tex_w, tile_size, texture.data());
+        render->draw_cell(4, 4, 1, bkrl::make_color(255, 0, 0));
+        render->rasterize();
+
+        REQUIRE(pixel(16, 16) == bkrl::make_color(128, 0, 0));
+    }
+}
+
+TEST_CASE("recording_renderer map", "[render][map]") {
+    using type_t = bkrl::recording_renderer::command_t::type_t;
+
+    constexpr int window_w  = 320;
+    constexpr int window_h  = 240;
+    constexpr int tile_size = 18;
+    constexpr int size      = static_cast<int>(bkrl::size_chunk);
+
+    auto const render = bkrl::make_recording_renderer(window_w, window_h, tile_size, tile_size);
+
+    bkrl::map map {bklib::irect {0, 0, size, size}};
+    map.fill(map.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+    auto const frame = [&](double const zoom) {
+        bkrl::view v {window_w, window_h, tile_size, tile_size};
+        v.zoom_to(zoom);
+        v.center_on_world(size / 2, size / 2);
+
+        auto const scale = v.get_zoom();
+        auto const trans = v.get_scroll();
+
+        render->clear();
+        render->clear_clip_region();
+        render->set_scale(x(scale), y(scale));
+        render->set_translation(x(trans), y(trans));
+
+        map.draw(*render, v);
+        render->present();
+        render->rasterize();
+    };
+
+    auto const count = [&](type_t const type) {
+        return std::count_if(begin(render->commands()), end(render->commands())
+          , [type](auto const& c) noexcept { return c.type == type; });
+    };
+
+    // the clear colour shouldn't be visible anywhere the map covers
+    auto const center = [&] {
+        return render->framebuffer()[(window_h / 2) * window_w + (window_w / 2)];
+    };
+
+    SECTION("blocks") {
+        frame(1.0);
+
+        REQUIRE(count(type_t::cells) > 0);
+        REQUIRE(count(type_t::texels) == 0);
+        REQUIRE(center() != bkrl::make_color(255, 0, 0));
+    }
+
+    SECTION("overview") {
+        frame(bkrl::view::zoom_min);
+
+        REQUIRE(count(type_t::cells) == 0);
+        REQUIRE(count(type_t::texels) > 0);
+        REQUIRE(center() != bkrl::make_color(255, 0, 0));
+    }
+}
+
+TEST_CASE("recording_renderer paged map", "[render][map]") {
+    using type_t = bkrl::recording_renderer::command_t::type_t;
+
+    constexpr int size   = static_cast<int>(bkrl::size_chunk);
+    constexpr int chunks = 4;
+
+    auto const render = bkrl::make_recording_renderer(16 * chunks, 16, 1, 1);
+
+    bkrl::map map {bklib::irect {0, 0, chunks * size, size}};
+    map.enable_paging("bkxp_recording_renderer_test.tmp", 1); // a single chunk of each
+    map.fill(map.bounds(), bkrl::terrain_type::floor);
+
+    // the overviews of chunks that have been paged out are rebuilt
+    for (auto i = 0; i < 2; ++i) {
+        render->clear();
+        map.draw_minimap(*render, bklib::irect {0, 0, 16 * chunks, 16});
+        render->rasterize();
+
+        auto const& cmds = render->commands();
+        REQUIRE(std::count_if(begin(cmds), end(cmds), [](auto const& c) noexcept {
+            return c.type == type_t::texels;
+        }) == chunks);
+
+        for (auto x = 8; x < 16 * chunks; x += 16) {
+            REQUIRE(render->framebuffer()[8 * render->width() + x] != bkrl::make_color(255, 0, 0));
+        }
+    }
+}
+
+#endif // BK_NO_UNIT_TESTS
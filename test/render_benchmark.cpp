@@ -0,0 +1,114 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "benchmark.hpp"
+
+#include "map.hpp"
+#include "message_log.hpp"
+#include "recording_renderer.hpp"
+#include "text.hpp"
+#include "view.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr int window_w  = 1024;
+constexpr int window_h  = 768;
+constexpr int tile_size = 18;
+constexpr int map_size  = 4 * static_cast<int>(bkrl::size_chunk);
+
+//! A scripted sequence of views: a pan across the map at the default zoom, then a zoom all the way
+//! out and back in.
+std::vector<bkrl::view> scripted_views() {
+    std::vector<bkrl::view> result;
+
+    auto const make_view = [](double const zoom, int const x, int const y) {
+        bkrl::view v {window_w, window_h, tile_size, tile_size};
+        v.zoom_to(zoom);
+        v.center_on_world(x, y);
+        return v;
+    };
+
+    for (auto x = 0; x < map_size; x += 4) {
+        result.push_back(make_view(1.0, x, map_size / 2));
+    }
+
+    constexpr int steps = 32;
+    auto const ratio = bkrl::view::zoom_max / bkrl::view::zoom_min;
+
+    for (auto i = 0; i <= 2 * steps; ++i) {
+        auto const t = (i <= steps ? i : 2 * steps - i) / static_cast<double>(steps);
+        auto const zoom = bkrl::view::zoom_max / std::pow(ratio, t);
+        result.push_back(make_view(zoom, map_size / 2, map_size / 2));
+    }
+
+    return result;
+}
+
+} //namespace
+
+//! Replay the frames of game::render (the map, then the message log) over scripted_views with the
+//! recording renderer; the game itself can't be constructed without a window.
+TEST_CASE("game frame", "[.][benchmark][render]") {
+    auto const render = bkrl::make_recording_renderer(window_w, window_h, tile_size, tile_size);
+    auto const text_render = bkrl::make_text_renderer();
+    auto const log = bkrl::make_message_log(*text_render);
+
+    for (auto i = 0; i < 20; ++i) {
+        log->println(bklib::utf8_string_view {"The quick brown fox jumps over the lazy dog."});
+    }
+
+    bkrl::map map {bklib::irect {0, 0, map_size, map_size}};
+    map.fill(map.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+    auto const views = scripted_views();
+    auto const n = static_cast<int>(views.size());
+
+    auto const frame = [&](bkrl::view const& v) {
+        auto const scale = v.get_zoom();
+        auto const trans = v.get_scroll();
+
+        render->clear();
+        render->clear_clip_region();
+        render->set_scale(x(scale), y(scale));
+        render->set_translation(x(trans), y(trans));
+
+        map.draw(*render, v);
+        log->draw(*render);
+
+        render->present();
+    };
+
+    auto const report = [&](char const* const name, bool const rasterize) {
+        size_t draw_calls = 0;
+        size_t commands   = 0;
+
+        bench::run(name, n, [&](int const i) {
+            frame(views[static_cast<size_t>(i)]);
+            if (rasterize) {
+                render->rasterize();
+            }
+
+            draw_calls += render->draw_calls();
+            commands   += render->commands().size();
+        });
+
+        std::printf("%-48s %12.1f draw calls/frame  %.1f commands/frame\n", ""
+          , static_cast<double>(draw_calls) / n, static_cast<double>(commands) / n);
+    };
+
+    // the first pass over the views also fills the caches
+    report("game frame (record, cold caches)", false);
+    report("game frame (record)", false);
+    report("game frame (record and rasterize)", true);
+}
+
+#endif // BK_NO_UNIT_TESTS
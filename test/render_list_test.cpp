@@ -0,0 +1,100 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "render_list.hpp"
+#include "recording_renderer.hpp"
+#include "map.hpp"
+#include "view.hpp"
+
+#include <algorithm>
+
+namespace {
+
+bool operator==(bkrl::renderer::rect_t const& a, bkrl::renderer::rect_t const& b) noexcept {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+bool same_commands(bkrl::recording_renderer const& a, bkrl::recording_renderer const& b) {
+    using command_t = bkrl::recording_renderer::command_t;
+
+    return std::equal(begin(a.commands()), end(a.commands()), begin(b.commands()), end(b.commands())
+      , [](command_t const& x, command_t const& y) noexcept {
+            return x.type == y.type && x.color == y.color && x.dst == y.dst
+                && x.src_x == y.src_x && x.src_y == y.src_y;
+        });
+}
+
+} //namespace
+
+TEST_CASE("render_list replay", "[render]") {
+    constexpr int window_w  = 320;
+    constexpr int window_h  = 240;
+    constexpr int tile_size = 18;
+    constexpr int size      = static_cast<int>(bkrl::size_chunk);
+
+    auto const list     = bkrl::make_render_list();
+    auto const direct   = bkrl::make_recording_renderer(window_w, window_h, tile_size, tile_size);
+    auto const replayed = bkrl::make_recording_renderer(window_w, window_h, tile_size, tile_size);
+
+    bkrl::map map {bklib::irect {0, 0, size, size}};
+    map.fill(map.bounds(), bkrl::terrain_type::floor, bkrl::terrain_type::wall);
+
+    auto const frame = [&](bkrl::renderer& render, double const zoom) {
+        bkrl::view v {window_w, window_h, tile_size, tile_size};
+        v.zoom_to(zoom);
+        v.center_on_world(size / 2, size / 2);
+
+        auto const scale = v.get_zoom();
+        auto const trans = v.get_scroll();
+
+        render.clear();
+        render.clear_clip_region();
+        render.set_scale(x(scale), y(scale));
+        render.set_translation(x(trans), y(trans));
+
+        map.draw(render, v);
+        map.draw_minimap(render, bklib::irect {0, 0, 64, 64});
+
+        render.draw_filled_rect(bkrl::renderer::rect_t {10, 10, 20, 20}, bkrl::make_color(1, 2, 3));
+        render.draw_cell(1, 2, 3, bkrl::make_color(4, 5, 6));
+
+        render.present();
+    };
+
+    for (auto const zoom : {1.0, bkrl::view::zoom_min, 1.0}) {
+        list->reset();
+        frame(*list, zoom);
+        REQUIRE(list->size() > 0);
+
+        frame(*direct, zoom);
+
+        replayed->clear();
+        list->replay(*replayed);
+
+        REQUIRE(same_commands(*direct, *replayed));
+
+        direct->rasterize();
+        replayed->rasterize();
+
+        auto const n = static_cast<size_t>(window_w * window_h);
+        REQUIRE(std::equal(direct->framebuffer(), direct->framebuffer() + n, replayed->framebuffer()));
+    }
+
+    SECTION("replaying doesn't consume the list") {
+        replayed->clear();
+        list->replay(*replayed);
+        REQUIRE(same_commands(*direct, *replayed));
+    }
+
+    SECTION("reset") {
+        list->reset();
+        REQUIRE(list->size() == 0);
+    }
+}
+
+#endif // BK_NO_UNIT_TESTS
@@ -0,0 +1,77 @@
+#ifndef BK_NO_UNIT_TESTS
+#include <boost/predef.h>
+#if BOOST_COMP_CLANG
+#   pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+#include <catch/catch.hpp>
+
+#include "scheduler.hpp"
+
+#include <vector>
+
+TEST_CASE("turn_scheduler", "[scheduler][bkrl]") {
+    using bkrl::creature_handle;
+
+    bkrl::turn_scheduler s;
+    creature_handle h;
+
+    REQUIRE(s.empty());
+    REQUIRE(s.now() == 0);
+
+    SECTION("nothing due") {
+        REQUIRE_FALSE(s.next(100, h));
+        REQUIRE(s.now() == 100);
+    }
+
+    SECTION("earliest first; ties in the order scheduled") {
+        s.schedule(creature_handle {1}, 300);
+        s.schedule(creature_handle {2}, 100);
+        s.schedule(creature_handle {3}, 200);
+        s.schedule(creature_handle {4}, 100);
+        REQUIRE(s.size() == 4);
+
+        std::vector<uint32_t> order;
+        while (s.next(250, h)) {
+            order.push_back(static_cast<uint32_t>(h));
+        }
+
+        REQUIRE(order == (std::vector<uint32_t> {2, 4, 3}));
+        REQUIRE(s.now() == 250);
+        REQUIRE(s.size() == 1);
+
+        REQUIRE(s.next(300, h));
+        REQUIRE(static_cast<uint32_t>(h) == 1);
+        REQUIRE(s.now() == 300);
+        REQUIRE(s.empty());
+    }
+
+    SECTION("now advances as entries are taken") {
+        s.schedule(creature_handle {1}, 50);
+        REQUIRE(s.next(100, h));
+        REQUIRE(s.now() == 50);
+
+        // relative to the time of the action just taken
+        s.schedule_in(h, 25);
+        REQUIRE(s.next(100, h));
+        REQUIRE(s.now() == 75);
+    }
+}
+
+TEST_CASE("creature action time", "[scheduler][creature][bkrl]") {
+    bkrl::random_t         random;
+    bkrl::creature_factory cfac;
+
+    auto const make = [&](int16_t const speed) {
+        bkrl::creature_def def {"test"};
+        def.speed = speed;
+        return cfac.create(random, def, bklib::ipoint2 {0, 0});
+    };
+
+    REQUIRE(make(bkrl::speed_normal).action_time(bkrl::ticks_per_turn) == bkrl::ticks_per_turn);
+    REQUIRE(make(200).action_time(bkrl::ticks_per_turn) == bkrl::ticks_per_turn / 2);
+    REQUIRE(make(50).action_time(bkrl::ticks_per_turn) == bkrl::ticks_per_turn * 2);
+    REQUIRE(make(30000).action_time(bkrl::ticks_per_turn) == 1);
+}
+
+#endif // BK_NO_UNIT_TESTS